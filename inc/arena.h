@@ -0,0 +1,282 @@
+/**
+ * \file arena.h
+ * Per-conversion memory arena.
+ *
+ * \copyright 2022 Numfum GmbH
+ */
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+/**
+ * \def O2B_ARENA_BLOCK
+ * Minimum size of each block the arena reserves (larger allocations get a
+ * block of their own size).
+ */
+#ifndef O2B_ARENA_BLOCK
+#define O2B_ARENA_BLOCK (16 * 1024 * 1024)
+#endif
+
+/**
+ * \def O2B_ARENA_LARGE
+ * Size from which the static \c Arena#allocate() and \c Arena#reallocate()
+ * bypass the arena for \c malloc(). Large allocations are mostly growing
+ * arrays (the loaders' and the vertex containers'), which the system can
+ * resize without copying and return once freed, whereas each step of their
+ * growth would otherwise stay reserved in the arena until \c Arena#reset().
+ */
+#ifndef O2B_ARENA_LARGE
+#define O2B_ARENA_LARGE (1024 * 1024)
+#endif
+
+/**
+ * \def O2B_ARENA_HUGE_PAGES
+ * Set to \c 1 to back the arena's blocks with (transparent) huge pages where
+ * supported (currently Linux only, where the blocks are mapped and advised
+ * as such, otherwise this is ignored).
+ */
+#ifndef O2B_ARENA_HUGE_PAGES
+#define O2B_ARENA_HUGE_PAGES 0
+#endif
+
+/**
+ * Bump allocator for everything a conversion allocates (the loaders, tangent
+ * generation, meshoptimizer, the vertex containers and the output buffer).
+ * The most recent allocation is freed or resized in-place, other frees are
+ * kept in per-size free lists for later allocations to reuse, with the arena
+ * being released in one go, or \c #reset() to be reused by the next
+ * conversion without returning its memory. Usage:
+ * \code
+ *	Arena arena;
+ *	while (...) {
+ *		{
+ *			Arena::Scope scope(arena);
+ *			convert(...);
+ *		}
+ *		arena.reset();
+ *	}
+ * \endcode
+ * The libraries and containers allocate with the static \c #allocate(),
+ * \c #reallocate() and \c #release(), using the thread's current arena (see
+ * \c Scope) or, if none is current (or the allocation is at least \c
+ * O2B_ARENA_LARGE), \c malloc() and \c free(). Each of their allocations
+ * records where it came from, so is always returned to its owner, no matter
+ * which arena is current when it's freed.
+ *
+ * \note Everything allocated whilst an arena is current needs freeing (or
+ * forgetting) before the arena is reset or destroyed. Allocations from the
+ * static functions must only be resized or freed by them (never by \c
+ * realloc() or \c free(), even when they came from \c malloc()).
+ */
+class Arena
+{
+public:
+	/**
+	 * Makes an arena the thread's current arena for the lifetime of the
+	 * scope, restoring the previous one afterwards.
+	 */
+	class Scope
+	{
+	public:
+		/**
+		 * Makes \a arena current.
+		 *
+		 * \param[in] arena arena to use for the thread's allocations
+		 */
+		explicit Scope(Arena& arena);
+		/**
+		 * Restores the previous arena.
+		 */
+		~Scope();
+	private:
+		Scope         (const Scope&) = delete; /**< Not copyable   */
+		void operator=(const Scope&) = delete; /**< Not assignable */
+
+		Arena* prev; /**< Previously current arena (or \c null). */
+	};
+
+	/**
+	 * Creates an empty arena (reserving nothing until the first allocation).
+	 *
+	 * \param[in] hugePages \c true if the blocks should be backed by huge pages (see \c O2B_ARENA_HUGE_PAGES)
+	 */
+	explicit Arena(bool const hugePages = O2B_ARENA_HUGE_PAGES != 0);
+
+	/**
+	 * Releases all of the arena's blocks.
+	 */
+	~Arena();
+
+	/**
+	 * Allocates from the arena (aligned for any type), reusing a freed
+	 * allocation if one is large enough.
+	 *
+	 * \param[in] size number of bytes to allocate
+	 * \return start of the allocation (or \c null if no block could be reserved)
+	 */
+	void* alloc(size_t const size);
+
+	/**
+	 * Resizes an allocation, in-place if it was the most recent or still
+	 * fits (otherwise by allocating, copying and freeing the original).
+	 *
+	 * \param[in] ptr previous allocation (or \c null to allocate)
+	 * \param[in] size new number of bytes
+	 * \return start of the resized allocation (or \c null if no block could be reserved)
+	 */
+	void* realloc(void* const ptr, size_t const size);
+
+	/**
+	 * Frees an allocation, returning the memory to the block if it was the
+	 * most recent allocation (otherwise adding it to the free lists).
+	 *
+	 * \param[in] ptr allocation to free
+	 */
+	void free(void* const ptr);
+
+	/**
+	 * Frees every allocation at once, keeping the memory for reuse. If more
+	 * than one block was needed they're replaced with a single block large
+	 * enough for them all.
+	 */
+	void reset();
+
+	/**
+	 * Tests whether an allocation was made from this arena.
+	 *
+	 * \param[in] ptr allocation to test
+	 * \return \c true if \a ptr is within one of the arena's blocks
+	 */
+	bool owns(const void* const ptr) const;
+
+	/**
+	 * Allocates from the thread's current arena (or with \c malloc() if
+	 * there is none, or \a size is at least \c O2B_ARENA_LARGE).
+	 *
+	 * \param[in] size number of bytes to allocate
+	 * \return start of the allocation (or \c null if allocation failed)
+	 */
+	static void* allocate(size_t size);
+
+	/**
+	 * Resizes an allocation from \c #allocate(), in its arena if that's the
+	 * thread's current arena (otherwise it's moved to the current arena),
+	 * or with \c realloc() if it came from \c malloc(). Arena allocations
+	 * growing to at least \c O2B_ARENA_LARGE are moved to \c malloc().
+	 *
+	 * \param[in] ptr previous allocation (or \c null to allocate)
+	 * \param[in] size new number of bytes
+	 * \return start of the resized allocation (or \c null if allocation failed)
+	 */
+	static void* reallocate(void* ptr, size_t size);
+
+	/**
+	 * Frees an allocation from \c #allocate(), returning it to its arena if
+	 * that's the thread's current arena, or with \c free() if it came from
+	 * \c malloc(). Allocations from any other arena (which may belong to
+	 * another thread) are left for that arena's \c #reset().
+	 *
+	 * \param[in] ptr allocation to free (\c null being ignored)
+	 */
+	static void release(void* ptr);
+
+private:
+	Arena         (const Arena&) = delete; /**< Not copyable   */
+	void operator=(const Arena&) = delete; /**< Not assignable */
+
+	/**
+	 * A single reserved block of memory.
+	 */
+	struct Block {
+		uint8_t* data; /**< Start of the block. */
+		size_t   size; /**< Size of the block in bytes. */
+		bool   mapped; /**< \c true if the block was mapped (otherwise \c malloc'd). */
+	};
+
+	/**
+	 * Reserves a new block (which becomes the one allocated from).
+	 *
+	 * \param[in] size minimum size of the block
+	 * \return \c true if the block was reserved
+	 */
+	bool addBlock(size_t const size);
+
+	/**
+	 * Returns every block to the system.
+	 */
+	void freeBlocks();
+
+	/**
+	 * Empties the free lists.
+	 */
+	void clearFreed();
+
+	/**
+	 * Number of free lists, one per power of two (the list for \c n holding
+	 * freed allocations of at least \c 2^n bytes).
+	 */
+	static size_t const FREE_LISTS = sizeof(size_t) * 8;
+
+	std::vector<Block> blocks; /**< Reserved blocks (allocating from the last). */
+	size_t used;               /**< Bytes used in the last block. */
+	uint8_t* last;             /**< Most recent allocation (which can be resized or freed in-place). */
+	uint8_t* freed[FREE_LISTS]; /**< Free lists by size (each linked through the allocations' content). */
+	bool hugePages;            /**< \c true if the blocks should be backed by huge pages. */
+};
+
+/**
+ * Standard library allocator using the thread's current \c Arena (see \c
+ * Arena#allocate()), for containers created during a conversion, e.g.:
+ * \code
+ *	std::vector<ObjVertex, ArenaAllocator<ObjVertex> > verts;
+ * \endcode
+ * \tparam T type being allocated
+ */
+template<typename T>
+struct ArenaAllocator
+{
+	typedef T value_type; /**< Type being allocated. */
+	/**
+	 * Creates the (stateless) allocator.
+	 */
+	ArenaAllocator() {}
+	/**
+	 * Rebinds from an allocator of another type.
+	 */
+	template<typename U>
+	ArenaAllocator(const ArenaAllocator<U>&) {}
+	/**
+	 * Allocates storage for \a n entries.
+	 *
+	 * \param[in] n number of entries
+	 * \return start of the storage
+	 */
+	T* allocate(size_t const n) {
+		return static_cast<T*>(Arena::allocate(n * sizeof(T)));
+	}
+	/**
+	 * Frees storage from \c #allocate().
+	 *
+	 * \param[in] ptr start of the storage
+	 */
+	void deallocate(T* const ptr, size_t) {
+		Arena::release(ptr);
+	}
+};
+
+/**
+ * Stateless allocators are always equal.
+ */
+template<typename T, typename U>
+bool operator ==(const ArenaAllocator<T>&, const ArenaAllocator<U>&) {
+	return true;
+}
+/**
+ * Stateless allocators are never unequal.
+ */
+template<typename T, typename U>
+bool operator !=(const ArenaAllocator<T>&, const ArenaAllocator<U>&) {
+	return false;
+}
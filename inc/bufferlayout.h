@@ -13,7 +13,10 @@ class ToolOptions;
 
 /**
  * Output buffer layout descriptor. What the interleaved offsets are, where
- * attributes are packed, etc., to be sent to the rendering API.
+ * attributes are packed, etc., to be sent to the rendering API. The attributes
+ * are either interleaved in a single stream or divided between several (see \c
+ * ToolOptions#Streams), each stream being written in its entirety before the
+ * next.
  */
 class BufferLayout
 {
@@ -32,13 +35,52 @@ public:
 
 	/**
 	 * Write a header describing the buffer layout. The number of bytes written
-	 * will vary, based on the chosen layout.
+	 * will vary, based on the chosen layout. With multiple streams each
+	 * attribute's stream is in the upper four bits of its ID, and the header
+	 * is followed by each stream's stride (as bytes, padded to a multiple of
+	 * four).
 	 *
 	 * \param[in] packer target for the layout description
 	 * \return \c VP_FAILED if the header could not be added to the packer
 	 */
 	VertexPacker::Failed writeHeader(VertexPacker& packer) const;
 
+	/**
+	 * Returns the number of bytes \c #writeHeader() will write.
+	 *
+	 * \return size of the layout header in bytes
+	 */
+	unsigned getHeaderSize() const;
+
+	/**
+	 * Returns the number of bytes between each complete vertex (the number
+	 * of bytes \c #writeVertex() will write for all streams).
+	 *
+	 * \return vertex stride in bytes
+	 */
+	unsigned getStride() const {
+		return stride;
+	}
+
+	/**
+	 * Returns the number of bytes between each vertex in a single stream.
+	 *
+	 * \param[in] stream index of the stream (from \c 0 to \c #getStreams() \c - \c 1)
+	 * \return the stream's stride in bytes
+	 */
+	unsigned getStride(unsigned const stream) const {
+		return (stream < streams) ? strides[stream] : 0;
+	}
+
+	/**
+	 * Returns the number of vertex streams (\c 1 if interleaved).
+	 *
+	 * \return number of streams
+	 */
+	unsigned getStreams() const {
+		return streams;
+	}
+
 	/**
 	 * Write a single \a vertex to the \a packer using this buffer layout (all
 	 * vertices will be written with the same layout).
@@ -46,9 +88,10 @@ public:
 	 * \param[in] packer target for the packed vertex
 	 * \param[in] vertex data to write
 	 * \param[in] base offset from where vertex writing starts (see \c VertexPacker#align() )
+	 * \param[in] stream only write the attributes in this stream (or \c -1 for all of them)
 	 * \return \c VP_FAILED if adding to \a packer failed
 	 */
-	VertexPacker::Failed writeVertex(VertexPacker& packer, const ObjVertex& vertex, size_t const base = 0) const;
+	VertexPacker::Failed writeVertex(VertexPacker& packer, const ObjVertex& vertex, size_t const base = 0, int const stream = -1) const;
 
 private:
 	BufferLayout  (const BufferLayout&) = delete; /**< Not copyable   */
@@ -59,7 +102,9 @@ private:
 	 * components are packed, as would be the case for a second UV channel or
 	 * encoded tangents, this marks the first entry.
 	 *
-	 * \note Currently only the tangents and bitangent sign are packed.
+	 * \note Currently only the tangents and bitangent sign are packed. With
+	 * the packed \c 10_10_10_2 types the sign can also occupy an otherwise
+	 * unused component.
 	 */
 	enum Packing {
 		PACK_NONE   = 0, /**< No packing, either the component isn't used or there was no space. */
@@ -93,6 +138,8 @@ private:
 		VERT_NORM_ID = 3, /**< Vertex normals. */
 		VERT_TANS_ID = 4, /**< Vertex tangents. */
 		VERT_BTAN_ID = 5, /**< Vertex bitangents. */
+		VERT_RGBA_ID = 6, /**< Vertex colours. */
+		VERT_QTAN_ID = 7, /**< Vertex QTangents (replacing the normals, tangents and bitangents). */
 	};
 
 	/**
@@ -114,10 +161,11 @@ private:
 		 * components are packed).
 		 *
 		 * \param[in] attrType storage type
-		 * \param[in] startOff offset to the start of the components
+		 * \param[in] startOff offset to the start of the components (in its stream)
 		 * \param[in] numComps number of components
+		 * \param[in] attrStream index of the stream containing the attribute
 		 */
-		void fill(VertexPacker::Storage const attrType, unsigned const startOff, unsigned const numComps);
+		void fill(VertexPacker::Storage const attrType, unsigned const startOff, unsigned const numComps, unsigned const attrStream = 0);
 
 		/**
 		 * Performs the test for whether this is \c #unaligned (it's non-trivial
@@ -125,6 +173,15 @@ private:
 		 */
 		void validate();
 
+		/**
+		 * Tests whether a packed \c #storage type has unused components for
+		 * \a numComps more (which is only ever the bitangent sign).
+		 *
+		 * \param[in] numComps number of components required
+		 * \return \c true if the components fit in the existing packed bytes
+		 */
+		bool hasSpare(int const numComps) const;
+
 		/**
 		 * Calculates the total number of storage bytes required (from the \c
 		 * #storage type and number of \c #components, then 4-byte aligned).
@@ -133,6 +190,17 @@ private:
 		 */
 		unsigned getAlignedSize() const;
 
+		/**
+		 * Returns the number of components as passed to the rendering API,
+		 * which is \c #components except for packed types (which always
+		 * declare all of theirs, e.g. \c 4 for \c 10_10_10_2).
+		 *
+		 * \return the attribute's component count
+		 */
+		unsigned getSize() const {
+			return (storage.isPacked()) ? storage.components() : components;
+		}
+
 		/**
 		 * Allows testing that this attribute's storage type has been set (and
 		 * isn't the default \c EXCLUDE).
@@ -141,10 +209,20 @@ private:
 			return storage;
 		}
 
+		/**
+		 * Tests whether this attribute is written as part of \a which stream.
+		 *
+		 * \param[in] which index of the stream (or \c -1 for all streams)
+		 * \return \c true if the attribute is used and in the stream
+		 */
+		bool in(int const which) const {
+			return storage && (which < 0 || static_cast<unsigned>(which) == stream);
+		}
+
 		/**
 		 * Prints the attribute to \c stdout (as a GL call).
 		 *
-		 * \param[in] stride bytes between each complete vertex
+		 * \param[in] stride bytes between each complete vertex (in the attribute's stream)
 		 * \param[in] name name to assign (a constant for the buffer index in GL)
 		 */
 		void dump(unsigned const stride, const char* name) const;
@@ -167,12 +245,18 @@ private:
 		VertexPacker::Storage storage;
 
 		/**
-		 * Offset to the first of the components in the interleaved buffer.
-		 * Once set this should \e not change (it's accumulated from the
-		 * previous attributes).
+		 * Offset to the first of the components in the interleaved buffer (or
+		 * its stream). Once set this should \e not change (it's accumulated
+		 * from the previous attributes).
 		 */
 		unsigned offset;
 
+		/**
+		 * Index of the stream containing the attribute (always \c 0 when
+		 * interleaved).
+		 */
+		unsigned stream;
+
 		/**
 		 * Number of components (e.g.: \c 2 for UVs). This starts off with an
 		 * initial size but may grow if other attributes are packed in the
@@ -210,6 +294,21 @@ private:
 	 */
 	static void tryPacking(Packing& what, AttrParams& attr, int const numComps, Packing const where, bool const force = false);
 
+	/**
+	 * Ends the current stream (if it has any attributes), recording its
+	 * stride, so subsequent attributes start a new stream.
+	 *
+	 * \param[in,out] offset size of the current stream so far (reset to zero if a new stream is started)
+	 */
+	void nextStream(unsigned& offset);
+
+	/**
+	 * Counts the attributes that will be written (those with storage).
+	 *
+	 * \return number of written attributes
+	 */
+	unsigned countAttrs() const;
+
 	Packing packTans; /**< Where the encoded tangents pair were packed. */
 	Packing packSign; /**< Where the single tangent sign was packed. */
 	AttrParams posn;  /**< Position attributes. */
@@ -218,5 +317,9 @@ private:
 	AttrParams norm;  /**< Normal attributes. */
 	AttrParams tans;  /**< Tangent attributes. */
 	AttrParams btan;  /**< Bitangent attributes. */
+	AttrParams rgba;  /**< Vertex colour attributes. */
+	AttrParams qtan;  /**< QTangent attributes. */
 	unsigned stride;  /**< Bytes between each complete vertex (total of all attributes). */
+	unsigned streams; /**< Number of vertex streams (\c 1 if interleaved). */
+	unsigned strides[VERT_QTAN_ID + 1]; /**< Bytes between each vertex in each stream. */
 };
@@ -0,0 +1,77 @@
+/**
+ * \file errorreport.h
+ * Quantisation error measurement.
+ *
+ * \copyright 2022 Numfum GmbH
+ */
+#pragma once
+
+#include <vector>
+
+#include "vertexpacker.h"
+
+struct ObjMesh;
+class ToolOptions;
+
+/**
+ * \def O2B_ERROR_THREADS
+ * Maximum number of threads measuring the errors (\c 0 uses the hardware's
+ * concurrency, \c 1 measures on the calling thread). Wasm builds aren't
+ * assumed to have threads.
+ */
+#ifndef O2B_ERROR_THREADS
+#ifdef __EMSCRIPTEN__
+#define O2B_ERROR_THREADS 1
+#else
+#define O2B_ERROR_THREADS 0
+#endif
+#endif
+
+/**
+ * Quantisation errors of each stored vertex attribute, comparing the values as
+ * the runtime would see them (stored then restored, including any encoding)
+ * with the source. Cheap enough to leave on in release builds, the vertices
+ * being divided between threads. Usage:
+ * \code
+ *	ErrorReport report;
+ *	report.measure(opts, mesh);
+ *	for (size_t n = 0; n < report.attrs.size(); n++) {
+ *		printf("%s: %g %s\n", report.attrs[n].name, report.attrs[n].max, report.attrs[n].units);
+ *	}
+ * \endcode
+ */
+class ErrorReport
+{
+public:
+	/**
+	 * Summary of one attribute's errors.
+	 */
+	struct Attr {
+		const char* name;           /**< Attribute name (e.g. \c norm). */
+		const char* units;          /**< Units of the errors (e.g. \c degrees). */
+		VertexPacker::Storage type; /**< Storage type. */
+		float mean;                 /**< Mean error. */
+		float p99;                  /**< 99th-percentile error. */
+		float max;                  /**< Maximum error. */
+	};
+
+	/**
+	 * Measures the errors of every stored attribute: positions relative to
+	 * the longest side of the mesh's bounds, UVs in texels (of a \c
+	 * ToolOptions#autoTexSize texture), normals, tangents and bitangents in
+	 * degrees, and colours in their \c 0 to \c 1 range.
+	 *
+	 * \note This is called after \c ObjMesh#normalise() (the positions being
+	 * compared in the mesh's units using its scale) but before any normal
+	 * encoding (which needs the unencoded normals and tangents).
+	 *
+	 * \param[in] opts tool options (the types and encoding)
+	 * \param[in] mesh mesh to measure
+	 */
+	void measure(const ToolOptions& opts, const ObjMesh& mesh);
+
+	/**
+	 * Measured attributes, in vertex layout order (empty until measured).
+	 */
+	std::vector<Attr> attrs;
+};
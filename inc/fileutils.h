@@ -1,11 +1,15 @@
 /**
  * \file fileutils.h
  * Helpers to save out binary data with various options (raw, as hex data, raw
- * with Zstandard compression, as hex data with Zstandard compression).
+ * with Zstandard compression, as hex data with Zstandard compression), plus
+ * reading, copying and hashing of files.
  */
 #pragma once
 
 #include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <vector>
 
 /**
  * Helper to write a buffer to a binary or text file with optional Zstandard
@@ -19,3 +23,215 @@
  * \return \c true if writing the requested number of bytes was successful
  */
 bool write(const char* const dstPath, const void* const data, size_t const size, const bool text = false, bool const zstd = false);
+
+/**
+ * Streamed equivalent of \c #write(), for writing a file in fixed-size chunks
+ * (bounding the memory needed, regardless of the total size). Usage:
+ * \code
+ *	StreamWriter stream;
+ *	if (stream.open(dstPath, totalSize, text, zstd)) {
+ *		while (...) {
+ *			stream.write(chunk, chunkSize);
+ *		}
+ *	}
+ *	bool written = stream.close();
+ * \endcode
+ * \note Only one stream per thread may be compressing at a time (since they
+ * share the thread's Zstandard context).
+ */
+class StreamWriter
+{
+public:
+	/**
+	 * Creates an unopened stream.
+	 */
+	StreamWriter();
+
+	/**
+	 * Closes the stream (if still open).
+	 */
+	~StreamWriter();
+
+	/**
+	 * Opens the destination for writing.
+	 *
+	 * \param[in] dstPath filename of the destination file
+	 * \param[in] size total number of bytes that will be written (stored in the Zstandard frame)
+	 * \param[in] text \c true if the file should be text containing hexadecimal bytes
+	 * \param[in] zstd \c true if the file should be compressed with Zstandard
+	 * \return \c true if the destination could be opened
+	 */
+	bool open(const char* const dstPath, size_t const size, bool const text = false, bool const zstd = false);
+
+	/**
+	 * Appends a chunk of data.
+	 *
+	 * \param[in] data start of the raw data
+	 * \param[in] size number of bytes to write
+	 * \return \c true if the data were written (or compressed)
+	 */
+	bool write(const void* const data, size_t const size);
+
+	/**
+	 * Flushes any pending data and closes the destination.
+	 *
+	 * \return \c true if every write was successful (and the expected number of bytes were written)
+	 */
+	bool close();
+
+private:
+	StreamWriter  (const StreamWriter&) = delete; /**< Not copyable   */
+	void operator=(const StreamWriter&) = delete; /**< Not assignable */
+
+	/**
+	 * Writes the final bytes (raw or as text) to the file.
+	 *
+	 * \param[in] data start of the bytes to write
+	 * \param[in] size number of bytes to write
+	 * \return \c true if the bytes were written
+	 */
+	bool emit(const void* const data, size_t const size);
+
+	FILE*  file;  /**< Destination file (or \c null if not open). */
+	size_t total; /**< Number of raw bytes expected. */
+	size_t added; /**< Number of raw bytes added so far. */
+	size_t count; /**< Number of bytes emitted to the file (for text wrapping). */
+	bool   text;  /**< \c true if the file is text containing hexadecimal bytes. */
+	bool   zstd;  /**< \c true if the data are compressed. */
+	bool   valid; /**< \c false once any write has failed. */
+};
+
+/**
+ * Sets the Zstandard dictionary to use for all subsequent compressed \c
+ * #write() calls (until set again). Files written with a dictionary need the
+ * same dictionary to decompress.
+ *
+ * \param[in] dictPath filename of a dictionary created with \c #train() (or \c null to clear any dictionary)
+ * \return \c true if the dictionary was loaded (or cleared)
+ */
+bool setDictionary(const char* const dictPath);
+
+/**
+ * Trains a Zstandard dictionary from a corpus of sample files (e.g. packed
+ * buffers written without compression). Many small files sharing the same
+ * layout compress considerably better with a shared dictionary.
+ *
+ * \param[in] dictPath filename of the destination dictionary
+ * \param[in] srcPaths filenames of the samples
+ * \param[in] count number of entries in \a srcPaths
+ * \return \c true if training was successful and the dictionary written
+ */
+bool train(const char* const dictPath, const char* const* const srcPaths, size_t const count);
+
+/**
+ * Helper to read an entire file into memory.
+ *
+ * \param[in] srcPath filename of the source file
+ * \param[out] data destination for the file's content (resized to fit)
+ * \return \c true if the file was read in its entirety
+ */
+bool read(const char* const srcPath, std::vector<uint8_t>& data);
+
+/**
+ * Read-only view of an entire file, mapped into memory where supported
+ * (otherwise read into a buffer), so binary formats can be parsed in-place
+ * without first copying the content. Usage:
+ * \code
+ *	MappedFile file;
+ *	if (file.open(srcPath)) {
+ *		parse(file.data(), file.size());
+ *	}
+ * \endcode
+ */
+class MappedFile
+{
+public:
+	/**
+	 * Creates an unopened file.
+	 */
+	MappedFile();
+
+	/**
+	 * Unmaps the file (if still open).
+	 */
+	~MappedFile();
+
+	/**
+	 * Maps a file (closing any previous file).
+	 *
+	 * \param[in] srcPath filename of the source file
+	 * \return \c true if the file's entire content is available
+	 */
+	bool open(const char* const srcPath);
+
+	/**
+	 * Unmaps the file, invalidating any pointers into its content.
+	 */
+	void close();
+
+	/**
+	 * Start of the file's content (or \c null if not open or empty).
+	 */
+	const uint8_t* data() const {
+		return head;
+	}
+
+	/**
+	 * Number of bytes in the file.
+	 */
+	size_t size() const {
+		return used;
+	}
+
+private:
+	MappedFile    (const MappedFile&) = delete; /**< Not copyable   */
+	void operator=(const MappedFile&) = delete; /**< Not assignable */
+
+	const uint8_t* head;       /**< Start of the content. */
+	size_t used;               /**< Number of bytes in the content. */
+	bool mapped;               /**< \c true if \c #head was mapped (otherwise it's \c #copy). */
+	std::vector<uint8_t> copy; /**< Fallback content read without mapping. */
+};
+
+/**
+ * Helper to write a buffer to a file via a uniquely named temporary, which is
+ * then renamed to the destination. A concurrent reader never sees a partially
+ * written destination, and concurrent writers of the same destination never
+ * share a temporary (so the last rename wins, with each file being whole).
+ *
+ * \param[in] dstPath filename of the destination file
+ * \param[in] data start of the raw data
+ * \param[in] size number of bytes to write
+ * \return \c true if the destination was replaced
+ */
+bool replace(const char* const dstPath, const void* const data, size_t const size);
+
+/**
+ * Helper to copy a file byte-for-byte. The destination is written with \c
+ * #replace(), so a concurrent reader never sees a partially written
+ * destination.
+ *
+ * \param[in] srcPath filename of the source file
+ * \param[in] dstPath filename of the destination file
+ * \return \c true if the copy was successful
+ */
+bool copy(const char* const srcPath, const char* const dstPath);
+
+/**
+ * Helper to test whether a file exists (and can be opened for reading).
+ *
+ * \param[in] path filename to test
+ * \return \c true if the file exists
+ */
+bool exists(const char* const path);
+
+/**
+ * Calculates a 64-bit non-cryptographic hash of a buffer (XXH64, chosen for
+ * speed when hashing large source files).
+ *
+ * \param[in] data start of the raw data
+ * \param[in] size number of bytes to hash
+ * \param[in] seed initial seed (allowing hashes to be chained)
+ * \return hash of the data
+ */
+uint64_t hash(const void* const data, size_t const size, uint64_t const seed = 0);
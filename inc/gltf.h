@@ -0,0 +1,164 @@
+/**
+ * \file gltf.h
+ * Minimal glTF 2.0 reader (binary \c .glb or \c .gltf with its buffers).
+ *
+ * \copyright 2022 Numfum GmbH
+ */
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "fileutils.h"
+
+/**
+ * The triangles of a glTF file's first mesh, read in-place from the file's
+ * buffers (the \c .glb binary chunk is used as mapped, with no copying or
+ * conversion until each value is read). Only the JSON is parsed, which is
+ * only the scene description, with the vertex data never being text. Usage:
+ * \code
+ *	GltfFile gltf;
+ *	if (gltf.open(srcPath)) {
+ *		for (size_t n = 0; n < gltf.prims.size(); n++) {
+ *			float x = gltf.prims[n].posn.get(0, 0);
+ *		}
+ *	}
+ * \endcode
+ * \note Node transforms, morph targets, skins and sparse accessors are
+ * ignored (as are the materials, and anything else that isn't the mesh).
+ * Meshes compressed with Draco or meshoptimizer aren't supported.
+ */
+class GltfFile
+{
+public:
+	/**
+	 * Accessor component types (glTF's \c componentType).
+	 */
+	enum ComponentType {
+		BYTE   = 5120, /**< Signed 8-bit. */
+		UBYTE  = 5121, /**< Unsigned 8-bit. */
+		SHORT  = 5122, /**< Signed 16-bit. */
+		USHORT = 5123, /**< Unsigned 16-bit. */
+		UINT   = 5125, /**< Unsigned 32-bit (indices only). */
+		FLOAT  = 5126, /**< 32-bit float. */
+	};
+
+	/**
+	 * Primitive modes (glTF's \c mode, of which only triangles are read).
+	 */
+	enum Mode {
+		TRIANGLES      = 4, /**< Triangle list. */
+		TRIANGLE_STRIP = 5, /**< Triangle strip. */
+		TRIANGLE_FAN   = 6, /**< Triangle fan. */
+	};
+
+	/**
+	 * A buffer's content (in the mapped file or one of the owned buffers).
+	 */
+	struct Buffer {
+		const uint8_t* data; /**< Start of the buffer. */
+		size_t size;         /**< Number of bytes in the buffer. */
+	};
+
+	/**
+	 * Typed view of one vertex attribute (or the indices) in a buffer.
+	 */
+	struct Accessor {
+		const uint8_t* data; /**< Start of the first element (or \c null if the attribute is missing). */
+		size_t count;        /**< Number of elements. */
+		size_t stride;       /**< Bytes between the start of each element. */
+		unsigned compType;   /**< Component type (see \c ComponentType). */
+		unsigned comps;      /**< Number of components per element (\c 1 to \c 4). */
+		bool normalized;     /**< \c true if integer components are normalised to \c 0 to \c 1 (or \c -1 to \c 1 if signed). */
+
+		/**
+		 * Tests whether the accessor exists.
+		 */
+		bool valid() const {
+			return data != nullptr;
+		}
+
+		/**
+		 * Reads a single component as a float (normalising integer types if
+		 * \c #normalized, otherwise the integer's value).
+		 *
+		 * \param[in] idx element to read (less than \c #count)
+		 * \param[in] comp component to read (less than \c #comps)
+		 * \return the component's value
+		 */
+		float get(size_t const idx, unsigned const comp) const;
+
+		/**
+		 * Reads an element as an unsigned integer (for the indices).
+		 *
+		 * \param[in] idx element to read (less than \c #count)
+		 * \return the element's value
+		 */
+		uint32_t index(size_t const idx) const;
+	};
+
+	/**
+	 * A mesh primitive's attributes (those not present having a \c null \c
+	 * Accessor#data). Every attribute has at least as many elements as \c
+	 * #posn, and every index is within \c #posn.
+	 */
+	struct Primitive {
+		Accessor posn;  /**< \c POSITION (three components). */
+		Accessor norm;  /**< \c NORMAL (three components). */
+		Accessor tex0;  /**< \c TEXCOORD_0 (two components). */
+		Accessor tex1;  /**< \c TEXCOORD_1 (two components). */
+		Accessor rgba;  /**< \c COLOR_0 (three or four components). */
+		Accessor tans;  /**< \c TANGENT (four components, \c w being the bitangent sign). */
+		Accessor index; /**< Indices (one component). */
+		unsigned mode;  /**< Primitive mode (see \c Mode). */
+	};
+
+	/**
+	 * Opens a \c .glb or \c .gltf file (with any external \c .bin buffers
+	 * relative to it), finding the first mesh with triangles.
+	 *
+	 * \note Any previous content is released.
+	 *
+	 * \param[in] srcPath filename of the glTF file
+	 * \return \c true if the file was valid and \c #prims has the mesh's triangle primitives
+	 */
+	bool open(const char* const srcPath);
+
+	/**
+	 * Lists the external buffer files a \c .glb or \c .gltf file references
+	 * (resolved relative to it, as \c #open() would), without reading them.
+	 *
+	 * \param[in] srcPath filename of the glTF file
+	 * \param[out] paths destination for each external buffer's path (emptied first)
+	 * \return \c true if the file's JSON could be read
+	 */
+	static bool externalPaths(const char* const srcPath, std::vector<std::string>& paths);
+
+	/**
+	 * Triangle primitives of the first mesh (pointing into the file's buffers,
+	 * so only valid until the next \c #open() or the file's destruction).
+	 */
+	std::vector<Primitive> prims;
+
+private:
+	/**
+	 * Parses the JSON scene description, resolving the buffers then reading
+	 * the first mesh with triangles.
+	 *
+	 * \param[in] json start of the JSON text
+	 * \param[in] size number of bytes of JSON
+	 * \param[in] srcPath filename of the glTF file (for relative buffer URIs)
+	 * \param[in] bin start of the \c .glb binary chunk (or \c null if there is none)
+	 * \param[in] binSize number of bytes in the binary chunk
+	 * \return \c true if the JSON was valid and at least one primitive was found
+	 */
+	bool parse(const char* const json, size_t const size, const char* const srcPath, const uint8_t* const bin, size_t const binSize);
+
+	MappedFile file;                                 /**< The \c .glb or \c .gltf file. */
+	std::vector<std::unique_ptr<MappedFile> > bins;  /**< External buffer files. */
+	std::vector<std::vector<uint8_t> > decoded;      /**< Buffers decoded from base64 data URIs. */
+	std::vector<Buffer> buffers;                     /**< Each of the glTF's buffers. */
+};
@@ -0,0 +1,51 @@
+/**
+ * \file meshcache.h
+ * Intermediate \c .o2bmesh files, storing a loaded and processed mesh so later
+ * conversions (differing only in how the mesh is encoded and packed) can skip
+ * loading the source, generating tangents and optimising.
+ *
+ * \copyright 2022 Numfum GmbH
+ */
+#pragma once
+
+#include <cstddef>
+
+struct ObjMesh;
+
+/**
+ * \def O2B_MESH_VERSION
+ * Version of the \c .o2bmesh format (stored in each file, with files of any
+ * other version being ignored). Bump whenever the stored \c ObjMesh state
+ * changes (or how it's produced, since it also forms part of the cache key).
+ */
+#ifndef O2B_MESH_VERSION
+#define O2B_MESH_VERSION 1
+#endif
+
+/**
+ * Writes the processed mesh (vertices, indices, LODs, chunks, shadow indices,
+ * meshlets, and scale/bias) as an \c .o2bmesh file. The file is a fixed
+ * header followed by each array as its in-memory representation, 16-byte
+ * aligned, so reading is a validation then a copy per array (and the file
+ * can be mapped and used in-place by other tools). It's only intended to be
+ * read back by the same build, so is native endian and any difference in the
+ * structure sizes makes it invalid.
+ *
+ * \note The file is written to a unique temporary then renamed (see \c #replace()).
+ *
+ * \param[in] dstPath filename of the destination file
+ * \param[in] mesh processed mesh (before normalising or encoding)
+ * \param[in] numTris number of full detail triangles (which, after making strips, can't be recreated)
+ * \return \c true if the file was written
+ */
+bool writeMesh(const char* const dstPath, const ObjMesh& mesh, size_t const numTris);
+
+/**
+ * Reads a processed mesh previously written with \c #writeMesh().
+ *
+ * \param[in] srcPath filename of the \c .o2bmesh file
+ * \param[out] mesh destination for the processed mesh (reset first)
+ * \param[out] numTris destination for the number of full detail triangles
+ * \return \c true if the file exists and is valid for this build (otherwise \a mesh is empty)
+ */
+bool readMesh(const char* const srcPath, ObjMesh& mesh, size_t& numTris);
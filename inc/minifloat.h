@@ -134,6 +134,32 @@ namespace utils {
 		return (val & 0x7FFF) == 0x7C00;
 	}
 	//@}
+
+	//@{
+	/**
+	 * Converts a single-precision float to an unsigned 11- or 10-bit float,
+	 * as used by the packed \c R11G11B10F formats (a five bit exponent, with
+	 * the same bias as half-precision, and a six or five bit mantissa).
+	 * Negative values are stored as zero, finite values too large are stored
+	 * as the maximum finite value.
+	 *
+	 * \note This goes via half-precision, so may be rounded twice.
+	 *
+	 * \param[in] val single-precision float
+	 * \param[in] bits number of bits in the result (\c 11 or \c 10)
+	 * \return equivalent unsigned float (in the lower \a bits)
+	 */
+	uint16_t floatToUFloat(float const val, unsigned const bits);
+
+	/**
+	 * Converts an unsigned 11- or 10-bit float to single-precision.
+	 *
+	 * \param[in] val unsigned float (in the lower \a bits)
+	 * \param[in] bits number of bits in \a val (\c 11 or \c 10)
+	 * \return equivalent single-precision float
+	 */
+	float ufloatToFloat(uint16_t const val, unsigned const bits);
+	//@}
 };
 
 //*****************************************************************************/
@@ -19,6 +19,52 @@
 struct ObjMesh
 {
 public:
+	/**
+	 * Level of detail as a range of the index buffer (see \c #simplify()).
+	 */
+	struct Lod {
+		size_t first; /**< Offset of the LOD's first index. */
+		size_t count; /**< Number of indices in the LOD. */
+		float  error; /**< Simplification error, in the mesh's original units (\c 0 for the full detail). */
+	};
+
+	/**
+	 * Range of the index buffer drawn with its own base vertex (see \c
+	 * #split()). Indices in the range are relative to the base vertex.
+	 */
+	struct Chunk {
+		size_t first; /**< Offset of the chunk's first index. */
+		size_t count; /**< Number of indices in the chunk. */
+		size_t base;  /**< Offset of the chunk's first vertex (added to each index). */
+		size_t verts; /**< Number of vertices referenced by the chunk. */
+	};
+
+	/**
+	 * Meshlet descriptor and culling bounds (see \c #buildMeshlets()). The
+	 * meshlet's vertices are a range of \c #meshletVerts (each an index into
+	 * \c #verts) and its triangles a range of \c #meshletTris (each as three
+	 * bytes indexing the meshlet's vertices).
+	 */
+	struct Meshlet {
+		unsigned vertOffset; /**< Offset of the first entry in \c #meshletVerts. */
+		unsigned trisOffset; /**< Offset of the first byte in \c #meshletTris. */
+		unsigned vertCount;  /**< Number of vertices. */
+		unsigned trisCount;  /**< Number of triangles. */
+		vec4 sphere;         /**< Bounding sphere (centre in \c xyz, radius in \c w). */
+		vec3 coneApex;       /**< Normal cone apex. */
+		vec4 cone;           /**< Normal cone axis (in \c xyz) and cutoff (the cosine of the half angle, in \c w). */
+	};
+
+	/**
+	 * Mesh quality metrics for the full detail mesh (see \c #analyse()).
+	 */
+	struct Stats {
+		float acmr;      /**< Average cache miss ratio (transformed vertices per triangle, from \c 0.5 to \c 3, lower is better). */
+		float atvr;      /**< Average transformed vertex ratio (transformed vertices per vertex, with \c 1 being optimal). */
+		float overdraw;  /**< Shaded pixels per covered pixel (with \c 1 being optimal). */
+		float overfetch; /**< Fetched bytes per vertex buffer byte (with \c 1 being optimal). */
+	};
+
 	/**
 	 * Creates a zero-sized mesh (empty buffers, no scale or bias).
 	 */
@@ -33,16 +79,99 @@ public:
 
 	/**
 	 * Opens an \c .obj file and extracts its content (experimental support was
-	 * added for FBX files, extracting the first mesh found).
+	 * added for FBX files, extracting the first mesh found, for glTF \c .glb
+	 * or \c .gltf files, extracting the first mesh with triangles, and for
+	 * binary \c .ply files).
 	 *
 	 * \note Any existing content is replaced.
 	 *
-	 * \param[in] srcPath filename of the \c .obj or FBX file
+	 * \param[in] srcPath filename of the \c .obj, FBX, glTF or PLY file
 	 * \param[in] genTans \c true if tangents should be generated
 	 * \param[in] flipG generate tangents for a flipped green channel (by negating the texture's y-axis)
+	 * \param[in] uv2 \c true if the second UV channel is extracted (otherwise it's zeroed, so it doesn't prevent unused vertices merging)
 	 * \return \c true if the file was valid and \a mesh has its content
 	 */
-	bool load(const char* const srcPath, bool const genTans, bool const flipG);
+	bool load(const char* const srcPath, bool const genTans, bool const flipG, bool const uv2 = false);
+
+	/**
+	 * Lists the other files \c #load() would read for a source (currently
+	 * only a glTF file's external buffers), for anything keyed on the
+	 * source's content needing theirs too.
+	 *
+	 * \param[in] srcPath filename of the \c .obj, FBX, glTF or PLY file
+	 * \param[out] paths destination for the other files' paths (emptied first)
+	 * \return \c true if the other files could be listed (always, if there are none)
+	 */
+	static bool dependencies(const char* const srcPath, std::vector<std::string>& paths);
+
+	/**
+	 * Generates a chain of simplified LODs, appending each to the index buffer
+	 * (so all LODs share the same vertices). Each LOD is generated from the
+	 * full detail mesh, targeting a fraction of the previous LOD's index
+	 * count, and generation stops early if the simplifier can go no further
+	 * within the \a error limit.
+	 *
+	 * \note This should be called before \c #optimise(), which then optimises
+	 * each LOD individually.
+	 *
+	 * \param[in] count number of simplified LODs to generate (in addition to the full detail)
+	 * \param[in] ratio target index count of each LOD as a fraction of the previous
+	 * \param[in] error maximum error (relative to the mesh extents)
+	 * \param[in] sloppy \c true if the sloppy simplifier should be used (ignoring the topology)
+	 */
+	void simplify(unsigned const count, float const ratio, float const error, bool const sloppy);
+
+	/**
+	 * Partitions the full detail mesh into meshlets, each with its own bounds
+	 * and normal cone for culling.
+	 *
+	 * \note This should be called after \c #optimise() (so the meshlets
+	 * reference the final vertex order) and before \c #normalise() (so the
+	 * bounds are in the mesh's original units, matching the LOD errors).
+	 *
+	 * \param[in] maxVerts maximum vertices per meshlet (up to \c 255)
+	 * \param[in] maxTris maximum triangles per meshlet (up to \c 512, a multiple of \c 4)
+	 * \param[in] coneWeight weighting of the normal cones (\c 0 to \c 1)
+	 */
+	void buildMeshlets(unsigned const maxVerts, unsigned const maxTris, float const coneWeight);
+
+	/**
+	 * Splits the mesh into chunks, each referencing at most \a maxVerts
+	 * vertices (so they can be drawn with smaller indices and a base vertex).
+	 * Triangles are taken in order, starting a new chunk whenever the next
+	 * would exceed the limit, with the vertices each chunk needs copied in
+	 * first use order (so boundary vertices are duplicated, and each LOD has
+	 * its own vertices). Meshes already within the limit are left unchanged,
+	 * with a single chunk per LOD.
+	 *
+	 * \note This should be called after \c #optimise() and \c
+	 * #buildMeshlets() (whose vertices are remapped to match) but before \c
+	 * #stripify() (which then creates strips per chunk).
+	 *
+	 * \param[in] maxVerts maximum vertices per chunk (e.g. \c 65536 for 16-bit indices, or \c 65535 keeping \c 0xFFFF free for primitive restart)
+	 */
+	void split(size_t const maxVerts);
+
+	/**
+	 * Generates a shadow index buffer for the full detail mesh, where
+	 * vertices differing only in their non-position attributes are merged
+	 * (each index referencing the first vertex with the same position), for
+	 * depth-only passes.
+	 *
+	 * \note This should be called after \c #optimise() (so the indices
+	 * reference the final vertex order) then followed by \c
+	 * #optimiseShadow().
+	 */
+	void generateShadow();
+
+	/**
+	 * Reorders the shadow index buffer's triangles for the post-transform
+	 * vertex cache (independently of the main index buffer, since with fewer
+	 * unique vertices the best order differs).
+	 *
+	 * \param[in] cacheSize number of entries for a FIFO cache optimisation (or \c 0 for the default optimisation)
+	 */
+	void optimiseShadow(unsigned const cacheSize = 0);
 
 	/**
 	 * Run meshopt's various optimisation processes (namely vertex cache,
@@ -52,8 +181,65 @@ public:
 	 * load) and before quantisation, of which \c #normalise() could be
 	 * considered a form (though normalising with a uniform scale whilst
 	 * maintaining the mesh's own origin should barely alter the positions).
+	 *
+	 * \param[in] strips \c true if the vertex cache order should favour strips (see \c #stripify())
+	 */
+	void optimise(bool const strips = false);
+
+	/**
+	 * First step of \c #optimise(), reordering the triangles of each LOD for
+	 * the post-transform vertex cache.
+	 *
+	 * \param[in] strips \c true if the order should favour strips
+	 */
+	void optimiseVertexCache(bool const strips = false);
+
+	/**
+	 * Faster alternative to \c #optimiseVertexCache(), reordering the
+	 * triangles of each LOD for a FIFO cache of a known size (which is
+	 * quicker to run but generally less effective).
+	 *
+	 * \param[in] cacheSize number of entries in the FIFO cache
+	 */
+	void optimiseVertexCacheFifo(unsigned const cacheSize);
+
+	/**
+	 * Second step of \c #optimise(), reordering the triangles of each LOD to
+	 * reduce overdraw.
+	 *
+	 * \param[in] threshold how much worse the vertex cache may become (e.g. \c 1.01 allows a 1% worse ACMR)
+	 */
+	void optimiseOverdraw(float const threshold = 1.01f);
+
+	/**
+	 * Final step of \c #optimise(), reordering the vertices in the order the
+	 * indices first reference them (for the pre-transform vertex fetch).
+	 */
+	void optimiseVertexFetch();
+
+	/**
+	 * Measures the full detail mesh's vertex cache, overdraw and vertex fetch
+	 * efficiency (using meshopt's simplified models, so the results may not
+	 * match actual GPUs).
+	 *
+	 * \param[in] cacheSize number of entries in the simulated (FIFO) vertex cache
+	 * \param[in] vertexSize bytes per vertex for the vertex fetch (e.g. the packed stride)
+	 * \return the metrics (zeroed if the mesh is empty)
+	 */
+	Stats analyse(unsigned const cacheSize, unsigned const vertexSize) const;
+
+	/**
+	 * Converts the triangle list (each LOD, or each chunk if split,
+	 * individually) to triangle strips, joined with either a primitive
+	 * restart index or degenerate triangles. The LOD and chunk ranges are
+	 * updated to match.
+	 *
+	 * \note This should be called after \c #optimise() (ideally with \a
+	 * strips set) and after \c #buildMeshlets() (which needs the list).
+	 *
+	 * \param[in] restart primitive restart index (e.g. \c 0xFFFF for 16-bit indices) or \c 0 to join with degenerate triangles
 	 */
-	void optimise();
+	void stripify(unsigned const restart);
 
 	/**
 	 * Scale the mesh positions so that each is normalised between \c -1 and \c 1.
@@ -63,6 +249,32 @@ public:
 	 */
 	void normalise(bool const uniform, bool const unbiased);
 
+	/**
+	 * Measures the largest position error once stored as \a type, relative to
+	 * the longest side of the mesh's bounds (so \c 0.001 is 0.1% of the mesh
+	 * size). This is measured on the unscaled positions, so needs calling
+	 * before \c #normalise().
+	 *
+	 * \param[in] type storage type to measure
+	 * \param[in] scaled \c true if the positions would first be normalised (see \c #normalise() for this and the following)
+	 * \param[in] uniform \c true if the same scale would be applied to all axes
+	 * \param[in] unbiased \c true if the origin would be maintained at zero
+	 * \param[in] legacy see \c VertexPacker::Options#OPTS_SIGNED_LEGACY (default is modern encoding)
+	 * \return largest distance between a position and its stored equivalent (relative to the mesh size)
+	 */
+	float posnError(VertexPacker::Storage const type, bool const scaled, bool const uniform, bool const unbiased, bool const legacy = false) const;
+
+	/**
+	 * Measures the largest UV error once stored as \a type, in UV units
+	 * (multiplying by the texture size gives the error in texels).
+	 *
+	 * \param[in] type storage type to measure
+	 * \param[in] second \c true to measure the second UV channel (otherwise the first)
+	 * \param[in] legacy see \c VertexPacker::Options#OPTS_SIGNED_LEGACY (default is modern encoding)
+	 * \return largest per-component difference between a UV and its stored equivalent
+	 */
+	float texError(VertexPacker::Storage const type, bool const second, bool const legacy = false) const;
+
 	/**
 	 * Resizes the buffers (usually as a prelude to filling them).
 	 *
@@ -84,6 +296,35 @@ public:
 	 * Collection of indices into \c #verts.
 	 */
 	std::vector<unsigned> index;
+	/**
+	 * Index ranges of the LODs, starting with the full detail (empty if no
+	 * LODs were generated, with the whole of \c #index being the mesh).
+	 */
+	std::vector<Lod> lods;
+	/**
+	 * Index ranges of the chunks, in order and never spanning LODs (empty if
+	 * the mesh wasn't split).
+	 */
+	std::vector<Chunk> chunks;
+	/**
+	 * Shadow index buffer for the full detail mesh, as a triangle list of
+	 * indices into \c #verts (empty if not generated, see \c
+	 * #generateShadow()).
+	 */
+	std::vector<unsigned> shadow;
+	/**
+	 * Meshlets partitioning the full detail mesh (empty if not built).
+	 */
+	std::vector<Meshlet> meshlets;
+	/**
+	 * Meshlet vertices, as indices into \c #verts.
+	 */
+	std::vector<unsigned> meshletVerts;
+	/**
+	 * Meshlet triangles, as bytes indexing each meshlet's vertices (with each
+	 * meshlet's triangles padded to a multiple of four bytes).
+	 */
+	std::vector<uint8_t> meshletTris;
 	/**
 	 * Scale to apply to each vertex position when drawing (the default is \c 1.0).
 	 */
@@ -8,7 +8,10 @@
 
 #include <vector>
 
+#include "arena.h"
 #include "fast_obj.h"
+#include "gltf.h"
+#include "ply.h"
 #include "ufbx.h"
 #include "vec.h"
 
@@ -18,9 +21,9 @@
 struct ObjVertex
 {
 	/**
-	 * Vector of vertices.
+	 * Vector of vertices (allocated from the current \c Arena).
 	 */
-	typedef std::vector<ObjVertex> Container;
+	typedef std::vector<ObjVertex, ArenaAllocator<ObjVertex> > Container;
 	/**
 	 * Uninitialised vertex data.
 	 */
@@ -41,6 +44,23 @@ struct ObjVertex
 	 * \param[in] idx current face index being processed
 	 */
 	ObjVertex(ufbx_mesh* fbx, size_t const idx);
+	/**
+	 * Constructs a single vertex from a glTF primitive, extracting the
+	 * relevant position, normal, tangents, UV and colour data (with the UVs
+	 * flipped vertically to match the \c .obj convention).
+	 *
+	 * \param[in] prim the glTF primitive
+	 * \param[in] idx vertex being processed (already resolved from any indices)
+	 */
+	ObjVertex(const GltfFile::Primitive& prim, size_t const idx);
+	/**
+	 * Constructs a single vertex from the PLY data, extracting the relevant
+	 * position, normal, UV and colour data. The tangents are zeroed.
+	 *
+	 * \param[in] ply the PLY file
+	 * \param[in] idx vertex being processed
+	 */
+	ObjVertex(const PlyFile& ply, size_t const idx);
 
 	//****************************** Conversions ******************************/
 
@@ -72,6 +92,57 @@ struct ObjVertex
 	 */
 	static void encodeNormals(Container& verts, VertexPacker::Storage norm, VertexPacker::Storage tans, bool const btan, bool const legacy = false);
 
+	/**
+	 * In-place encoding of the normals, tangents and bitangent sign as a
+	 * single QTangent quaternion, with the reflection in its sign. The
+	 * quaternion's \c xyz are stored in \c #norm and its \c w in \c #sign
+	 * (with the tangents and bitangents zeroed).
+	 *
+	 * \note As with \c #encodeNormals() this requires the unencoded normals
+	 * and generated tangents.
+	 *
+	 * \param[in,out] verts collection of triangles
+	 * \param[in] type storage type for the quaternion (which sets the bias for \c w)
+	 */
+	static void encodeQTangents(Container& verts, VertexPacker::Storage type);
+
+	/**
+	 * Measures the largest angular error of the normals, tangents and
+	 * bitangents once stored (after any octahedral encoding), for choosing the
+	 * smallest types within an error budget.
+	 *
+	 * \note This requires the unencoded normals and generated tangents (so
+	 * is called before \c #encodeNormals()).
+	 *
+	 * \param[in] verts collection of triangles
+	 * \param[in] norm normals storage type
+	 * \param[in] tans tangents (and bitangents) storage type (\c EXCLUDE to measure only the normals)
+	 * \param[in] btan \c true if bitangents should also be measured
+	 * \param[in] encoded \c true if the vectors would be octahedral encoded
+	 * \param[in] legacy see \c VertexPacker::Options#OPTS_SIGNED_LEGACY (default is modern encoding)
+	 * \return largest angular error (in degrees)
+	 */
+	static float normalError(const Container& verts, VertexPacker::Storage norm, VertexPacker::Storage tans, bool const btan, bool const encoded, bool const legacy = false);
+
+	/**
+	 * Stores then restores a vertex's normal, tangent and bitangent, encoded
+	 * as \c #encodeNormals() or \c #encodeQTangents() would, returning them
+	 * as the runtime would see them (with the bitangent recreated from the
+	 * normal and tangent if only its sign is stored).
+	 *
+	 * \param[in] vert vertex with unencoded normals and generated tangents
+	 * \param[in] norm normals storage type
+	 * \param[in] tans tangents (and bitangents) storage type (\c EXCLUDE if only the normal is needed)
+	 * \param[in] encoded \c true if the vectors are octahedral encoded
+	 * \param[in] qtangent \c true if the frame is stored as a QTangent (of the \a tans type)
+	 * \param[in] btanSign \c true if only the bitangent sign is stored
+	 * \param[in] legacy see \c VertexPacker::Options#OPTS_SIGNED_LEGACY
+	 * \param[out] decNorm decoded normal
+	 * \param[out] decTans decoded tangent (untouched if \a tans is \c EXCLUDE)
+	 * \param[out] decBtan decoded bitangent (untouched if \a tans is \c EXCLUDE)
+	 */
+	static void roundtripFrame(const ObjVertex& vert, VertexPacker::Storage norm, VertexPacker::Storage tans, bool const encoded, bool const qtangent, bool const btanSign, bool const legacy, vec3& decNorm, vec3& decTans, vec3& decBtan);
+
 	//*************************************************************************/
 
 	vec3 posn; /**< Positions (from the \c .obj or FBX file). */
@@ -80,7 +151,7 @@ struct ObjVertex
 	vec3 norm; /**< Normals (from the \c .obj or FBX file). */
 	vec3 tans; /**< Tangents (generated if needed). */
 	vec3 btan; /**< Bitangents (generated if needed). */
-	vec4 rgba; /**< Vertex colours (standard only in the FBX file). */
+	vec4 rgba; /**< Vertex colours (only in the FBX file, otherwise opaque white). */
 	/**
 	 * An alternative to storing the bitangents is to recreate them from:
 	 * \code
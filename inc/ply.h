@@ -0,0 +1,109 @@
+/**
+ * \file ply.h
+ * Minimal binary PLY reader (little- or big-endian, e.g. from scanners).
+ *
+ * \copyright 2022 Numfum GmbH
+ */
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "fileutils.h"
+
+/**
+ * The vertices and faces of a binary PLY file, with the vertex data read
+ * in-place from the mapped file (only the short text header is parsed). The
+ * faces are triangulated as they're read, as fans matching the \c .obj
+ * loader. Usage:
+ * \code
+ *	PlyFile ply;
+ *	if (ply.open(srcPath)) {
+ *		for (size_t n = 0; n < ply.tris.size(); n++) {
+ *			float x = ply.get(ply.posn[0], ply.tris[n]);
+ *		}
+ *	}
+ * \endcode
+ * \note ASCII PLY isn't supported (convert it to binary, or to an \c .obj).
+ */
+class PlyFile
+{
+public:
+	/**
+	 * Property types.
+	 */
+	enum Type {
+		NONE,    /**< Missing property. */
+		INT8,    /**< \c char or \c int8. */
+		UINT8,   /**< \c uchar or \c uint8. */
+		INT16,   /**< \c short or \c int16. */
+		UINT16,  /**< \c ushort or \c uint16. */
+		INT32,   /**< \c int or \c int32. */
+		UINT32,  /**< \c uint or \c uint32. */
+		FLOAT32, /**< \c float or \c float32. */
+		FLOAT64, /**< \c double or \c float64. */
+	};
+
+	/**
+	 * A single vertex property.
+	 */
+	struct Property {
+		size_t offset; /**< Offset from the start of each vertex. */
+		Type type;     /**< Property type (or \c NONE if missing). */
+
+		/**
+		 * Tests whether the property exists.
+		 */
+		bool valid() const {
+			return type != NONE;
+		}
+	};
+
+	/**
+	 * Creates an unopened file.
+	 */
+	PlyFile();
+
+	/**
+	 * Opens a binary PLY file, reading the \c vertex and \c face elements
+	 * (any others being skipped).
+	 *
+	 * \note Any previous content is released.
+	 *
+	 * \param[in] srcPath filename of the PLY file
+	 * \return \c true if the file was valid and contained at least one triangle
+	 */
+	bool open(const char* const srcPath);
+
+	/**
+	 * Reads a vertex property.
+	 *
+	 * \param[in] prop property to read
+	 * \param[in] idx vertex to read (less than \c #verts)
+	 * \param[in] norm \c true if integer types should be normalised to \c 0 to \c 1 (e.g. for colours, otherwise the integer's value)
+	 * \return the property's value (or zero if missing)
+	 */
+	float get(const Property& prop, size_t const idx, bool const norm = false) const;
+
+	size_t verts;          /**< Number of vertices. */
+	Property posn[3];      /**< Properties \c x, \c y and \c z. */
+	Property norm[3];      /**< Properties \c nx, \c ny and \c nz. */
+	Property tex0[2];      /**< Properties \c u and \c v (or \c s and \c t, optionally prefixed with \c texture_). */
+	Property rgba[4];      /**< Properties \c red, \c green, \c blue and \c alpha (optionally prefixed with \c diffuse_). */
+	std::vector<uint32_t> tris; /**< Triangulated faces, as vertex indices (each less than \c #verts). */
+
+private:
+	PlyFile       (const PlyFile&) = delete; /**< Not copyable   */
+	void operator=(const PlyFile&) = delete; /**< Not assignable */
+
+	/**
+	 * Clears the vertices and faces (with every property missing).
+	 */
+	void reset();
+
+	MappedFile file;          /**< The PLY file. */
+	const uint8_t* vertData;  /**< Start of the vertex data (in \c #file). */
+	size_t vertStride;        /**< Bytes per vertex. */
+	bool bigEndian;           /**< \c true if the data are big-endian. */
+};
@@ -6,6 +6,8 @@
  */
 #pragma once
 
+#include <vector>
+
 #include "vertexpacker.h"
 
 /**
@@ -21,6 +23,45 @@
 #define O2B_HAS_OPT(var, ordinal) ((var & (1 << ordinal)) != 0)
 #endif
 
+/**
+ * Helper to set \c ToolOptions#opts from an \c Options ordinal. E.g.:
+ * \code
+ *	O2B_SET_OPT(myVar, OPTS_POSITIONS_SCALE)
+ * \endcode
+ */
+#ifndef O2B_SET_OPT
+#define O2B_SET_OPT(var, ordinal) var |= (1 << ordinal)
+#endif
+
+/**
+ * Helper to clear \c ToolOptions#opts from an \c Options ordinal. E.g.:
+ * \code
+ *	O2B_CLEAR_OPT(myVar, OPTS_POSITIONS_SCALE)
+ * \endcode
+ */
+#ifndef O2B_CLEAR_OPT
+#define O2B_CLEAR_OPT(var, ordinal) var &= ~(1 << ordinal)
+#endif
+
+/**
+ * \def O2B_VERSION
+ * Tool version. This should be bumped whenever a change alters the output for
+ * the same input and options (it forms part of the cache key, so bumping it
+ * invalidates previously cached results).
+ */
+#ifndef O2B_VERSION
+#define O2B_VERSION 2
+#endif
+
+/**
+ * \def O2B_MAX_LODS
+ * Maximum number of generated LODs (in addition to the full detail mesh),
+ * limited by the bits available in the extended shortcode.
+ */
+#ifndef O2B_MAX_LODS
+#define O2B_MAX_LODS 7
+#endif
+
 /**
  * Tool options specific to writing an interleaved buffer. Usage:
  * \code
@@ -101,9 +142,12 @@ public:
 		 */
 		OPTS_ASCII_FILE,
 		/**
-		 * Reserved for future use.
+		 * The shortcode has a second word of extended options (see \c
+		 * #getExtOptions()). This is set automatically whenever an extended
+		 * option is used and, with \c #OPTS_WRITE_METADATA, the layout header
+		 * is followed by the extended options and a table of extra sections.
 		 */
-		OPTS_RESERVED,
+		OPTS_EXTENDED,
 
 		//******************* Start of the internal options *******************/
 
@@ -115,7 +159,7 @@ public:
 		/**
 		 * Last user-settable option bit.
 		 */
-		OPTS_LAST_USER = OPTS_RESERVED,
+		OPTS_LAST_USER = OPTS_EXTENDED,
 		/**
 		 * Default options: normals have three components (plus padding); data
 		 * are written as uncompressed binary in little endian ordering.
@@ -123,6 +167,108 @@ public:
 		OPTS_DEFAULT = 0,
 	};
 
+	/**
+	 * What the tool does when run (the default being to convert a single
+	 * file).
+	 */
+	enum Mode {
+		/**
+		 * Convert the single source file to the destination.
+		 */
+		MODE_CONVERT = 0,
+		/**
+		 * Run as a server, reading conversion requests from \c stdin (with no
+		 * source or destination files on the command-line).
+		 */
+		MODE_SERVE,
+		/**
+		 * Train a Zstandard dictionary (written to \c #dict) from the sample
+		 * files on the command-line.
+		 */
+		MODE_TRAIN_DICT,
+		/**
+		 * Analyse the source files on the command-line, reporting the mesh
+		 * quality before and after each optimisation step (as JSON on \c
+		 * stdout) without writing any output.
+		 */
+		MODE_ANALYZE,
+	};
+
+	/**
+	 * Primitive type of the index buffer (or, for unindexed output, the order
+	 * of the vertices).
+	 */
+	enum Topology {
+		/**
+		 * Triangle list (the default).
+		 */
+		TOPOLOGY_LIST = 0,
+		/**
+		 * Triangle strips, joined with a primitive restart index (the maximum
+		 * value of the index type, e.g. \c 0xFFFF for shorts).
+		 */
+		TOPOLOGY_STRIP_RESTART,
+		/**
+		 * Triangle strips, joined with degenerate triangles (for APIs without
+		 * primitive restart, and always used for unindexed strips).
+		 */
+		TOPOLOGY_STRIP_DEGENERATE,
+	};
+
+	/**
+	 * How the vertex attributes are arranged in the vertex data.
+	 */
+	enum Streams {
+		/**
+		 * A single stream with all the attributes interleaved (the default).
+		 */
+		STREAMS_INTERLEAVED = 0,
+		/**
+		 * Two streams: the positions alone, then the remaining attributes
+		 * interleaved (so depth-only passes fetch only the positions).
+		 */
+		STREAMS_POSITION,
+		/**
+		 * One stream per attribute.
+		 */
+		STREAMS_ATTRIBUTE,
+	};
+
+	/**
+	 * Optimisation profile, trading conversion time for the mesh's runtime
+	 * efficiency (see \c ObjMesh#optimise()).
+	 */
+	enum Profile {
+		/**
+		 * Vertex cache (or, for strips, strip-friendly vertex cache), overdraw
+		 * and vertex fetch optimisation (the default).
+		 */
+		PROFILE_DEFAULT = 0,
+		/**
+		 * No optimisation, keeping the source order (e.g. for the quickest
+		 * editor previews).
+		 */
+		PROFILE_NONE,
+		/**
+		 * Faster (but less effective) FIFO vertex cache optimisation, sized
+		 * from \c #vcacheSize, then vertex fetch optimisation (skipping
+		 * overdraw).
+		 */
+		PROFILE_FAST,
+		/**
+		 * As \c #PROFILE_DEFAULT but always favouring strips in the vertex
+		 * cache order (which, even for lists, makes for smaller compressed
+		 * indices).
+		 */
+		PROFILE_STRIP,
+		/**
+		 * As \c #PROFILE_DEFAULT but with a more generous default overdraw
+		 * threshold (5% instead of 1%), reducing overdraw further at the
+		 * expense of the vertex cache.
+		 */
+		PROFILE_MAX,
+	};
+
 	/**
 	 * Storage type to use when writing the positions. The default is three
 	 * 32-bit \c float&nbsp;s (12 bytes).
@@ -140,6 +286,25 @@ public:
 	 */
 	VertexPacker::Storage text;
 
+	/**
+	 * Storage type to use when writing the second texture UV channel (e.g.
+	 * for lightmaps, only available from FBX files). The default is exclude.
+	 */
+	VertexPacker::Storage tex1;
+
+	/**
+	 * \c true if the vertex colours are written (as four normalised unsigned
+	 * bytes, RGBA). Meshes without colours are written as opaque white.
+	 */
+	bool rgba;
+
+	/**
+	 * \c true if the normals, tangents and bitangent sign are written as a
+	 * single QTangent quaternion (stored using the \c #tans type, either
+	 * bytes or shorts).
+	 */
+	bool qtangent;
+
 	/**
 	 * Storage type to use when writing the normals. The default is three 32-bit
 	 * \c float&nbsp;s (12 bytes).
@@ -162,16 +327,268 @@ public:
 	 */
 	unsigned opts;
 
+	/**
+	 * Number of simplified LODs to generate (in addition to the full detail
+	 * mesh, up to \c O2B_MAX_LODS). The default is none. All LODs share the
+	 * vertex buffer, each with its own range of the index buffer.
+	 */
+	unsigned lods;
+
+	/**
+	 * \c true if the LODs are generated with the \e sloppy simplifier (which
+	 * ignores the topology, for faster and more aggressive reductions).
+	 */
+	bool lodSloppy;
+
+	/**
+	 * Target index count of each LOD as a fraction of the previous (the
+	 * default being half). Not part of the shortcode (but recorded in the
+	 * cache key).
+	 */
+	float lodRatio;
+
+	/**
+	 * Maximum simplification error, relative to the mesh extents (the default
+	 * is 5%). A LOD stops short of its target ratio if reaching it would
+	 * exceed this error. Not part of the shortcode (but recorded in the
+	 * cache key).
+	 */
+	float lodError;
+
+	/**
+	 * Primitive type of the index buffer (the default being triangle lists).
+	 */
+	Topology topology;
+
+	/**
+	 * \c true if the full detail mesh is also partitioned into meshlets (for
+	 * mesh shaders and cluster culling), written as extra sections.
+	 */
+	bool meshlets;
+
+	/**
+	 * Maximum vertices per meshlet (the default is \c 64, up to \c 255). Not
+	 * part of the shortcode (but recorded in the cache key).
+	 */
+	unsigned meshletVerts;
+
+	/**
+	 * Maximum triangles per meshlet (the default is \c 124, up to \c 512 in
+	 * multiples of \c 4). Not part of the shortcode (but recorded in the
+	 * cache key).
+	 */
+	unsigned meshletTris;
+
+	/**
+	 * Weighting of the normal cones when building meshlets, from \c 0 (ignore
+	 * the cones, favouring compact meshlets) to \c 1 (favour tight cones for
+	 * backface culling). The default is \c 0.25. Not part of the shortcode
+	 * (but recorded in the cache key).
+	 */
+	float meshletCone;
+
+	/**
+	 * \c true if meshes with more vertices than the index type can address
+	 * are split into chunks, each drawn with a base vertex (written as an
+	 * extra section).
+	 */
+	bool split;
+
+	/**
+	 * \c true if a shadow index buffer is also generated for depth-only
+	 * passes (indexing only the unique positions), written as an extra
+	 * section.
+	 */
+	bool shadow;
+
+	/**
+	 * Arrangement of the vertex data (see \c #Streams). Each stream follows
+	 * the previous, with its own stride.
+	 */
+	Streams streams;
+
+	/**
+	 * \c true if the metadata is written as the versioned v2 container (a
+	 * fixed header then a table of sections with 64-bit offsets, each section
+	 * starting on an \c #align boundary) instead of the packed header. Only
+	 * used with \c #OPTS_WRITE_METADATA.
+	 */
+	bool container;
+
+	/**
+	 * Alignment of each section in the v2 \c #container, as a power of two
+	 * from \c 4 to \c 65536 (the default is \c 16, with \c 256 meeting the
+	 * buffer offset requirements of Vulkan and Metal). Not part of the
+	 * shortcode (but stored in the container and recorded in the cache key).
+	 */
+	unsigned align;
+
+	/**
+	 * Optimisation profile (see \c #Profile).
+	 */
+	Profile profile;
+
+	/**
+	 * Percentage by which the overdraw optimisation may worsen the vertex
+	 * cache, from \c 1 to \c 31 (the default, \c 0, uses the profile's
+	 * own threshold). See \c #getOverdrawThreshold().
+	 */
+	unsigned overdraw;
+
+	/**
+	 * Number of entries in the FIFO vertex cache for \c #PROFILE_FAST and
+	 * the simulated vertex cache for \c MODE_ANALYZE, from \c 3 to \c 63
+	 * (the default is \c 16).
+	 */
+	unsigned vcacheSize;
+
+	/**
+	 * Bytes per vertex for the simulated vertex fetch in \c MODE_ANALYZE (the
+	 * default, \c 0, uses the packed stride from the chosen layout).
+	 */
+	unsigned vfetchSize;
+
+	/**
+	 * \c true if the vertex types are chosen after loading, per attribute, as
+	 * the smallest meeting the error budget (see \c #autoPosnError, etc.),
+	 * with the requested types only deciding which attributes are written.
+	 * Not part of the shortcode (the chosen types are, though).
+	 */
+	bool autoLayout;
+
+	/**
+	 * Maximum position error for \c #autoLayout, relative to the longest
+	 * side of the mesh's bounds (the default is \c 0.0005, or 0.05%).
+	 */
+	float autoPosnError;
+
+	/**
+	 * Maximum UV error for \c #autoLayout, in texels of a \c #autoTexSize
+	 * texture (the default is \c 0.5).
+	 */
+	float autoTexError;
+
+	/**
+	 * Texture size for \c #autoTexError (the default is \c 2048).
+	 */
+	unsigned autoTexSize;
+
+	/**
+	 * Maximum normal, tangent and bitangent error for \c #autoLayout, in
+	 * degrees (the default is \c 1).
+	 */
+	float autoNormError;
+
+	/**
+	 * Directory for the converted buffer cache (or \c null to disable
+	 * caching). Not part of the shortcode since it doesn't affect the output.
+	 */
+	const char* cache;
+
+	/**
+	 * Directory for the processed mesh cache (or \c null to disable), storing
+	 * the mesh after loading and processing as an \c .o2bmesh file (see \c
+	 * writeMesh()). Keyed on the source and only the options affecting the
+	 * processing, so different encodings of the same mesh share the entry.
+	 * Not part of the shortcode.
+	 */
+	const char* meshCache;
+
+	/**
+	 * Zstandard dictionary used when compressing (or \c null for none). When
+	 * training with \c MODE_TRAIN_DICT this is the destination instead.
+	 */
+	const char* dict;
+
+	/**
+	 * \c true if the output is streamed to the file in fixed-size chunks
+	 * (bounding the memory used regardless of the mesh size) instead of being
+	 * packed in its entirety then written. Not part of the shortcode since the
+	 * packed content is the same.
+	 */
+	bool stream;
+
+	/**
+	 * Filename of a JSON report of the quantisation errors (or \c null for
+	 * no report). Not part of the shortcode since the packed content is the
+	 * same (though a cache hit writes no report, so the cache is bypassed).
+	 */
+	const char* errors;
+
+	/**
+	 * Additional output of the same source (see \c #outputs).
+	 */
+	struct Output {
+		uint64_t code;       /**< Shortcode (including any extended options). */
+		const char* dstPath; /**< Filename of the destination. */
+	};
+
+	/**
+	 * Additional outputs from \c -c \c code:path, each with its own shortcode
+	 * (the remaining options, e.g. the LOD tuning or cache, being shared).
+	 * The source is loaded and processed once for every output agreeing on
+	 * the mesh processing, then each output's encoding and writing run
+	 * concurrently. Not part of the shortcode.
+	 */
+	std::vector<Output> outputs;
+
+	/**
+	 * What the tool does when run (see \c #Mode).
+	 */
+	Mode mode;
+
+	/**
+	 * Reason the arguments were rejected (empty if they were valid). Only
+	 * set when parsing requests (see \c #parseArgs()), since invalid
+	 * command-line arguments print the help and exit.
+	 */
+	char error[128];
+
 	/**
 	 * Creates the default options.
 	 */
 	ToolOptions()
 		: posn(VertexPacker::Storage::FLOAT32)
 		, text(VertexPacker::Storage::FLOAT32)
+		, tex1(VertexPacker::Storage::EXCLUDE)
+		, rgba(false)
+		, qtangent(false)
 		, norm(VertexPacker::Storage::FLOAT32)
 		, tans(VertexPacker::Storage::EXCLUDE)
 		, idxs(VertexPacker::Storage::UINT16C)
-		, opts(OPTS_DEFAULT) {}
+		, opts(OPTS_DEFAULT)
+		, lods(0)
+		, lodSloppy(false)
+		, lodRatio (0.5f)
+		, lodError (0.05f)
+		, topology(TOPOLOGY_LIST)
+		, meshlets(false)
+		, meshletVerts(64)
+		, meshletTris (124)
+		, meshletCone (0.25f)
+		, split(false)
+		, shadow(false)
+		, streams(STREAMS_INTERLEAVED)
+		, container(false)
+		, align(16)
+		, profile (PROFILE_DEFAULT)
+		, overdraw(0)
+		, vcacheSize(16)
+		, vfetchSize(0)
+		, autoLayout   (false)
+		, autoPosnError(0.0005f)
+		, autoTexError (0.5f)
+		, autoTexSize  (2048)
+		, autoNormError(1.0f)
+		, cache (nullptr)
+		, meshCache(nullptr)
+		, dict  (nullptr)
+		, stream(false)
+		, errors(nullptr)
+		, mode  (MODE_CONVERT)
+		, exitOnError(true) {
+		error[0] = '\0';
+	}
 
 	/**
 	 * Parse the command-lines arguments and populate this object.
@@ -179,7 +596,10 @@ public:
 	 * \param[in] argv command-line arguments \e exactly as passed-in from \c main()
 	 * \param[in] argc number of entries in \a argv
 	 * \param[in] cli \c true if these were arguments from the command line (and so the first entry is the program name)
-	 * \return index where the argument parsing ended (\c 0 if there were no arguments)
+	 * \return index where the argument parsing ended (\c 0 if there were no arguments, \a argc if the \c #mode needs no files)
+	 * \note From the command line invalid arguments print the help and exit.
+	 * Otherwise (e.g. for \c --serve requests) nothing is written to \c
+	 * stdout, the reason is stored in \c #error, and \a argc is returned.
 	 */
 	int parseArgs(const char* const argv[], int const argc, bool const cli = true);
 
@@ -193,6 +613,25 @@ public:
 	 */
 	uint32_t getAllOptions() const;
 
+	/**
+	 * Take all the \e extended options and combine them into a second
+	 * shortcut word (which, if non-zero, sets \c #OPTS_EXTENDED in \c
+	 * #getAllOptions()). The two words are written as a single 64-bit
+	 * shortcode, the extended options being the upper half.
+	 *
+	 * \return extended options as a single integer (\c 0 if none are used)
+	 */
+	uint32_t getExtOptions() const;
+
+	/**
+	 * Calculates the overdraw threshold from \c #overdraw and the \c
+	 * #profile, as the maximum ratio of the vertex cache's ACMR after
+	 * optimising (e.g. \c 1.01 allows a 1% worse ACMR).
+	 *
+	 * \return threshold for the overdraw optimisation
+	 */
+	float getOverdrawThreshold() const;
+
 	/**
 	 * Prints the options to \c stdout in a human readable form.
 	 */
@@ -206,6 +645,31 @@ public:
 	 */
 	static const char* filename(const char* const path);
 
+	/**
+	 * Helper to name a profile (as used on the command-line).
+	 *
+	 * \param[in] profile optimisation profile
+	 * \return the profile's name (e.g. \c "fast")
+	 */
+	static const char* toString(Profile const profile);
+
+	/**
+	 * Sets the options from a full shortcode (as passed to \c -c), with any
+	 * extended options in the upper 32-bits, then calls \c #fixUp().
+	 *
+	 * \param[in] code packing and options (then extended options) as a single integer
+	 */
+	void setShortcode(uint64_t const code);
+
+	/**
+	 * Assess the options and tweak any that need changing or cleaning up. For
+	 * example, index buffer types should be unsigned clamped.
+	 *
+	 * \note This is called after parsing, and again whenever the types are
+	 * changed directly (e.g. by \c #autoLayout).
+	 */
+	void fixUp();
+
 private:
 	/**
 	 * Performs the work of \c #parseArgs().
@@ -217,12 +681,6 @@ private:
 	 */
 	int parseNext(const char* const argv[], int const argc, int next);
 
-	/**
-	 * Assess the options and tweak any that need changing or cleaning up. For
-	 * example, index buffer types should be unsigned clamped.
-	 */
-	void fixUp();
-
 	/**
 	 * Sets all of the options from a single shortcut, performing the opposite
 	 * of \c #getAllOptions(). After setting \c #fixUp() should be called to
@@ -232,10 +690,29 @@ private:
 	 */
 	void setAllOptions(uint32_t const val);
 
+	/**
+	 * Sets the extended options from a second shortcut word, performing the
+	 * opposite of \c #getExtOptions().
+	 *
+	 * \param[in] val extended options as a single integer
+	 */
+	void setExtOptions(uint32_t const val);
+
+	/**
+	 * Rejects the arguments, either printing the help and exiting (from the
+	 * command line) or storing the reason in \c #error (keeping the first).
+	 *
+	 * \param[in] reason why the arguments were rejected
+	 * \param[in] what optional argument the reason refers to
+	 */
+	void fail(const char* const reason, const char* const what = nullptr);
+
 	/**
 	 * Print the CLI help then exit.
 	 *
 	 * \param[in] path the application path as passed-in as the first parameter from the CLI
 	 */
 	static void help(const char* const path = nullptr);
+
+	bool exitOnError; /**< \c true if \c #fail() should exit (when parsing the command line). */
 };
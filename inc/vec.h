@@ -138,13 +138,17 @@ struct Vec2
 	VEC2_SIMPLE_OPERATOR_WITH_SCALAR(*)
 	VEC2_SIMPLE_OPERATOR_WITH_SCALAR(/)
 	/**
-	 * Adds this vector to a buffer.
+	 * Adds this vector to a buffer (packed types add all the components as
+	 * one, with any the vector doesn't have being zero).
 	 *
 	 * \param[in] dest vertex packer wrapping the destination buffer
 	 * \param[in] type conversion and byte storage
 	 * \return \c VP_FAILED if adding failed (e.g. if no more storage space is available)
 	 */
 	VertexPacker::Failed store(VertexPacker& dest, VertexPacker::Storage const type) const {
+		if (type.isPacked()) {
+			return dest.add(float(x), float(y), 0.0f, 0.0f, type);
+		}
 		VertexPacker::Failed failed = false;
 		failed |= dest.add(x, type);
 		failed |= dest.add(y, type);
@@ -237,6 +241,9 @@ struct Vec3
 	 * \copydoc Vec2::store()
 	 */
 	VertexPacker::Failed store(VertexPacker& dest, VertexPacker::Storage const type) const {
+		if (type.isPacked()) {
+			return dest.add(float(x), float(y), float(z), 0.0f, type);
+		}
 		VertexPacker::Failed failed = false;
 		failed |= dest.add(x, type);
 		failed |= dest.add(y, type);
@@ -295,6 +302,11 @@ struct Vec4
 	T z;
 	T w;
 	Vec4() {}
+	Vec4(const Vec3<T>& xyz, T const w)
+		: x(xyz.x)
+		, y(xyz.y)
+		, z(xyz.z)
+		, w(w) {}
 	Vec4& operator =(T const val) {
 		x = val;
 		y = val;
@@ -321,6 +333,9 @@ struct Vec4
 	 * \copydoc Vec2::store()
 	 */
 	VertexPacker::Failed store(VertexPacker& dest, VertexPacker::Storage const type) const {
+		if (type.isPacked()) {
+			return dest.add(float(x), float(y), float(z), float(w), type);
+		}
 		VertexPacker::Failed failed = false;
 		failed |= dest.add(x, type);
 		failed |= dest.add(y, type);
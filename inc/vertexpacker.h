@@ -45,8 +45,6 @@ public:
 	 * Data storage types.
 	 *
 	 * \note Individual support notes are aimed at ANGLE and older D3D.
-	 *
-	 * \todo re-add support for \c 10_10_10_2 formats?
 	 */
 	class Storage
 	{
@@ -138,6 +136,30 @@ public:
 			 * consecutive bytes.
 			 */
 			FLOAT32,
+			/**
+			 * Signed packed \c 10_10_10_2 (normalised to fit the range \c
+			 * -1.0 to \c 1.0), with \c x in the lowest ten bits and \c w in
+			 * the upper two. All the components are stored in four bytes.
+			 *
+			 * \note Incompatible with D3D11 \e Feature \e Level 9_3 vertex data.
+			 */
+			SINT10_2N,
+			/**
+			 * Unsigned packed \c 10_10_10_2 (normalised to fit the range \c
+			 * 0.0 to \c 1.0), otherwise as \c #SINT10_2N.
+			 *
+			 * \note Incompatible with D3D11 \e Feature \e Level 9_3 vertex data.
+			 */
+			UINT10_2N,
+			/**
+			 * Unsigned packed \c 11_11_10 floats, \c x and \c y having six
+			 * bits of mantissa, \c z having five, and each having a five bit
+			 * exponent (negative values are stored as zero). All three
+			 * components are stored in four bytes.
+			 *
+			 * \note Hardware support should be queried before using.
+			 */
+			FLOAT11_10,
 
 			//************************ Internal Types ************************/
 
@@ -169,6 +191,9 @@ public:
 			TYPE_UNSIGNED_INT = 6,   /**< \c UINT32C. */
 			TYPE_HALF_FLOAT = 7,     /**< \c FLOAT16. */
 			TYPE_FLOAT = 8,          /**< \c FLOAT32. */
+			TYPE_INT_2_10_10_10_REV = 9,           /**< \c SINT10_2N. */
+			TYPE_UNSIGNED_INT_2_10_10_10_REV = 10, /**< \c UINT10_2N. */
+			TYPE_UNSIGNED_INT_10F_11F_11F_REV = 11 /**< \c FLOAT11_10. */
 		};
 
 		/**
@@ -200,7 +225,8 @@ public:
 
 		/**
 		 * Returns the number of bytes each storage type requires, for example
-		 * \c 1 byte for \c SINT08N, \c 2 for SINT16N, etc.
+		 * \c 1 byte for \c SINT08N, \c 2 for SINT16N, etc. Packed types
+		 * return the bytes for \e all their components.
 		 *
 		 * \return the number of bytes each storage type requires
 		 */
@@ -252,6 +278,12 @@ public:
 				return TYPE_UNSIGNED_INT;
 			case FLOAT32:
 				return TYPE_FLOAT;
+			case SINT10_2N:
+				return TYPE_INT_2_10_10_10_REV;
+			case UINT10_2N:
+				return TYPE_UNSIGNED_INT_2_10_10_10_REV;
+			case FLOAT11_10:
+				return TYPE_UNSIGNED_INT_10F_11F_11F_REV;
 			default:
 				return TYPE_NONE;
 			}
@@ -286,6 +318,12 @@ public:
 					return "UNSIGNED_INT";
 				case FLOAT32:
 					return "FLOAT";
+				case SINT10_2N:
+					return "INT_2_10_10_10_REV";
+				case UINT10_2N:
+					return "UNSIGNED_INT_2_10_10_10_REV";
+				case FLOAT11_10:
+					return "UNSIGNED_INT_10F_11F_11F_REV";
 				default:
 					return "N/A";
 				}
@@ -311,6 +349,12 @@ public:
 					return "unsigned int";
 				case FLOAT32:
 					return "float";
+				case SINT10_2N:
+					return "packed 10:10:10:2";
+				case UINT10_2N:
+					return "packed unsigned 10:10:10:2";
+				case FLOAT11_10:
+					return "packed float 11:11:10";
 				default:
 					return "N/A";
 				}
@@ -330,6 +374,8 @@ public:
 			case UINT16N:
 			case UINT16C:
 			case UINT32C:
+			case UINT10_2N:
+			case FLOAT11_10:
 				return false;
 			default:
 				return true;
@@ -347,6 +393,8 @@ public:
 			case UINT08N:
 			case SINT16N:
 			case UINT16N:
+			case SINT10_2N:
+			case UINT10_2N:
 			case SINT10N:
 			case SINT23N:
 				return true;
@@ -372,6 +420,8 @@ public:
 			case UINT16N:
 				return 16;
 			case FLOAT16:
+			case SINT10_2N:
+			case UINT10_2N:
 			case SINT10N:
 				return 10;
 			case FLOAT32:
@@ -382,6 +432,43 @@ public:
 			}
 		}
 
+		/**
+		 * Queries whether a storage type packs all of its components into a
+		 * single value (e.g. \c SINT10_2N), needing \c VertexPacker#add()
+		 * with the whole vector instead of one component at a time.
+		 *
+		 * \return \c true if \a type is packed
+		 */
+		bool isPacked() const {
+			switch (type) {
+			case SINT10_2N:
+			case UINT10_2N:
+			case FLOAT11_10:
+				return true;
+			default:
+				return false;
+			}
+		}
+
+		/**
+		 * Returns the number of components a packed type holds (\c 4 for the
+		 * \c 10_10_10_2 formats, \c 3 for \c 11_11_10), which is also the
+		 * component count the rendering API expects.
+		 *
+		 * \return number of components (or zero if the type isn't packed)
+		 */
+		unsigned components() const {
+			switch (type) {
+			case SINT10_2N:
+			case UINT10_2N:
+				return 4;
+			case FLOAT11_10:
+				return 3;
+			default:
+				return 0;
+			}
+		}
+
 	private:
 		/**
 		 * Internal type.
@@ -446,6 +533,13 @@ public:
 	 */
 	size_t size() const;
 
+	/**
+	 * Returns the number of bytes still available in the underlying storage.
+	 *
+	 * \return the number of bytes that can still be added
+	 */
+	size_t remaining() const;
+
 	/**
 	 * Adds a value to the data stream, converting and storing to \a type.
 	 *
@@ -475,6 +569,23 @@ public:
 		return add(static_cast<int>(data), type);
 	}
 
+	/**
+	 * Adds a vector to the data stream as a single packed value, for the
+	 * types where all components share the same four bytes (see \c
+	 * Storage#isPacked()). Components the type doesn't have are ignored (and
+	 * missing components should be passed as zero).
+	 *
+	 * \note Adding a single component with a packed type fails.
+	 *
+	 * \param[in] x first component (in the lowest bits)
+	 * \param[in] y second component
+	 * \param[in] z third component
+	 * \param[in] w fourth component (two bits for the \c 10_10_10_2 formats)
+	 * \param[in] type conversion and byte storage
+	 * \return \c VP_FAILED if adding failed (e.g. if no more storage space is available or \a type isn't packed)
+	 */
+	Failed add(float const x, float const y, float const z, float const w, Storage const type);
+
 	/**
 	 * Add padding to 4-byte align the next \c #add(). This will add \c 1, \c 2
 	 * or \c 3 bytes if padding is required (otherwise zero).
@@ -489,6 +600,16 @@ public:
 	 */
 	Failed align(size_t const base = 0);
 
+	/**
+	 * Adds already packed bytes to the data stream, copying them verbatim
+	 * (e.g. to duplicate a vertex packed earlier with the same options).
+	 *
+	 * \param[in] data start of the packed bytes
+	 * \param[in] bytes number of bytes to copy
+	 * \return \c VP_FAILED if adding failed (e.g. if no more storage space is available)
+	 */
+	Failed copy(const void* const data, size_t const bytes);
+
 	/**
 	 * Starts adding to the stream from the beginning (overwriting any existing
 	 * content and allowing underlying storage to be reused).
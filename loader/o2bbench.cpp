@@ -0,0 +1,208 @@
+/**
+ * \file o2bbench.cpp
+ * Measures the load and decode time of \c obj2buf outputs with \c BufferFile,
+ * to compare output options by their runtime cost (not only their size). The
+ * same source would be written with each option under test, for example:
+ * \code
+ *	obj2buf -c 8115507B:bunny.bin -c 8115527B:bunny_z.bin bunny.obj
+ *	o2bbench bunny.bin bunny_z.bin
+ * \endcode
+ *
+ * \copyright 2022 Numfum GmbH
+ */
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+
+#include "o2bload.h"
+
+/**
+ * \def O2B_BENCH_RUNS
+ * Default number of times each file is loaded (see \c -n).
+ */
+#ifndef O2B_BENCH_RUNS
+#define O2B_BENCH_RUNS 100
+#endif
+
+/**
+ * Result of touching the content, kept so the reads aren't optimised away.
+ */
+static volatile uint64_t sink = 0;
+
+/**
+ * Helper to return the current time in microseconds.
+ *
+ * \return elapsed time in microseconds (only valid for calculating time differences)
+ */
+static double micros() {
+	return std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+/**
+ * Helper to read every byte of a range (a word at a time), as an application
+ * uploading it to the GPU would (for mapped files this is when the pages are
+ * actually read).
+ *
+ * \param[in] data start of the range
+ * \param[in] bytes size of the range in bytes
+ * \return sum of the range's words
+ */
+static uint64_t touch(const void* const data, size_t const bytes) {
+	uint64_t sum = 0;
+	if (data) {
+		const uint8_t* const src = static_cast<const uint8_t*>(data);
+		size_t n = 0;
+		for (; n + 8 <= bytes; n += 8) {
+			uint64_t word;
+			memcpy(&word, src + n, sizeof word);
+			sum += word;
+		}
+		for (; n < bytes; n++) {
+			sum += src[n];
+		}
+	}
+	return sum;
+}
+
+/**
+ * Helper to return the median of the timings.
+ *
+ * \param[in,out] times timings in microseconds (sorted in-place)
+ * \return median time
+ */
+static double median(std::vector<double>& times) {
+	std::sort(times.begin(), times.end());
+	return times[times.size() / 2];
+}
+
+/**
+ * Helper to return the size of a file on disk.
+ *
+ * \param[in] srcPath filename of the file
+ * \return number of bytes in the file (or zero if unreadable)
+ */
+static size_t fileSize(const char* const srcPath) {
+	size_t size = 0;
+	if (FILE* srcFile = fopen(srcPath, "rb")) {
+		if (fseek(srcFile, 0, SEEK_END) == 0) {
+			long const end = ftell(srcFile);
+			if (end > 0) {
+				size = static_cast<size_t>(end);
+			}
+		}
+		fclose(srcFile);
+	}
+	return size;
+}
+
+/**
+ * Loads a file \a runs times, printing the file's format then the best and
+ * median times to load and decode it, then to additionally read every byte
+ * of its vertex, index and extra sections.
+ *
+ * \param[in,out] file reused loader (keeping its decompression state between files)
+ * \param[in] srcPath filename of the \c obj2buf output
+ * \param[in] runs number of times to load the file
+ * \return \c true if every load was successful
+ */
+static bool bench(BufferFile& file, const char* const srcPath, unsigned const runs) {
+	std::vector<double> load;
+	std::vector<double> used;
+	for (unsigned n = 0; n < runs; n++) {
+		double const start = micros();
+		if (!file.open(srcPath)) {
+			return false;
+		}
+		double const loaded = micros();
+		uint64_t sum = 0;
+		for (unsigned s = 0; s < file.streams; s++) {
+			sum += touch(file.vertices[s], file.vertexCount * file.strides[s]);
+		}
+		sum += touch(file.indices, file.indexCount * file.indexSize);
+		for (std::vector<BufferFile::Section>::const_iterator it = file.sections.begin(); it != file.sections.end(); ++it) {
+			sum += touch(it->data, it->bytes);
+		}
+		sink = sink + sum;
+		double const touched = micros();
+		load.push_back(loaded  - start);
+		used.push_back(touched - start);
+		if (n + 1 < runs) {
+			file.close();
+		}
+	}
+	char format[32];
+	snprintf(format, sizeof format, "v%u%s%s%s%s", file.version,
+		(file.compressed) ? " zstd"   : "",
+		(file.ascii)      ? " ascii"  : "",
+		(file.bigEndian)  ? " be"     : "",
+		(file.zeroCopy()) ? " mapped" : "");
+	printf("%-24s %08X%08X %-18s %10u %10u %10.1f %10.1f %10.1f %10.1f\n",
+		srcPath, file.extended, file.shortcode, format,
+		static_cast<unsigned>(fileSize(srcPath)), static_cast<unsigned>(file.size()),
+		*std::min_element(load.begin(), load.end()), median(load),
+		*std::min_element(used.begin(), used.end()), median(used));
+	file.close();
+	return true;
+}
+
+/**
+ * Helper to read an entire file (for the dictionary).
+ *
+ * \param[in] srcPath filename of the file
+ * \param[out] data destination for the content
+ * \return \c true if the file was read
+ */
+static bool read(const char* const srcPath, std::vector<uint8_t>& data) {
+	size_t const size = fileSize(srcPath);
+	if (size) {
+		if (FILE* srcFile = fopen(srcPath, "rb")) {
+			data.resize(size);
+			bool const valid = fread(data.data(), 1, size, srcFile) == size;
+			fclose(srcFile);
+			return valid;
+		}
+	}
+	return false;
+}
+
+//*****************************************************************************/
+
+/**
+ * Load each file and print its timings.
+ */
+int main(int argc, const char* argv[]) {
+	BufferFile file;
+	unsigned runs = O2B_BENCH_RUNS;
+	std::vector<const char*> srcPaths;
+	for (int n = 1; n < argc; n++) {
+		if (strcmp(argv[n], "-n") == 0 && n + 1 < argc) {
+			runs = std::max(atoi(argv[++n]), 1);
+		} else if (strcmp(argv[n], "--dict") == 0 && n + 1 < argc) {
+			std::vector<uint8_t> dict;
+			if (!read(argv[++n], dict) || !file.setDictionary(dict.data(), dict.size())) {
+				fprintf(stderr, "Unable to read dictionary: %s\n", argv[n]);
+				return EXIT_FAILURE;
+			}
+		} else {
+			srcPaths.push_back(argv[n]);
+		}
+	}
+	if (srcPaths.empty()) {
+		printf("Usage: o2bbench [-n runs] [--dict dict] file [file...]\n");
+		printf("\t-n number of times each file is loaded (defaulting to %d)\n", O2B_BENCH_RUNS);
+		printf("\t--dict Zstandard dictionary the files were compressed with\n");
+		printf("Times are in microseconds: to load and decode each file, then also to\n");
+		printf("read every vertex, index and section byte (as an upload would)\n");
+		return EXIT_FAILURE;
+	}
+	printf("%-24s %-16s %-18s %10s %10s %10s %10s %10s %10s\n",
+		"file", "shortcode", "format", "bytes", "decoded", "load min", "load med", "used min", "used med");
+	bool valid = true;
+	for (std::vector<const char*>::const_iterator it = srcPaths.begin(); it != srcPaths.end(); ++it) {
+		valid &= bench(file, *it, runs);
+	}
+	return (valid) ? EXIT_SUCCESS : EXIT_FAILURE;
+}
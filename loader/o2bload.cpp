@@ -0,0 +1,656 @@
+/**
+ * \file o2bload.cpp
+ *
+ * \copyright 2022 Numfum GmbH
+ */
+#include "o2bload.h"
+
+#include <cstdio>
+#include <cstring>
+
+#if defined(__unix__) || defined(__APPLE__)
+#if !defined(__EMSCRIPTEN__)
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#define O2B_LOAD_HAS_MMAP 1
+#endif
+#endif
+
+#include "zstd.h"
+
+/**
+ * \def O2B_LOAD_METADATA_BYTES
+ * Size of the fixed part of the \c -m metadata (see the tool's \c
+ * O2B_METADATA_BYTES).
+ */
+#ifndef O2B_LOAD_METADATA_BYTES
+#define O2B_LOAD_METADATA_BYTES (2 + 4 + 5 * 4 + 6 * 4)
+#endif
+
+/**
+ * \def O2B_LOAD_CONTAINER_BYTES
+ * Size of the fixed part of the \c --v2 container's header (see the tool's \c
+ * O2B_CONTAINER_BYTES).
+ */
+#ifndef O2B_LOAD_CONTAINER_BYTES
+#define O2B_LOAD_CONTAINER_BYTES (4 + 4 + 4 + 4 + 4 + 4 + 8 + 4 + 4 + 6 * 4)
+#endif
+
+/**
+ * \def O2B_LOAD_CONTAINER_SECTION_BYTES
+ * Size of each entry in the \c --v2 container's section table.
+ */
+#ifndef O2B_LOAD_CONTAINER_SECTION_BYTES
+#define O2B_LOAD_CONTAINER_SECTION_BYTES (4 + 4 + 8 + 8)
+#endif
+
+namespace impl {
+/**
+ * Shortcode bits needed by the loader (see \c ToolOptions::Options).
+ */
+enum ShortcodeBits {
+	OPTS_BIG_ENDIAN = 7,  /**< Written big endian. */
+	OPTS_EXTENDED   = 11, /**< Extended options and section table follow the layout. */
+	IDXS_SHIFT      = 28, /**< Start of the index storage type. */
+};
+
+/**
+ * Bounds checked reader of the header's values, in the file's byte order.
+ * Reading past the end flags the reader as failed (returning zeros), so a
+ * run of reads only needs checking once.
+ */
+struct Reader {
+	/**
+	 * Creates a reader for the content.
+	 *
+	 * \param[in] data start of the content
+	 * \param[in] size number of bytes in the content
+	 * \param[in] offset position of the first read
+	 * \param[in] big \c true if the values are big endian
+	 */
+	Reader(const uint8_t* const data, size_t const size, size_t const offset, bool const big)
+		: data  (data)
+		, size  (size)
+		, pos   (offset)
+		, big   (big)
+		, failed(offset > size) {}
+
+	/**
+	 * Reads \a bytes as an unsigned integer.
+	 */
+	uint64_t read(unsigned const bytes) {
+		if (failed || size - pos < bytes) {
+			failed = true;
+			return 0;
+		}
+		uint64_t val = 0;
+		for (unsigned n = 0; n < bytes; n++) {
+			unsigned const shift = 8 * ((big) ? bytes - 1 - n : n);
+			val |= static_cast<uint64_t>(data[pos + n]) << shift;
+		}
+		pos += bytes;
+		return val;
+	}
+	uint8_t u8() {
+		return static_cast<uint8_t>(read(1));
+	}
+	uint32_t u32() {
+		return static_cast<uint32_t>(read(4));
+	}
+	uint64_t u64() {
+		// Written as two words, low first in little endian (so the same as a single read)
+		return read(8);
+	}
+	float f32() {
+		uint32_t const bits = u32();
+		float val;
+		memcpy(&val, &bits, sizeof val);
+		return val;
+	}
+
+	const uint8_t* data; /**< Start of the content. */
+	size_t size;         /**< Number of bytes in the content. */
+	size_t pos;          /**< Position of the next read. */
+	bool big;            /**< \c true if the values are big endian. */
+	bool failed;         /**< \c true if any read was out of bounds. */
+};
+
+/**
+ * Helper to return the number of bytes for an index storage type (the \c
+ * VertexPacker::Storage::Type from the shortcode).
+ *
+ * \param[in] type storage type
+ * \return bytes per index (or zero if unindexed)
+ */
+inline unsigned indexBytes(unsigned const type) {
+	if (type == 0) {
+		return 0;
+	}
+	if (type <= 4) {
+		return 1;
+	}
+	return (type <= 9) ? 2 : 4;
+}
+
+/**
+ * Helper to test whether a range lies within the content.
+ *
+ * \param[in] offset start of the range
+ * \param[in] bytes size of the range
+ * \param[in] size number of bytes in the content
+ * \return \c true if the range is within the content
+ */
+inline bool within(uint64_t const offset, uint64_t const bytes, size_t const size) {
+	return offset <= size && bytes <= size - offset;
+}
+
+/**
+ * Helper to return the value of a hex digit.
+ *
+ * \param[in] c character to convert
+ * \return the digit's value (or \c -1 if not a hex digit)
+ */
+inline int hexDigit(int const c) {
+	if (c >= '0' && c <= '9') {
+		return c - '0';
+	}
+	if (c >= 'A' && c <= 'F') {
+		return c - 'A' + 10;
+	}
+	if (c >= 'a' && c <= 'f') {
+		return c - 'a' + 10;
+	}
+	return -1;
+}
+
+/**
+ * Helper to decode the tool's ASCII output (comma separated \c 0xNN bytes).
+ *
+ * \param[in] text start of the text
+ * \param[in] size number of characters in the text
+ * \param[out] dst destination for the bytes
+ * \return \c true if the entire text was valid
+ */
+static bool unhex(const uint8_t* const text, size_t const size, std::vector<uint8_t>& dst) {
+	// Each byte takes at least five characters
+	dst.clear();
+	dst.reserve(size / 5 + 1);
+	size_t n = 0;
+	while (n < size) {
+		int const c = text[n];
+		if (c == ' ' || c == ',' || c == '\n' || c == '\r' || c == '\t') {
+			n++;
+			continue;
+		}
+		if (size - n < 4 || c != '0' || (text[n + 1] | 0x20) != 'x') {
+			return false;
+		}
+		int const hi = hexDigit(text[n + 2]);
+		int const lo = hexDigit(text[n + 3]);
+		if (hi < 0 || lo < 0) {
+			return false;
+		}
+		dst.push_back(static_cast<uint8_t>((hi << 4) | lo));
+		n += 4;
+	}
+	return true;
+}
+}
+
+//*****************************************************************************/
+
+unsigned BufferFile::Attribute::glType() const {
+	static const unsigned glTypes[] = {
+		0,      // TYPE_NONE
+		0x1400, // GL_BYTE
+		0x1401, // GL_UNSIGNED_BYTE
+		0x1402, // GL_SHORT
+		0x1403, // GL_UNSIGNED_SHORT
+		0x1404, // GL_INT
+		0x1405, // GL_UNSIGNED_INT
+		0x140B, // GL_HALF_FLOAT
+		0x1406, // GL_FLOAT
+		0x8D9F, // GL_INT_2_10_10_10_REV
+		0x8368, // GL_UNSIGNED_INT_2_10_10_10_REV
+		0x8C3B, // GL_UNSIGNED_INT_10F_11F_11F_REV
+	};
+	return (type < sizeof glTypes / sizeof glTypes[0]) ? glTypes[type] : 0;
+}
+
+//*****************************************************************************/
+
+BufferFile::BufferFile()
+	: head   (nullptr)
+	, used   (0)
+	, mapping(nullptr)
+	, mapped (0)
+	, dctx   (nullptr)
+	, ddict  (nullptr) {
+	reset();
+}
+
+BufferFile::~BufferFile() {
+	close();
+	ZSTD_freeDCtx(static_cast<ZSTD_DCtx*>(dctx));
+	ZSTD_freeDDict(static_cast<ZSTD_DDict*>(ddict));
+}
+
+bool BufferFile::setDictionary(const void* const dict, size_t const size) {
+	ZSTD_freeDDict(static_cast<ZSTD_DDict*>(ddict));
+	ddict = nullptr;
+	if (dict && size) {
+		ddict = ZSTD_createDDict(dict, size);
+		if (!ddict) {
+			fprintf(stderr, "Invalid dictionary\n");
+			return false;
+		}
+	}
+	return true;
+}
+
+bool BufferFile::open(const char* const srcPath) {
+	close();
+	if (!srcPath) {
+		return false;
+	}
+#ifdef O2B_LOAD_HAS_MMAP
+	int const fd = ::open(srcPath, O_RDONLY);
+	if (fd >= 0) {
+		struct stat info;
+		if (fstat(fd, &info) == 0 && S_ISREG(info.st_mode) && info.st_size > 0) {
+			void* const data = mmap(nullptr, static_cast<size_t>(info.st_size), PROT_READ, MAP_PRIVATE, fd, 0);
+			if (data != MAP_FAILED) {
+				mapping = data;
+				mapped  = static_cast<size_t>(info.st_size);
+				head    = static_cast<const uint8_t*>(data);
+				used    = mapped;
+			}
+		}
+		::close(fd);
+	}
+#endif
+	if (!mapping) {
+		// No mapping (or it failed) so fall back to reading the content
+		if (FILE* srcFile = fopen(srcPath, "rb")) {
+			if (fseek(srcFile, 0, SEEK_END) == 0) {
+				long const size = ftell(srcFile);
+				if (size > 0 && fseek(srcFile, 0, SEEK_SET) == 0) {
+					owned.resize(static_cast<size_t>(size));
+					if (fread(owned.data(), 1, owned.size(), srcFile) == owned.size()) {
+						head = owned.data();
+						used = owned.size();
+					}
+				}
+			}
+			fclose(srcFile);
+		}
+	}
+	if (!head) {
+		fprintf(stderr, "Unable to read: %s\n", srcPath);
+		close();
+		return false;
+	}
+	if (!decode()) {
+		fprintf(stderr, "Invalid obj2buf file: %s\n", srcPath);
+		close();
+		return false;
+	}
+	return true;
+}
+
+bool BufferFile::parse(const void* const data, size_t const size) {
+	close();
+	if (!data || !size) {
+		return false;
+	}
+	head = static_cast<const uint8_t*>(data);
+	used = size;
+	if (!decode()) {
+		close();
+		return false;
+	}
+	return true;
+}
+
+void BufferFile::close() {
+#ifdef O2B_LOAD_HAS_MMAP
+	if (mapping) {
+		munmap(mapping, mapped);
+	}
+#endif
+	mapping = nullptr;
+	mapped  = 0;
+	owned.clear();
+	head = nullptr;
+	used = 0;
+	reset();
+}
+
+const BufferFile::Section* BufferFile::find(uint32_t const id) const {
+	for (std::vector<Section>::const_iterator it = sections.begin(); it != sections.end(); ++it) {
+		if (it->id == id) {
+			return &*it;
+		}
+	}
+	return nullptr;
+}
+
+void BufferFile::reset() {
+	version     = 0;
+	shortcode   = 0;
+	extended    = 0;
+	bigEndian   = false;
+	compressed  = false;
+	ascii       = false;
+	align       = 1;
+	for (unsigned n = 0; n < 3; n++) {
+		scale[n] = 1.0f;
+		bias [n] = 0.0f;
+	}
+	packTans    = 0;
+	packSign    = 0;
+	memset(attrs, 0, sizeof attrs);
+	stride      = 0;
+	streams     = 0;
+	for (unsigned n = 0; n < O2B_LOAD_MAX_STREAMS; n++) {
+		strides [n] = 0;
+		vertices[n] = nullptr;
+	}
+	vertexCount = 0;
+	vertexBytes = 0;
+	indices     = nullptr;
+	indexSize   = 0;
+	indexCount  = 0;
+	drawCount   = 0;
+	sections.clear();
+}
+
+bool BufferFile::decode() {
+	/*
+	 * ASCII files are decoded first then, since compression happens before
+	 * the ASCII encoding, any Zstandard frame. Once decoded the mapping is
+	 * no longer needed.
+	 */
+	if (used >= 4 && head[0] == '0' && (head[1] | 0x20) == 'x') {
+		std::vector<uint8_t> binary;
+		if (!impl::unhex(head, used, binary) || binary.empty()) {
+			fprintf(stderr, "Invalid ASCII content\n");
+			return false;
+		}
+		owned.swap(binary);
+		head  = owned.data();
+		used  = owned.size();
+		ascii = true;
+	}
+	if (used >= 4 && head[0] == 0x28 && head[1] == 0xB5 && head[2] == 0x2F && head[3] == 0xFD) {
+		// The tool always records the content size (including when streaming)
+		unsigned long long const size = ZSTD_getFrameContentSize(head, used);
+		if (size == ZSTD_CONTENTSIZE_UNKNOWN || size == ZSTD_CONTENTSIZE_ERROR || size > SIZE_MAX) {
+			fprintf(stderr, "Unknown decompressed size\n");
+			return false;
+		}
+		/*
+		 * The recorded size is only a header field, so before allocating it's
+		 * checked against the most the content could decompress to (a damaged
+		 * or malicious header would otherwise ask for anything). Each block
+		 * has at least a 3-byte header and decodes to at most a full block.
+		 */
+		unsigned long long const bound = (used / 3 + 1) * static_cast<unsigned long long>(ZSTD_BLOCKSIZE_MAX);
+		if (size > bound) {
+			fprintf(stderr, "Invalid decompressed size\n");
+			return false;
+		}
+		if (!dctx) {
+			dctx = ZSTD_createDCtx();
+			if (!dctx) {
+				return false;
+			}
+		}
+		std::vector<uint8_t> decomp(static_cast<size_t>(size));
+		size_t const done = (ddict)
+			? ZSTD_decompress_usingDDict(static_cast<ZSTD_DCtx*>(dctx), decomp.data(), decomp.size(), head, used, static_cast<ZSTD_DDict*>(ddict))
+			: ZSTD_decompressDCtx       (static_cast<ZSTD_DCtx*>(dctx), decomp.data(), decomp.size(), head, used);
+		if (ZSTD_isError(done) || done != decomp.size()) {
+			fprintf(stderr, "Decompression failed: %s\n", (ZSTD_isError(done)) ? ZSTD_getErrorName(done) : "truncated");
+			return false;
+		}
+		owned.swap(decomp);
+		head = owned.data();
+		used = owned.size();
+		compressed = true;
+	}
+#ifdef O2B_LOAD_HAS_MMAP
+	if (mapping && !owned.empty()) {
+		munmap(mapping, mapped);
+		mapping = nullptr;
+		mapped  = 0;
+	}
+#endif
+	// Tested as bytes, the magic gives the byte order
+	if (used >= 2 && ((head[0] == 0xA7 && head[1] == 0xBD) || (head[0] == 0xBD && head[1] == 0xA7))) {
+		bigEndian = head[0] == 0xBD;
+		return decodeV1();
+	}
+	if (used >= 4 && memcmp(head, "O2B2", 4) == 0) {
+		return decodeV2();
+	}
+	if (used >= 4 && memcmp(head, "2B2O", 4) == 0) {
+		bigEndian = true;
+		return decodeV2();
+	}
+	fprintf(stderr, "No obj2buf metadata (written with -m or --v2)\n");
+	return false;
+}
+
+bool BufferFile::decodeV1() {
+	impl::Reader reader(head, used, 2, bigEndian);
+	version = 1;
+	shortcode = reader.u32();
+	uint32_t const headerBytes = reader.u32();
+	uint32_t const vertBytes   = reader.u32();
+	uint32_t const indexOffset = reader.u32();
+	uint32_t const indexBytes  = reader.u32();
+	uint32_t const draw        = reader.u32();
+	for (unsigned n = 0; n < 3; n++) {
+		scale[n] = reader.f32();
+	}
+	for (unsigned n = 0; n < 3; n++) {
+		bias [n] = reader.f32();
+	}
+	if (reader.failed || reader.pos != O2B_LOAD_METADATA_BYTES
+			|| ((shortcode >> impl::OPTS_BIG_ENDIAN) & 1) != static_cast<unsigned>(bigEndian)) {
+		fprintf(stderr, "Invalid metadata header\n");
+		return false;
+	}
+	size_t const layoutBytes = decodeLayout(reader.pos);
+	if (!layoutBytes) {
+		return false;
+	}
+	reader.pos += layoutBytes;
+	if ((shortcode >> impl::OPTS_EXTENDED) & 1) {
+		extended = reader.u32();
+		uint32_t const count = reader.u32();
+		if (reader.failed || count > (used - reader.pos) / 16) {
+			fprintf(stderr, "Invalid section table\n");
+			return false;
+		}
+		for (uint32_t n = 0; n < count; n++) {
+			Section section;
+			section.id    = reader.u32();
+			uint32_t const offset = reader.u32();
+			section.bytes = reader.u32();
+			section.count = reader.u32();
+			if (!impl::within(offset, section.bytes, used)) {
+				fprintf(stderr, "Section %u out of bounds\n", section.id);
+				return false;
+			}
+			section.data = head + offset;
+			sections.push_back(section);
+		}
+	}
+	// The offsets are written for the exact sizes, so should all agree
+	if (reader.failed || headerBytes != reader.pos
+			|| static_cast<uint64_t>(headerBytes) + vertBytes != indexOffset
+			|| !impl::within(indexOffset, indexBytes, used)) {
+		fprintf(stderr, "Invalid metadata offsets\n");
+		return false;
+	}
+	indexSize = impl::indexBytes(shortcode >> impl::IDXS_SHIFT);
+	if (!stride || vertBytes % stride || (indexSize && indexBytes % indexSize) || (!indexSize && indexBytes)) {
+		fprintf(stderr, "Invalid vertex or index sizes\n");
+		return false;
+	}
+	vertexBytes = vertBytes;
+	vertexCount = vertBytes / stride;
+	// Each stream follows the previous (all with the same vertex count)
+	size_t offset = headerBytes;
+	for (unsigned s = 0; s < streams; s++) {
+		vertices[s] = head + offset;
+		offset += vertexCount * strides[s];
+	}
+	if (indexSize) {
+		indices    = head + indexOffset;
+		indexCount = indexBytes / indexSize;
+		drawCount  = draw;
+	} else {
+		// Unindexed draws the full detail vertices (written as zero)
+		drawCount = vertexCount;
+		const Section* const lods = find(SECTION_LODS);
+		if (lods && lods->bytes >= 8) {
+			impl::Reader lod(lods->data, lods->bytes, 4, bigEndian);
+			drawCount = lod.u32();
+		}
+	}
+	return true;
+}
+
+bool BufferFile::decodeV2() {
+	impl::Reader reader(head, used, 4, bigEndian);
+	version   = reader.u32();
+	shortcode = reader.u32();
+	extended  = reader.u32();
+	align     = reader.u32();
+	uint32_t const count    = reader.u32();
+	uint64_t const fileSize = reader.u64();
+	uint32_t const draw     = reader.u32();
+	uint32_t const layoutBytes = reader.u32();
+	for (unsigned n = 0; n < 3; n++) {
+		scale[n] = reader.f32();
+	}
+	for (unsigned n = 0; n < 3; n++) {
+		bias [n] = reader.f32();
+	}
+	if (reader.failed || reader.pos != O2B_LOAD_CONTAINER_BYTES || version != 2 || fileSize != used || !align || (align & (align - 1))
+			|| ((shortcode >> impl::OPTS_BIG_ENDIAN) & 1) != static_cast<unsigned>(bigEndian)) {
+		fprintf(stderr, "Invalid container header (version %u)\n", version);
+		return false;
+	}
+	if (decodeLayout(reader.pos) != layoutBytes) {
+		fprintf(stderr, "Invalid container layout\n");
+		return false;
+	}
+	// The table starts 8-byte aligned
+	reader.pos = (reader.pos + layoutBytes + 7) & ~static_cast<size_t>(7);
+	if (reader.pos > used || count > (used - reader.pos) / O2B_LOAD_CONTAINER_SECTION_BYTES) {
+		fprintf(stderr, "Invalid section table\n");
+		return false;
+	}
+	indexSize = impl::indexBytes(shortcode >> impl::IDXS_SHIFT);
+	unsigned nextStream = 0;
+	for (uint32_t n = 0; n < count; n++) {
+		uint32_t const id     = reader.u32();
+		uint32_t const num    = reader.u32();
+		uint64_t const offset = reader.u64();
+		uint64_t const bytes  = reader.u64();
+		if (!impl::within(offset, bytes, used) || (offset & (align - 1))) {
+			fprintf(stderr, "Section %u out of bounds\n", id);
+			return false;
+		}
+		switch (id) {
+		case SECTION_VERTICES:
+			if (nextStream >= streams || (nextStream > 0 && num != vertexCount) || bytes != static_cast<uint64_t>(num) * strides[nextStream]) {
+				fprintf(stderr, "Invalid vertex stream %u\n", nextStream);
+				return false;
+			}
+			vertexCount = num;
+			vertexBytes += static_cast<size_t>(bytes);
+			vertices[nextStream++] = head + offset;
+			break;
+		case SECTION_INDICES:
+			if (!indexSize || bytes != static_cast<uint64_t>(num) * indexSize) {
+				fprintf(stderr, "Invalid indices\n");
+				return false;
+			}
+			indices    = head + offset;
+			indexCount = num;
+			break;
+		default:
+			Section section;
+			section.id    = id;
+			section.count = num;
+			section.data  = head + offset;
+			section.bytes = static_cast<size_t>(bytes);
+			sections.push_back(section);
+		}
+	}
+	if (nextStream != streams || (indexSize && !indices)) {
+		fprintf(stderr, "Missing vertex or index sections\n");
+		return false;
+	}
+	drawCount = draw;
+	return true;
+}
+
+size_t BufferFile::decodeLayout(size_t const offset) {
+	impl::Reader reader(head, used, offset, bigEndian);
+	packTans = reader.u8();
+	packSign = reader.u8();
+	stride   = reader.u8();
+	unsigned const count = reader.u8();
+	if (reader.failed || count > ATTR_COUNT) {
+		fprintf(stderr, "Invalid layout header\n");
+		return 0;
+	}
+	streams = 1;
+	for (unsigned n = 0; n < count; n++) {
+		unsigned const index = reader.u8();
+		unsigned const size  = reader.u8();
+		unsigned const type  = reader.u8();
+		unsigned const start = reader.u8();
+		unsigned const id    = index & 0xF;
+		unsigned const s     = index >> 4;
+		if (reader.failed || id >= ATTR_COUNT || attrs[id].valid() || s >= O2B_LOAD_MAX_STREAMS
+				|| size < 1 || size > 4 || (type & 0x7F) < 1 || (type & 0x7F) > 11) {
+			fprintf(stderr, "Invalid attribute %u\n", n);
+			return 0;
+		}
+		attrs[id].stream     = s;
+		attrs[id].components = size;
+		attrs[id].type       = type & 0x7F;
+		attrs[id].normalized = (type & 0x80) != 0;
+		attrs[id].offset     = start;
+		if (s >= streams) {
+			streams = s + 1;
+		}
+	}
+	if (streams > 1) {
+		// Then each stream's stride (padded to a multiple of four)
+		unsigned total = 0;
+		for (unsigned n = 0; n < ((streams + 3) & ~3U); n++) {
+			unsigned const bytes = reader.u8();
+			if (n < streams) {
+				strides[n] = bytes;
+				total += bytes;
+			}
+		}
+		if (reader.failed || total != stride) {
+			fprintf(stderr, "Invalid stream strides\n");
+			return 0;
+		}
+	} else {
+		strides[0] = stride;
+	}
+	return reader.pos - offset;
+}
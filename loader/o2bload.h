@@ -0,0 +1,262 @@
+/**
+ * \file o2bload.h
+ * Runtime loader for \c obj2buf output written with metadata (\c -m or \c
+ * --v2), independent of the tool itself (needing only Zstandard).
+ *
+ * \copyright 2022 Numfum GmbH
+ */
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+/**
+ * \def O2B_LOAD_MAX_STREAMS
+ * Maximum number of vertex streams (one per attribute, see \c
+ * BufferFile#ATTR_COUNT).
+ */
+#ifndef O2B_LOAD_MAX_STREAMS
+#define O2B_LOAD_MAX_STREAMS 8
+#endif
+
+/**
+ * A loaded \c obj2buf file: the header validated and decoded, with pointers to
+ * the vertex, index and extra sections. Uncompressed binary files are mapped
+ * and the pointers are into the mapping (so nothing is copied, and each page
+ * is only read once it's used); compressed (\c -z) or ASCII (\c -a) files are
+ * first decoded into a buffer owned by the file. Usage:
+ * \code
+ *	BufferFile file;
+ *	if (file.open("bunny.bin")) {
+ *		const BufferFile::Attribute& posn = file.attrs[BufferFile::ATTR_POSN];
+ *		glBufferData(GL_ARRAY_BUFFER, file.vertexBytes, file.vertices[0], GL_STATIC_DRAW);
+ *		glVertexAttribPointer(BufferFile::ATTR_POSN, posn.components, posn.glType(), posn.normalized,
+ *			file.strides[posn.stream], reinterpret_cast<const void*>(posn.offset));
+ *	}
+ * \endcode
+ * \note The header is read in the file's byte order but the vertex, index and
+ * section data are as stored, so for files written with \c -e check \c
+ * #bigEndian against the target's byte order.
+ */
+class BufferFile
+{
+public:
+	/**
+	 * Vertex attribute IDs, as stored in the metadata (matching \c
+	 * BufferLayout::VertexID).
+	 */
+	enum AttrID {
+		ATTR_POSN  = 0, /**< Vertex positions. */
+		ATTR_TEX0  = 1, /**< Vertex texture coordinates channel 0. */
+		ATTR_TEX1  = 2, /**< Vertex texture coordinates channel 1. */
+		ATTR_NORM  = 3, /**< Vertex normals. */
+		ATTR_TANS  = 4, /**< Vertex tangents. */
+		ATTR_BTAN  = 5, /**< Vertex bitangents. */
+		ATTR_RGBA  = 6, /**< Vertex colours. */
+		ATTR_QTAN  = 7, /**< Vertex QTangents. */
+		ATTR_COUNT = 8, /**< Number of attribute IDs. */
+	};
+
+	/**
+	 * Section IDs, as stored in the metadata's section table (matching the
+	 * tool's \c SectionID).
+	 */
+	enum SectionID {
+		SECTION_LODS           = 1, /**< LOD ranges (first, count and error). */
+		SECTION_MESHLETS       = 2, /**< Meshlet descriptors. */
+		SECTION_MESHLET_VERTS  = 3, /**< Meshlet vertices. */
+		SECTION_MESHLET_TRIS   = 4, /**< Meshlet triangles. */
+		SECTION_MESHLET_BOUNDS = 5, /**< Meshlet culling bounds. */
+		SECTION_CHUNKS         = 6, /**< Chunks of a split mesh. */
+		SECTION_SHADOW         = 7, /**< Shadow index buffer. */
+		SECTION_VERTICES       = 8, /**< Vertex data of one stream. */
+		SECTION_INDICES        = 9, /**< Index data. */
+	};
+
+	/**
+	 * A single vertex attribute, decoded from the layout header.
+	 */
+	struct Attribute {
+		unsigned stream;     /**< Vertex stream containing the attribute. */
+		unsigned components; /**< Number of components (\c 1 to \c 4, or zero if the attribute is missing). */
+		unsigned type;       /**< Basic type (see \c VertexPacker::Storage::BasicType, or zero if missing). */
+		bool normalized;     /**< \c true if integer types are normalised. */
+		unsigned offset;     /**< Offset from the start of each vertex in the stream. */
+
+		/**
+		 * Tests whether the attribute exists.
+		 */
+		bool valid() const {
+			return components != 0;
+		}
+
+		/**
+		 * Returns the GL equivalent of the basic type (e.g. \c GL_FLOAT for
+		 * \c TYPE_FLOAT), to pass straight to \c glVertexAttribPointer().
+		 *
+		 * \return GL type (or zero if the attribute is missing)
+		 */
+		unsigned glType() const;
+	};
+
+	/**
+	 * A section of the file (from the metadata's section table).
+	 */
+	struct Section {
+		uint32_t id;          /**< Section type (see \c #SectionID). */
+		uint32_t count;       /**< Number of entries in the section. */
+		const uint8_t* data;  /**< Start of the section's content. */
+		size_t bytes;         /**< Size of the section in bytes. */
+	};
+
+	/**
+	 * Creates an unopened file.
+	 */
+	BufferFile();
+
+	/**
+	 * Closes the file (if still open) and frees the decompression state.
+	 */
+	~BufferFile();
+
+	/**
+	 * Sets the Zstandard dictionary needed to decompress files written with
+	 * \c --dict (the dictionary is digested once and used for every
+	 * subsequent file).
+	 *
+	 * \param[in] dict dictionary content (or \c null to remove the dictionary)
+	 * \param[in] size number of bytes in the dictionary
+	 * \return \c true if the dictionary was set
+	 */
+	bool setDictionary(const void* const dict, size_t const size);
+
+	/**
+	 * Opens and decodes a file (closing any previous file).
+	 *
+	 * \param[in] srcPath filename of the \c obj2buf output
+	 * \return \c true if the file was valid (otherwise the reason is logged and the file is closed)
+	 */
+	bool open(const char* const srcPath);
+
+	/**
+	 * Decodes a file already in memory (closing any previous file), for
+	 * example an ASCII file compiled into the application. Uncompressed
+	 * binary content is used in-place (and must outlive the file).
+	 *
+	 * \note Only the \c --v2 container aligns its sections (to \c #align
+	 * from the start of the content, so the content itself should be at
+	 * least as aligned). With \c -m the vertices directly follow the
+	 * variable sized header, so are only byte aligned.
+	 *
+	 * \param[in] data start of the file's content
+	 * \param[in] size number of bytes in the content
+	 * \return \c true if the content was valid (otherwise the reason is logged and the file is closed)
+	 */
+	bool parse(const void* const data, size_t const size);
+
+	/**
+	 * Closes the file, invalidating every pointer into its content.
+	 */
+	void close();
+
+	/**
+	 * Finds the first section with the given ID.
+	 *
+	 * \param[in] id section type (see \c #SectionID)
+	 * \return the section (or \c null if the file has no such section)
+	 */
+	const Section* find(uint32_t const id) const;
+
+	/**
+	 * Tests whether the file's pointers are into the mapping (or the caller's
+	 * content) rather than a decoded copy.
+	 */
+	bool zeroCopy() const {
+		return owned.empty();
+	}
+
+	/**
+	 * Start of the decoded content (the entire file, after decompressing).
+	 */
+	const uint8_t* data() const {
+		return head;
+	}
+
+	/**
+	 * Number of bytes in the decoded content.
+	 */
+	size_t size() const {
+		return used;
+	}
+
+	unsigned version;      /**< Metadata version (\c 1 for \c -m, \c 2 for \c --v2). */
+	uint32_t shortcode;    /**< Shortcode (the options as passed with \c -c). */
+	uint32_t extended;     /**< Extended options (the upper word of the shortcode, or zero). */
+	bool bigEndian;        /**< \c true if the file was written big endian (\c -e). */
+	bool compressed;       /**< \c true if the file was Zstandard compressed (\c -z). */
+	bool ascii;            /**< \c true if the file was ASCII encoded (\c -a). */
+	unsigned align;        /**< Section alignment from the start of the file (\c 1 for \c -m files, see \c #parse()). */
+	float scale[3];        /**< Mesh scale (to restore the original positions). */
+	float bias[3];         /**< Mesh bias (to restore the original positions). */
+	unsigned packTans;     /**< Where the encoded tangents were packed (see \c BufferLayout::Packing). */
+	unsigned packSign;     /**< Where the bitangent sign was packed (see \c BufferLayout::Packing). */
+	Attribute attrs[ATTR_COUNT]; /**< Each attribute, indexed by \c #AttrID. */
+	unsigned stride;       /**< Bytes per complete vertex (across all streams). */
+	unsigned streams;      /**< Number of vertex streams (\c 1 if interleaved). */
+	unsigned strides [O2B_LOAD_MAX_STREAMS]; /**< Bytes between each vertex in each stream. */
+	const uint8_t* vertices[O2B_LOAD_MAX_STREAMS]; /**< Start of each vertex stream. */
+	size_t vertexCount;    /**< Number of vertices (in each stream). */
+	size_t vertexBytes;    /**< Size of all the vertex streams in bytes. */
+	const void* indices;   /**< Start of the index data (or \c null if unindexed). */
+	unsigned indexSize;    /**< Bytes per index (\c 1, \c 2 or \c 4, or zero if unindexed). */
+	size_t indexCount;     /**< Number of indices (including any LODs). */
+	size_t drawCount;      /**< Indices (or, if unindexed, vertices) in the full detail mesh. */
+	std::vector<Section> sections; /**< Extra sections following the indices (LODs, meshlets, etc.). */
+
+private:
+	BufferFile    (const BufferFile&) = delete; /**< Not copyable   */
+	void operator=(const BufferFile&) = delete; /**< Not assignable */
+
+	/**
+	 * Clears the decoded header and pointers (leaving the content).
+	 */
+	void reset();
+
+	/**
+	 * Decodes the content (if compressed or ASCII) then the header.
+	 *
+	 * \return \c true if the content was valid
+	 */
+	bool decode();
+
+	/**
+	 * Decodes the original \c -m metadata (starting with \c 0xBDA7).
+	 *
+	 * \return \c true if the metadata was valid
+	 */
+	bool decodeV1();
+
+	/**
+	 * Decodes the \c --v2 container (starting with \c O2B2).
+	 *
+	 * \return \c true if the container was valid
+	 */
+	bool decodeV2();
+
+	/**
+	 * Decodes the layout header (common to both versions).
+	 *
+	 * \param[in] offset offset of the layout from the start of the content
+	 * \return size of the layout in bytes (or zero if it was invalid)
+	 */
+	size_t decodeLayout(size_t const offset);
+
+	const uint8_t* head;        /**< Start of the content (mapped, the caller's or \c #owned). */
+	size_t used;                /**< Number of bytes in the content. */
+	void* mapping;              /**< Start of the mapping (or \c null if not mapped). */
+	size_t mapped;              /**< Number of bytes mapped. */
+	std::vector<uint8_t> owned; /**< Decoded content (if compressed or ASCII). */
+	void* dctx;                 /**< Reusable Zstandard decompression context. */
+	void* ddict;                /**< Digested dictionary (or \c null if not set). */
+};
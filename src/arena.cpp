@@ -0,0 +1,361 @@
+/**
+ * \file arena.cpp
+ *
+ * \copyright 2022 Numfum GmbH
+ */
+#include "arena.h"
+
+#include <cassert>
+#include <cstdlib>
+#include <cstring>
+
+#include <algorithm>
+
+#ifdef __linux__
+#include <sys/mman.h>
+#endif
+
+/**
+ * \def O2B_ARENA_ALIGN
+ * Alignment of each allocation, which is also the size of the header
+ * preceding it (storing the allocation's owner and capacity, for freeing,
+ * resizing and reuse).
+ */
+#ifndef O2B_ARENA_ALIGN
+#define O2B_ARENA_ALIGN 16
+#endif
+
+/**
+ * \def O2B_HUGE_PAGE_SIZE
+ * Size of a huge page (blocks backed by huge pages are a multiple of this).
+ */
+#ifndef O2B_HUGE_PAGE_SIZE
+#define O2B_HUGE_PAGE_SIZE (2 * 1024 * 1024)
+#endif
+
+namespace impl {
+/**
+ * The thread's current arena (see \c Arena#Scope).
+ */
+static thread_local Arena* current = nullptr;
+/**
+ * Helper to round a size up to a multiple of a power of two.
+ *
+ * \param[in] size size to round
+ * \param[in] align power of two to round to
+ * \return \a size rounded up
+ */
+inline size_t roundUp(size_t const size, size_t const align) {
+	return (size + align - 1) & ~(align - 1);
+}
+/**
+ * Helper to return the index of the highest set bit (the integer log2).
+ *
+ * \param[in] val value to test (non-zero)
+ * \return log2 of \a val rounded down
+ */
+inline unsigned floorLog2(size_t val) {
+	unsigned n = 0;
+	while (val >>= 1) {
+		n++;
+	}
+	return n;
+}
+/**
+ * Header preceding each allocation, including those the static functions
+ * make with \c malloc() (so every allocation knows where to be freed).
+ */
+struct BlockHeader {
+	Arena* owner;    /**< Arena allocated from (or \c null if from \c malloc()). */
+	size_t capacity; /**< Usable number of bytes (kept when a freed allocation is reused). */
+};
+static_assert(sizeof(BlockHeader) <= O2B_ARENA_ALIGN, "Arena header larger than the alignment");
+/**
+ * Helper to return the header preceding an allocation.
+ *
+ * \param[in] ptr start of the allocation
+ * \return the allocation's header
+ */
+inline BlockHeader* header(void* const ptr) {
+	return reinterpret_cast<BlockHeader*>(static_cast<uint8_t*>(ptr) - O2B_ARENA_ALIGN);
+}
+/**
+ * Helper to allocate with \c malloc(), preceded by an unowned header.
+ *
+ * \param[in] size number of bytes to allocate
+ * \return start of the allocation (or \c null if allocation failed)
+ */
+void* mallocWithHeader(size_t const size) {
+	if (size > SIZE_MAX - O2B_ARENA_ALIGN) {
+		return nullptr;
+	}
+	uint8_t* const base = static_cast<uint8_t*>(malloc(O2B_ARENA_ALIGN + size));
+	if (!base) {
+		return nullptr;
+	}
+	BlockHeader* const head = reinterpret_cast<BlockHeader*>(base);
+	head->owner    = nullptr;
+	head->capacity = size;
+	return base + O2B_ARENA_ALIGN;
+}
+/**
+ * Helper to resize an allocation from \c #mallocWithHeader() with \c
+ * realloc() (which the system may do without copying).
+ *
+ * \param[in] ptr previous allocation
+ * \param[in] size new number of bytes
+ * \return start of the resized allocation (or \c null if allocation failed)
+ */
+void* reallocWithHeader(void* const ptr, size_t const size) {
+	if (size > SIZE_MAX - O2B_ARENA_ALIGN) {
+		return nullptr;
+	}
+	uint8_t* const base = static_cast<uint8_t*>(::realloc(header(ptr), O2B_ARENA_ALIGN + size));
+	if (!base) {
+		return nullptr;
+	}
+	reinterpret_cast<BlockHeader*>(base)->capacity = size;
+	return base + O2B_ARENA_ALIGN;
+}
+}
+
+//*****************************************************************************/
+
+Arena::Scope::Scope(Arena& arena)
+	: prev(impl::current) {
+	impl::current = &arena;
+}
+
+Arena::Scope::~Scope() {
+	impl::current = prev;
+}
+
+//*****************************************************************************/
+
+Arena::Arena(bool const hugePages)
+	: used     (0)
+	, last     (nullptr)
+	, hugePages(hugePages) {
+	clearFreed();
+}
+
+Arena::~Arena() {
+	freeBlocks();
+}
+
+void* Arena::alloc(size_t const size) {
+	size_t const capacity = impl::roundUp(size, O2B_ARENA_ALIGN);
+	if (capacity > O2B_ARENA_ALIGN) {
+		/*
+		 * Everything in the list one size up is guaranteed to fit (the list
+		 * for the request's own size may hold smaller allocations).
+		 */
+		unsigned const list = impl::floorLog2(capacity - 1) + 1;
+		if (list < FREE_LISTS && freed[list]) {
+			uint8_t* const data = freed[list];
+			memcpy(&freed[list], data, sizeof data);
+			return data;
+		}
+	}
+	size_t const need = O2B_ARENA_ALIGN + capacity;
+	if (blocks.empty() || used + need > blocks.back().size) {
+		if (!addBlock(std::max<size_t>(need, O2B_ARENA_BLOCK))) {
+			return nullptr;
+		}
+	}
+	last = blocks.back().data + used + O2B_ARENA_ALIGN;
+	impl::header(last)->owner    = this;
+	impl::header(last)->capacity = capacity;
+	used += need;
+	return last;
+}
+
+void* Arena::realloc(void* const ptr, size_t const size) {
+	if (!ptr) {
+		return alloc(size);
+	}
+	uint8_t* const data = static_cast<uint8_t*>(ptr);
+	impl::BlockHeader* const head = impl::header(data);
+	assert(head->owner == this);
+	if (data == last) {
+		// The most recent allocation can grow (or shrink) in-place if it fits
+		size_t const start = static_cast<size_t>(data - blocks.back().data);
+		size_t const end   = start + impl::roundUp(size, O2B_ARENA_ALIGN);
+		if (end <= blocks.back().size) {
+			head->capacity = end - start;
+			used = end;
+			return data;
+		}
+	} else if (size <= head->capacity) {
+		return data;
+	}
+	void* const next = alloc(size);
+	if (next) {
+		memcpy(next, data, std::min(size, head->capacity));
+		free(data);
+	}
+	return next;
+}
+
+void Arena::free(void* const ptr) {
+	if (ptr) {
+		uint8_t* const data = static_cast<uint8_t*>(ptr);
+		assert(impl::header(data)->owner == this);
+		if (data == last) {
+			used = static_cast<size_t>(last - O2B_ARENA_ALIGN - blocks.back().data);
+			last = nullptr;
+		} else {
+			size_t const capacity = impl::header(data)->capacity;
+			if (capacity >= sizeof data) {
+				// Link into the list for its size (using the content)
+				unsigned const list = impl::floorLog2(capacity);
+				memcpy(data, &freed[list], sizeof data);
+				freed[list] = data;
+			}
+		}
+	}
+}
+
+void Arena::reset() {
+	if (blocks.size() > 1) {
+		// Replace the blocks with one large enough for them all (for next time)
+		size_t total = 0;
+		for (std::vector<Block>::const_iterator it = blocks.begin(); it != blocks.end(); ++it) {
+			total += it->size;
+		}
+		freeBlocks();
+		addBlock(total);
+	}
+	clearFreed();
+	used = 0;
+	last = nullptr;
+}
+
+bool Arena::owns(const void* const ptr) const {
+	const uint8_t* const data = static_cast<const uint8_t*>(ptr);
+	for (std::vector<Block>::const_iterator it = blocks.begin(); it != blocks.end(); ++it) {
+		if (data >= it->data && data < it->data + it->size) {
+			return true;
+		}
+	}
+	return false;
+}
+
+void* Arena::allocate(size_t size) {
+	Arena* const arena = impl::current;
+	if (arena && size < O2B_ARENA_LARGE) {
+		return arena->alloc(size);
+	}
+	return impl::mallocWithHeader(size);
+}
+
+void* Arena::reallocate(void* ptr, size_t size) {
+	if (!ptr) {
+		return allocate(size);
+	}
+	Arena* const owner = impl::header(ptr)->owner;
+	if (!owner) {
+		// Once from the system it stays there (with any further growth left to it)
+		return impl::reallocWithHeader(ptr, size);
+	}
+	Arena* const arena = impl::current;
+	if (owner == arena && size < O2B_ARENA_LARGE) {
+		return arena->realloc(ptr, size);
+	}
+	// Outgrown the arena (or from another arena) so moved
+	void* const next = (arena && size < O2B_ARENA_LARGE) ? arena->alloc(size) : impl::mallocWithHeader(size);
+	if (next) {
+		memcpy(next, ptr, std::min(size, impl::header(ptr)->capacity));
+		release(ptr);
+	}
+	return next;
+}
+
+void Arena::release(void* ptr) {
+	if (ptr) {
+		Arena* const owner = impl::header(ptr)->owner;
+		if (!owner) {
+			::free(impl::header(ptr));
+		} else if (owner == impl::current) {
+			owner->free(ptr);
+		}
+		/*
+		 * Otherwise it's from another arena (possibly another thread's, so
+		 * not safe to touch) and is left for that arena's reset.
+		 */
+	}
+}
+
+bool Arena::addBlock(size_t const size) {
+	Block block;
+	block.data   = nullptr;
+	block.size   = size;
+	block.mapped = false;
+#ifdef __linux__
+	if (hugePages) {
+		/*
+		 * Transparent huge pages are only a hint (if they're disabled or
+		 * unavailable the mapping still succeeds with regular pages).
+		 */
+		block.size = impl::roundUp(size, O2B_HUGE_PAGE_SIZE);
+		void* const data = mmap(nullptr, block.size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+		if (data != MAP_FAILED) {
+		#ifdef MADV_HUGEPAGE
+			madvise(data, block.size, MADV_HUGEPAGE);
+		#endif
+			block.data   = static_cast<uint8_t*>(data);
+			block.mapped = true;
+		}
+	}
+#endif
+	if (!block.data) {
+		block.size = size;
+		block.data = static_cast<uint8_t*>(malloc(size));
+		if (!block.data) {
+			return false;
+		}
+	}
+	blocks.push_back(block);
+	used = 0;
+	last = nullptr;
+	return true;
+}
+
+void Arena::freeBlocks() {
+	for (std::vector<Block>::const_iterator it = blocks.begin(); it != blocks.end(); ++it) {
+	#ifdef __linux__
+		if (it->mapped) {
+			munmap(it->data, it->size);
+			continue;
+		}
+	#endif
+		::free(it->data);
+	}
+	blocks.clear();
+	clearFreed();
+	used = 0;
+	last = nullptr;
+}
+
+void Arena::clearFreed() {
+	for (size_t n = 0; n < FREE_LISTS; n++) {
+		freed[n] = nullptr;
+	}
+}
+
+//************************ C allocation for the libraries *********************/
+
+/*
+ * Used by fast_obj and MikkTSpace (which are compiled as C).
+ */
+extern "C" {
+void* o2b_malloc(size_t size) {
+	return Arena::allocate(size);
+}
+void* o2b_realloc(void* ptr, size_t size) {
+	return Arena::reallocate(ptr, size);
+}
+void o2b_free(void* ptr) {
+	Arena::release(ptr);
+}
+}
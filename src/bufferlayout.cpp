@@ -32,10 +32,18 @@ static VertexPacker::Failed store(const Vec3<T>& vec, VertexPacker& dest, Vertex
 BufferLayout::BufferLayout(const ToolOptions& opts)
 	: packTans(PACK_NONE)
 	, packSign(PACK_NONE)
+	, stride  (0)
+	, streams (0)
 {
 	bool const hasEncNormals = O2B_HAS_OPT(opts.opts, ToolOptions::OPTS_NORMALS_ENCODED);
-	bool const hasBitansSign = O2B_HAS_OPT(opts.opts, ToolOptions::OPTS_BITANGENTS_SIGN) && opts.tans;
+	bool const hasBitansSign = O2B_HAS_OPT(opts.opts, ToolOptions::OPTS_BITANGENTS_SIGN) && opts.tans && !opts.qtangent;
 	bool const hasTansPacked = O2B_HAS_OPT(opts.opts, ToolOptions::OPTS_TANGENTS_PACKED) && opts.tans;
+	/*
+	 * Multiple streams start a new one after the positions, and optionally
+	 * after every attribute (the offsets then being relative to the stream).
+	 */
+	bool const posnStream = opts.streams != ToolOptions::STREAMS_INTERLEAVED;
+	bool const attrStream = opts.streams == ToolOptions::STREAMS_ATTRIBUTE;
 	/*
 	 * Starting with all the params at zero, we try to find the best fit.
 	 */
@@ -47,11 +55,15 @@ BufferLayout::BufferLayout(const ToolOptions& opts)
 		 * or 2 bytes padding, or (for signed types) allowing the bitangent
 		 * sign to be packed.
 		 */
-		posn.fill(opts.posn, offset, 3);
-		if (hasBitansSign && opts.posn.isSigned()) {
+		posn.fill(opts.posn, offset, 3, streams);
+		if (hasBitansSign && opts.posn.isSigned() && !posnStream) {
+			// (Not when the positions are their own stream, keeping them minimal)
 			tryPacking(packSign, posn, 1, PACK_POSN_W);
 		}
 		offset += posn.getAlignedSize();
+		if (posnStream) {
+			nextStream(offset);
+		}
 	}
 	if (opts.text) {
 		/*
@@ -61,13 +73,41 @@ BufferLayout::BufferLayout(const ToolOptions& opts)
 		 * is more suited). We try to fit the bitangent sign, but since signed
 		 * bytes are the only type that will work, it's unlikely to go here.
 		 */
-		tex0.fill(opts.text, offset, 2);
+		tex0.fill(opts.text, offset, 2, streams);
 		if (hasBitansSign && opts.text.isSigned()) {
 			tryPacking(packSign, tex0, 1, PACK_TEX0_Z);
 		}
 		offset += tex0.getAlignedSize();
+		if (attrStream) {
+			nextStream(offset);
+		}
+	}
+	if (opts.tex1) {
+		/*
+		 * The second UV channel follows the same rules as the first, being
+		 * the next candidate for the bitangent sign.
+		 */
+		tex1.fill(opts.tex1, offset, 2, streams);
+		if (hasBitansSign && opts.tex1.isSigned()) {
+			tryPacking(packSign, tex1, 1, PACK_TEX1_Z);
+		}
+		offset += tex1.getAlignedSize();
+		if (attrStream) {
+			nextStream(offset);
+		}
+	}
+	if (opts.qtangent) {
+		/*
+		 * A QTangent replaces the normals, tangents and bitangents (so none
+		 * of the packing below applies). Always four components.
+		 */
+		qtan.fill(opts.tans, offset, 4, streams);
+		offset += qtan.getAlignedSize();
+		if (attrStream) {
+			nextStream(offset);
+		}
 	}
-	if (opts.norm) {
+	if (opts.norm && !opts.qtangent) {
 		/*
 		 * Unencoded normals are X, Y & Z, encoded are two components (referred
 		 * to as X & Y for simplicity). Unencoded can squeeze in the bitangent
@@ -77,7 +117,7 @@ BufferLayout::BufferLayout(const ToolOptions& opts)
 		 *
 		 * TODO: we only fit the encoded tangents *if* they're of the same type *and* (preferably) bitangents aren't stored as sign
 		 */
-		norm.fill(opts.norm, offset, (hasEncNormals) ? 2 : 3);
+		norm.fill(opts.norm, offset, (hasEncNormals) ? 2 : 3, streams);
 		if (hasTansPacked && hasEncNormals) {
 			tryPacking(packTans, norm, 2, PACK_NORM_Z, true);
 		} else {
@@ -86,8 +126,11 @@ BufferLayout::BufferLayout(const ToolOptions& opts)
 			}
 		}
 		offset += norm.getAlignedSize();
+		if (attrStream) {
+			nextStream(offset);
+		}
 	}
-	if (opts.tans) {
+	if (opts.tans && !opts.qtangent) {
 		/*
 		 * If the tangents weren't packed they're written standalone. We try to
 		 * pack the bitangents sign but not the bitangents (simply because, if
@@ -97,11 +140,14 @@ BufferLayout::BufferLayout(const ToolOptions& opts)
 		 * TODO: if tangents aren't the same type as normals then it is preferable to pack them here (since they're the same type)
 		 */
 		if (packTans == PACK_NONE) {
-			tans.fill(opts.tans, offset, (hasEncNormals) ? 2 : 3);
+			tans.fill(opts.tans, offset, (hasEncNormals) ? 2 : 3, streams);
 			if (hasBitansSign) {
 				tryPacking(packSign, tans, 1, (hasEncNormals) ? PACK_TANS_Z : PACK_TANS_W);
 			}
 			offset += tans.getAlignedSize();
+			if (attrStream) {
+				nextStream(offset);
+			}
 		}
 		if (packSign == PACK_NONE) {
 			/*
@@ -112,18 +158,45 @@ BufferLayout::BufferLayout(const ToolOptions& opts)
 			 *
 			 * TODO: see above, there are places to pack them
 			 */
-			btan.fill(opts.tans, offset, (hasBitansSign) ? 1 : ((hasEncNormals) ? 2 : 3));
+			btan.fill(opts.tans, offset, (hasBitansSign) ? 1 : ((hasEncNormals) ? 2 : 3), streams);
 			offset += btan.getAlignedSize();
 		}
 	}
-	stride = offset;
+	if (opts.rgba) {
+		/*
+		 * Colours are always four normalised unsigned bytes, needing neither
+		 * padding nor offering anywhere to pack. They go last so as not to
+		 * affect the placement of the other attributes.
+		 */
+		if (attrStream) {
+			nextStream(offset);
+		}
+		rgba.fill(VertexPacker::Storage::UINT08N, offset, 4, streams);
+		offset += rgba.getAlignedSize();
+	}
+	// Close the final stream (or the only one, even if empty)
+	if (offset > 0 || streams == 0) {
+		strides[streams++] = offset;
+	}
+	for (unsigned n = 0; n < streams; n++) {
+		stride += strides[n];
+	}
 }
 
 void BufferLayout::dump() const {
-	posn.dump(stride, "VERT_POSN_ID");
-	tex0.dump(stride, "VERT_TEX0_ID");
-	tex1.dump(stride, "VERT_TEX1_ID");
-	norm.dump(stride, "VERT_NORM_ID");
+	if (streams > 1) {
+		// Each stream is bound in turn, starting after the previous
+		unsigned offset = 0;
+		for (unsigned n = 0; n < streams; n++) {
+			printf("// Stream %d: stride %d, starting at vertex count * %d\n", n, strides[n], offset);
+			offset += strides[n];
+		}
+	}
+	posn.dump(strides[posn.stream], "VERT_POSN_ID");
+	tex0.dump(strides[tex0.stream], "VERT_TEX0_ID");
+	tex1.dump(strides[tex1.stream], "VERT_TEX1_ID");
+	norm.dump(strides[norm.stream], "VERT_NORM_ID");
+	qtan.dump(strides[qtan.stream], "VERT_QTAN_ID");
 	/*
 	 * Tangents are (currently) only ever packed in the normals. The
 	 * bitangent sign, though, varies.
@@ -131,12 +204,12 @@ void BufferLayout::dump() const {
 	 * TODO: finish (and tidy)
 	 */
 	if (packTans == PACK_NONE) {
-		tans.dump(stride, "VERT_TANS_ID");
+		tans.dump(strides[tans.stream], "VERT_TANS_ID");
 	} else {
 		printf("// Encoded tangents packed in norm.zw (note the four components)\n");
 	}
 	if (packSign == PACK_NONE) {
-		btan.dump(stride, "VERT_BTAN_ID");
+		btan.dump(strides[btan.stream], "VERT_BTAN_ID");
 	} else {
 		const char* element;
 		const char* numComp = "four";
@@ -171,17 +244,17 @@ void BufferLayout::dump() const {
 		}
 		printf("// Bitangents sign packed in %s (note the %s components)\n", element, numComp);
 	}
+	rgba.dump(strides[rgba.stream], "VERT_RGBA_ID");
+}
+
+unsigned BufferLayout::getHeaderSize() const {
+	// Four bytes for the header's header then four per attribute (then any stream strides)
+	return 4 + 4 * countAttrs() + ((streams > 1) ? (streams + 3) & ~3 : 0);
 }
 
 VertexPacker::Failed BufferLayout::writeHeader(VertexPacker& packer) const {
 	VertexPacker::Failed failed = false;
-	// Horrible but... count the used attributes
-	unsigned attrs = 0;
-	attrs += (posn) ? 1 : 0;
-	attrs += (tex0) ? 1 : 0;
-	attrs += (norm) ? 1 : 0;
-	attrs += (tans) ? 1 : 0;
-	attrs += (btan) ? 1 : 0;
+	unsigned const attrs = countAttrs();
 	// Write the header's header
 	failed |= packer.add(packTans, VertexPacker::Storage::UINT08C);
 	failed |= packer.add(packSign, VertexPacker::Storage::UINT08C);
@@ -190,37 +263,58 @@ VertexPacker::Failed BufferLayout::writeHeader(VertexPacker& packer) const {
 	// Then each attribute's (if it has no storage it writes nothing)
 	failed |= posn.write(packer, VERT_POSN_ID);
 	failed |= tex0.write(packer, VERT_TEX0_ID);
+	failed |= tex1.write(packer, VERT_TEX1_ID);
 	failed |= norm.write(packer, VERT_NORM_ID);
+	failed |= qtan.write(packer, VERT_QTAN_ID);
 	failed |= tans.write(packer, VERT_TANS_ID);
 	failed |= btan.write(packer, VERT_BTAN_ID);
+	failed |= rgba.write(packer, VERT_RGBA_ID);
+	if (streams > 1) {
+		// Then the stride of each stream (padded to keep the header a multiple of four)
+		for (unsigned n = 0; n < ((streams + 3) & ~3); n++) {
+			failed |= packer.add((n < streams) ? strides[n] : 0, VertexPacker::Storage::UINT08C);
+		}
+	}
 	return failed;
 }
 
-VertexPacker::Failed BufferLayout::writeVertex(VertexPacker& packer, const ObjVertex& vertex, size_t const base) const {
+VertexPacker::Failed BufferLayout::writeVertex(VertexPacker& packer, const ObjVertex& vertex, size_t const base, int const stream) const {
 	VertexPacker::Failed failed = false;
 	/*
 	 * Positions and UVs are straightforward. They always write all components,
 	 * and optionally pack the tangent sign.
 	 */
-	if (posn) {
-		failed |= vertex.posn.store(packer, posn.storage);
+	if (posn.in(stream)) {
 		if (packSign == PACK_POSN_W) {
-			failed |= packer.add(vertex.sign, posn.storage);
+			failed |= vec4(vertex.posn, vertex.sign).store(packer, posn.storage);
+		} else {
+			failed |= vertex.posn.store(packer, posn.storage);
 		}
 		if (posn.unaligned) {
 			failed |= packer.align(base);
 		}
 	}
-	if (tex0) {
-		failed |= vertex.tex0.store(packer, tex0.storage);
+	if (tex0.in(stream)) {
 		if (packSign == PACK_TEX0_Z) {
-			failed |= packer.add(vertex.sign, tex0.storage);
+			failed |= vec3(vertex.tex0.x, vertex.tex0.y, vertex.sign).store(packer, tex0.storage);
+		} else {
+			failed |= vertex.tex0.store(packer, tex0.storage);
 		}
 		if (tex0.unaligned) {
 			failed |= packer.align(base);
 		}
 	}
-	if (norm) {
+	if (tex1.in(stream)) {
+		if (packSign == PACK_TEX1_Z) {
+			failed |= vec3(vertex.tex1.x, vertex.tex1.y, vertex.sign).store(packer, tex1.storage);
+		} else {
+			failed |= vertex.tex1.store(packer, tex1.storage);
+		}
+		if (tex1.unaligned) {
+			failed |= packer.align(base);
+		}
+	}
+	if (norm.in(stream)) {
 		if (packTans == PACK_NORM_Z) {
 			/*
 			 * This means implicit encoding for both normals and tangents, so
@@ -233,16 +327,16 @@ VertexPacker::Failed BufferLayout::writeVertex(VertexPacker& packer, const ObjVe
 				/*
 				 * Sign is Z is also implicit encoding for normals.
 				 */
-				failed |= vertex.norm.xy().store(packer, norm.storage);
-				failed |= packer.add(vertex.sign, norm.storage);
+				failed |= vec3(vertex.norm.x, vertex.norm.y, vertex.sign).store(packer, norm.storage);
 			} else {
 				/*
 				 * Otherwise differentiate between 2- or 3-components, with
 				 * the optional sign packed at the end.
 				 */
-				failed |= store(vertex.norm, packer, norm.storage, norm.components == 2);
 				if (packSign == PACK_NORM_W) {
-					failed |= packer.add(vertex.sign, norm.storage);
+					failed |= vec4(vertex.norm, vertex.sign).store(packer, norm.storage);
+				} else {
+					failed |= store(vertex.norm, packer, norm.storage, norm.components == 2);
 				}
 			}
 		}
@@ -250,20 +344,30 @@ VertexPacker::Failed BufferLayout::writeVertex(VertexPacker& packer, const ObjVe
 			failed |= packer.align(base);
 		}
 	}
-	if (tans) {
+	if (qtan.in(stream)) {
+		// The quaternion's xyz were encoded in-place in the normal, w in the sign
+		failed |= vec4(vertex.norm, vertex.sign).store(packer, qtan.storage);
+	}
+	if (tans.in(stream)) {
 		/*
 		 * Tangents are written if they weren't packed.
 		 *
 		 * TODO: this is unfinished
 		 */
 		if (packTans == PACK_NONE) {
-			failed |= store(vertex.tans, packer, tans.storage, tans.components == 2);
+			if (packSign == PACK_TANS_Z) {
+				failed |= vec3(vertex.tans.x, vertex.tans.y, vertex.sign).store(packer, tans.storage);
+			} else if (packSign == PACK_TANS_W) {
+				failed |= vec4(vertex.tans, vertex.sign).store(packer, tans.storage);
+			} else {
+				failed |= store(vertex.tans, packer, tans.storage, tans.components == 2);
+			}
 			if (tans.unaligned) {
 				failed |= packer.align(base);
 			}
 		}
 	}
-	if (btan) {
+	if (btan.in(stream)) {
 		/*
 		 * The design looks to have originally been 'packTans' is for tangents
 		 * and bitangent, since from the command-line they both take the same
@@ -273,15 +377,44 @@ VertexPacker::Failed BufferLayout::writeVertex(VertexPacker& packer, const ObjVe
 		 * TODO: as above, this is unfinished
 		 */
 		if (/*packTans == PACK_NONE &&*/ packSign == PACK_NONE) {
-			failed |= store(vertex.btan, packer, btan.storage, btan.components == 2);
+			if (btan.components == 1) {
+				// Nowhere to pack the sign so it's written standalone
+				failed |= packer.add(vertex.sign, btan.storage);
+			} else {
+				failed |= store(vertex.btan, packer, btan.storage, btan.components == 2);
+			}
 			if (btan.unaligned) {
 				failed |= packer.align(base);
 			}
 		}
 	}
+	if (rgba.in(stream)) {
+		failed |= vertex.rgba.store(packer, rgba.storage);
+	}
 	return failed;
 }
 
+void BufferLayout::nextStream(unsigned& offset) {
+	if (offset > 0) {
+		strides[streams++] = offset;
+		offset = 0;
+	}
+}
+
+unsigned BufferLayout::countAttrs() const {
+	// Horrible but... count the used attributes
+	unsigned attrs = 0;
+	attrs += (posn) ? 1 : 0;
+	attrs += (tex0) ? 1 : 0;
+	attrs += (tex1) ? 1 : 0;
+	attrs += (norm) ? 1 : 0;
+	attrs += (qtan) ? 1 : 0;
+	attrs += (tans) ? 1 : 0;
+	attrs += (btan) ? 1 : 0;
+	attrs += (rgba) ? 1 : 0;
+	return attrs;
+}
+
 void BufferLayout::tryPacking(Packing& what, AttrParams& attr, int const numComps, Packing const where, bool const force) {
 	if (what == PACK_NONE) {
 		/*
@@ -289,7 +422,7 @@ void BufferLayout::tryPacking(Packing& what, AttrParams& attr, int const numComp
 		 * whether adding extra components will still fit (our limit is GL,
 		 * which supports 1, 2, & 4).
 		 */
-		if (attr && (attr.components + numComps) <= 4 && (attr.unaligned || force)) {
+		if (attr && (attr.components + numComps) <= 4 && (attr.unaligned || force || attr.hasSpare(numComps))) {
 			attr.components += numComps;
 			what = where;
 			attr.validate();
@@ -302,23 +435,37 @@ void BufferLayout::tryPacking(Packing& what, AttrParams& attr, int const numComp
 BufferLayout::AttrParams::AttrParams()
 	: storage   (VertexPacker::Storage::EXCLUDE)
 	, offset    (0)
+	, stream    (0)
 	, components(0)
 	, unaligned (false) {}
 
-void BufferLayout::AttrParams::fill(VertexPacker::Storage const attrType, unsigned const startOff, unsigned const numComps) {
+void BufferLayout::AttrParams::fill(VertexPacker::Storage const attrType, unsigned const startOff, unsigned const numComps, unsigned const attrStream) {
 	storage    = attrType;
 	offset     = startOff;
+	stream     = attrStream;
 	components = numComps;
 	validate();
 }
 
 void BufferLayout::AttrParams::validate() {
 	if (storage) {
-		unaligned = ((components * storage.bytes()) & 3) != 0;
+		unaligned = !storage.isPacked() && ((components * storage.bytes()) & 3) != 0;
 	}
 }
 
+bool BufferLayout::AttrParams::hasSpare(int const numComps) const {
+	/*
+	 * Only a single signed value (the bitangent sign) goes in a packed type's
+	 * unused components (the 10_10_10_2 w being only two bits).
+	 */
+	return storage.isPacked() && storage.isSigned() && numComps == 1
+		&& (components + numComps) <= storage.components();
+}
+
 unsigned BufferLayout::AttrParams::getAlignedSize() const {
+	if (storage.isPacked()) {
+		return storage.bytes();
+	}
 	return ((components * storage.bytes() + 3) / 4) * 4;
 }
 
@@ -326,7 +473,7 @@ void BufferLayout::AttrParams::dump(unsigned const stride, const char* name) con
 	if (storage) {
 		const char* normalised = (storage.isNormalized()) ? "TRUE" : "FALSE";
 		printf("glVertexAttribPointer(%s, %d, GL_%s, GL_%s, %d, (void*) %d);\n",
-			name, components, storage.toString(true), normalised, stride, offset);
+			name, getSize(), storage.toString(true), normalised, stride, offset);
 	}
 }
 
@@ -336,9 +483,12 @@ VertexPacker::Failed BufferLayout::AttrParams::write(VertexPacker& packer, unsig
 		/*
 		 * This has a limited number of values:
 		 *
-		 * - index: 0..5, equating to VERT_POSN_ID, VERT_TEX0_ID, etc.
-		 * - components: 2..4, xy, xyz & xyzw
-		 * - type: 1..8, TYPE_BYTE to TYPE_FLOAT with the MSB set for normalised
+		 * - index: 0..7, equating to VERT_POSN_ID, VERT_TEX0_ID, etc. (with
+		 *   the stream in the upper four bits)
+		 * - components: 1..4, x, xy, xyz & xyzw (packed types always being
+		 *   the full 3 or 4 the API expects)
+		 * - type: 1..11, TYPE_BYTE to TYPE_UNSIGNED_INT_10F_11F_11F_REV with
+		 *   the MSB set for normalised
 		 * - offset: 0..44 (given a maximum stride of 56)
 		 *
 		 * It's not worth the overhead of packing the bits to save a few bytes.
@@ -347,8 +497,8 @@ VertexPacker::Failed BufferLayout::AttrParams::write(VertexPacker& packer, unsig
 		if (storage.isNormalized()) {
 			type |= 0x80;
 		}
-		failed |= packer.add(index,      VertexPacker::Storage::UINT08C);
-		failed |= packer.add(components, VertexPacker::Storage::UINT08C);
+		failed |= packer.add(index | (stream << 4), VertexPacker::Storage::UINT08C);
+		failed |= packer.add(getSize(),  VertexPacker::Storage::UINT08C);
 		failed |= packer.add(type,       VertexPacker::Storage::UINT08C);
 		failed |= packer.add(offset,     VertexPacker::Storage::UINT08C);
 		return failed;
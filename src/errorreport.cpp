@@ -0,0 +1,230 @@
+/**
+ * \file errorreport.cpp
+ *
+ * \copyright 2022 Numfum GmbH
+ */
+#include "errorreport.h"
+
+#include <cfloat>
+#include <cmath>
+
+#include <algorithm>
+#include <functional>
+#include <thread>
+
+#include "minifloat.h"
+#include "objmesh.h"
+#include "tooloptions.h"
+
+/**
+ * \def O2B_ERROR_MIN_VERTS
+ * Fewest vertices given to each measuring thread (below which starting the
+ * thread costs more than it saves).
+ */
+#ifndef O2B_ERROR_MIN_VERTS
+#define O2B_ERROR_MIN_VERTS 16384
+#endif
+
+namespace impl {
+/**
+ * Measured attributes (indexing the per-vertex errors).
+ */
+enum AttrId {
+	ATTR_POSN,
+	ATTR_TEX0,
+	ATTR_TEX1,
+	ATTR_NORM,
+	ATTR_TANS,
+	ATTR_BTAN,
+	ATTR_RGBA,
+	ATTR_COUNT,
+};
+/**
+ * Work shared between the measuring threads, each filling its own range of
+ * the per-vertex errors (so no locking is needed).
+ */
+struct Job {
+	const ToolOptions* opts;        /**< Tool options (the types and encoding). */
+	const ObjMesh* mesh;            /**< Mesh being measured. */
+	float extent;                   /**< Longest side of the mesh's bounds (in the mesh's units). */
+	bool used[ATTR_COUNT];          /**< Whether each attribute is stored (and so measured). */
+	std::vector<float> errs[ATTR_COUNT]; /**< Per-vertex errors of each attribute. */
+};
+/**
+ * Helper to calculate the angle between a source vector and its decoded
+ * equivalent.
+ *
+ * \param[in] src source vector (not necessarily normalised, with zero length vectors having no error)
+ * \param[in] dec decoded vector (normalised)
+ * \return angle between the vectors (in degrees)
+ */
+float angle(const vec3& src, const vec3& dec) {
+	float const len = src.len();
+	if (len == 0.0f) {
+		return 0.0f;
+	}
+	float const cosine = std::min(std::max(vec3::dot(src, dec) / len, -1.0f), 1.0f);
+	return std::acos(cosine) * (180.0f / static_cast<float>(M_PI));
+}
+
+/**
+ * Helper to round-trip a position through its storage type, as written by \c
+ * VertexPacker::add(float,float,float,float) (packed \c 11_11_10 floats store
+ * \c z with a 10-bit mantissa, not the 11 bits of \c x and \c y).
+ *
+ * \param[in] posn source position
+ * \param[in] type storage type
+ * \param[in] legacy \c true if signed values use the legacy conversion
+ * \return decoded position
+ */
+vec3 roundtrip(const vec3& posn, VertexPacker::Storage const type, bool const legacy) {
+	vec3 dec(
+		VertexPacker::roundtrip(posn.x, type, legacy),
+		VertexPacker::roundtrip(posn.y, type, legacy),
+		VertexPacker::roundtrip(posn.z, type, legacy));
+	if (type == VertexPacker::Storage::FLOAT11_10) {
+		dec.z = utils::ufloatToFloat(utils::floatToUFloat(posn.z, 10), 10);
+	}
+	return dec;
+}
+/**
+ * Measures the errors for a range of vertices.
+ *
+ * \param[in,out] job shared work (with the per-vertex errors sized to fit)
+ * \param[in] begin index of the first vertex
+ * \param[in] end index after the last vertex
+ */
+void measureRange(Job& job, size_t const begin, size_t const end) {
+	const ToolOptions& opts = *job.opts;
+	bool const legacy   = O2B_HAS_OPT(opts.opts, ToolOptions::OPTS_SIGNED_LEGACY);
+	bool const encoded  = O2B_HAS_OPT(opts.opts, ToolOptions::OPTS_NORMALS_ENCODED);
+	bool const btanSign = O2B_HAS_OPT(opts.opts, ToolOptions::OPTS_BITANGENTS_SIGN);
+	float const texSize = static_cast<float>(opts.autoTexSize);
+	vec3 const scale = job.mesh->scale;
+	for (size_t n = begin; n < end; n++) {
+		const ObjVertex& vert = job.mesh->verts[n];
+		if (job.used[ATTR_POSN]) {
+			vec3 const diff = (vert.posn - roundtrip(vert.posn, opts.posn, legacy)) * scale;
+			job.errs[ATTR_POSN][n] = diff.len() / job.extent;
+		}
+		for (unsigned uv = 0; uv < 2; uv++) {
+			if (job.used[ATTR_TEX0 + uv]) {
+				const vec2& src = (uv == 0) ? vert.tex0 : vert.tex1;
+				VertexPacker::Storage const type = (uv == 0) ? opts.text : opts.tex1;
+				float const errX = std::abs(src.x - VertexPacker::roundtrip(src.x, type, legacy));
+				float const errY = std::abs(src.y - VertexPacker::roundtrip(src.y, type, legacy));
+				job.errs[ATTR_TEX0 + uv][n] = std::max(errX, errY) * texSize;
+			}
+		}
+		if (job.used[ATTR_NORM]) {
+			vec3 decNorm(0.0f, 0.0f, 0.0f);
+			vec3 decTans(0.0f, 0.0f, 0.0f);
+			vec3 decBtan(0.0f, 0.0f, 0.0f);
+			ObjVertex::roundtripFrame(vert, opts.norm, opts.tans, encoded, opts.qtangent, btanSign, legacy, decNorm, decTans, decBtan);
+			job.errs[ATTR_NORM][n] = angle(vert.norm, decNorm);
+			if (job.used[ATTR_TANS]) {
+				job.errs[ATTR_TANS][n] = angle(vert.tans, decTans);
+				if (opts.qtangent || btanSign) {
+					// Recreated bitangents are compared with those recreated from the source
+					job.errs[ATTR_BTAN][n] = angle(vec3::cross(vert.norm, vert.tans) * vert.sign, decBtan);
+				} else {
+					job.errs[ATTR_BTAN][n] = angle(vert.btan, decBtan);
+				}
+			}
+		}
+		if (job.used[ATTR_RGBA]) {
+			float err = 0.0f;
+			for (unsigned c = 0; c < 4; c++) {
+				err = std::max(err, std::abs(vert.rgba[c] - VertexPacker::roundtrip(vert.rgba[c], VertexPacker::Storage::UINT08N)));
+			}
+			job.errs[ATTR_RGBA][n] = err;
+		}
+	}
+}
+/**
+ * Summarises one attribute's per-vertex errors.
+ *
+ * \param[in,out] errs per-vertex errors (reordered finding the percentile)
+ * \param[out] attr destination for the mean, 99th-percentile and maximum
+ */
+void summarise(std::vector<float>& errs, ErrorReport::Attr& attr) {
+	attr.mean = 0.0f;
+	attr.p99  = 0.0f;
+	attr.max  = 0.0f;
+	if (!errs.empty()) {
+		double sum = 0.0;
+		float  max = 0.0f;
+		for (std::vector<float>::const_iterator it = errs.begin(); it != errs.end(); ++it) {
+			sum += *it;
+			max  = std::max(max, *it);
+		}
+		std::vector<float>::iterator const p99 = errs.begin() + (errs.size() - 1) * 99 / 100;
+		std::nth_element(errs.begin(), p99, errs.end());
+		attr.mean = static_cast<float>(sum / errs.size());
+		attr.p99  = *p99;
+		attr.max  = max;
+	}
+}
+}
+
+//*****************************************************************************/
+
+void ErrorReport::measure(const ToolOptions& opts, const ObjMesh& mesh) {
+	impl::Job job;
+	job.opts = &opts;
+	job.mesh = &mesh;
+	job.used[impl::ATTR_POSN] = static_cast<bool>(opts.posn);
+	job.used[impl::ATTR_TEX0] = static_cast<bool>(opts.text);
+	job.used[impl::ATTR_TEX1] = static_cast<bool>(opts.tex1);
+	job.used[impl::ATTR_NORM] = opts.norm || opts.qtangent;
+	job.used[impl::ATTR_TANS] = static_cast<bool>(opts.tans);
+	job.used[impl::ATTR_BTAN] = static_cast<bool>(opts.tans);
+	job.used[impl::ATTR_RGBA] = opts.rgba;
+	size_t const count = mesh.verts.size();
+	for (unsigned n = 0; n < impl::ATTR_COUNT; n++) {
+		if (job.used[n]) {
+			job.errs[n].resize(count);
+		}
+	}
+	// Positions are relative to the mesh size (measured in the mesh's units)
+	vec3 minPosn({ FLT_MAX,  FLT_MAX,  FLT_MAX});
+	vec3 maxPosn({-FLT_MAX, -FLT_MAX, -FLT_MAX});
+	for (ObjVertex::Container::const_iterator it = mesh.verts.begin(); it != mesh.verts.end(); ++it) {
+		minPosn = vec3::min(minPosn, it->posn);
+		maxPosn = vec3::max(maxPosn, it->posn);
+	}
+	vec3 const extent = (maxPosn - minPosn) * mesh.scale;
+	job.extent = std::max(std::max(std::max(extent.x, extent.y), extent.z), FLT_MIN);
+	// Divide the vertices between the threads, this thread taking the first range
+	unsigned threads = O2B_ERROR_THREADS;
+	if (threads == 0) {
+		threads = std::max(std::thread::hardware_concurrency(), 1U);
+	}
+	threads = static_cast<unsigned>(std::max<size_t>(std::min<size_t>(threads, count / O2B_ERROR_MIN_VERTS), 1));
+	size_t const range = (count + threads - 1) / threads;
+	std::vector<std::thread> workers;
+	for (unsigned n = 1; n < threads; n++) {
+		workers.emplace_back(impl::measureRange, std::ref(job), std::min(n * range, count), std::min((n + 1) * range, count));
+	}
+	impl::measureRange(job, 0, std::min(range, count));
+	for (std::vector<std::thread>::iterator it = workers.begin(); it != workers.end(); ++it) {
+		it->join();
+	}
+	// Then summarise each attribute
+	static const char* const names[impl::ATTR_COUNT] = {"posn", "tex0", "tex1", "norm", "tans", "btan", "rgba"};
+	static const char* const units[impl::ATTR_COUNT] = {"size", "texels", "texels", "degrees", "degrees", "degrees", "unit"};
+	VertexPacker::Storage const types[impl::ATTR_COUNT] = {
+		opts.posn, opts.text, opts.tex1, (opts.qtangent) ? opts.tans : opts.norm, opts.tans, opts.tans, VertexPacker::Storage::UINT08N
+	};
+	attrs.clear();
+	for (unsigned n = 0; n < impl::ATTR_COUNT; n++) {
+		if (job.used[n]) {
+			Attr attr;
+			attr.name  = names[n];
+			attr.units = units[n];
+			attr.type  = types[n];
+			impl::summarise(job.errs[n], attr);
+			attrs.push_back(attr);
+		}
+	}
+}
@@ -24,5 +24,14 @@
  *
  */
 
+/*
+ * Allocations go through the conversion arena (see arena.h).
+ */
+#include <stddef.h>
+void* o2b_realloc(void* ptr, size_t size);
+void  o2b_free(void* ptr);
+#define FAST_OBJ_REALLOC o2b_realloc
+#define FAST_OBJ_FREE    o2b_free
+
 #define FAST_OBJ_IMPLEMENTATION
 #include "fast_obj.h"
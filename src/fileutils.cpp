@@ -3,10 +3,81 @@
 #include <cstdint>
 #include <cstdlib>
 #include <cstdio>
+#include <cstring>
 
+#include <atomic>
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <unistd.h>
+#if !defined(__EMSCRIPTEN__)
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#define O2B_HAS_MMAP 1
+#endif
+#endif
+#ifdef _WIN32
+#include <process.h>
+#endif
+
+#include "zdict.h"
 #include "zstd.h"
 
+/**
+ * \def O2B_DICT_MAX_SIZE
+ * Maximum size of a trained dictionary (the same default as the \c zstd CLI).
+ */
+#ifndef O2B_DICT_MAX_SIZE
+#define O2B_DICT_MAX_SIZE (110 * 1024)
+#endif
+
 namespace impl {
+/**
+ * Zstandard compression state kept between calls to \c #write(), so that
+ * converting many files (e.g. in server mode) doesn't reallocate the context
+ * and buffers each time. One per thread, since contexts can't be shared.
+ */
+struct ZstdContext {
+	ZstdContext()
+		: cctx(nullptr) {}
+	~ZstdContext() {
+		ZSTD_freeCCtx(cctx);
+	}
+	/**
+	 * Returns the compression context (creating it on first use).
+	 */
+	ZSTD_CCtx* get() {
+		if (!cctx) {
+			cctx = ZSTD_createCCtx();
+		}
+		return cctx;
+	}
+	ZSTD_CCtx* cctx;           /**< Reusable compression context. */
+	std::vector<uint8_t> comp; /**< Reusable compressed data buffer. */
+};
+
+/**
+ * Shared dictionary, digested once for all threads (see \c #setDictionary()).
+ */
+struct ZstdDictionary {
+	ZstdDictionary()
+		: cdict(nullptr) {}
+	~ZstdDictionary() {
+		ZSTD_freeCDict(cdict);
+	}
+	ZSTD_CDict* cdict; /**< Digested dictionary (or \c null if not set). */
+};
+
+/**
+ * Per-thread compression state.
+ */
+static thread_local ZstdContext context;
+
+/**
+ * Optional compression dictionary.
+ */
+static ZstdDictionary dictionary;
+
 /**
  * Helper to decide between either a space or a newline following an entry when
  * dumping or printing hex data.
@@ -29,9 +100,9 @@ char spaceOrNewline(size_t const count, size_t const wrap, size_t total) {
  * \return \c true if writing the requested number of bytes was successful
  */
 bool write(const char* const dstPath, const void* const data, size_t const size) {
-	if (dstPath && data) {
+	if (dstPath && (data || size == 0)) {
 		if (FILE *dstFile = fopen(dstPath, "wb")) {
-			size_t wrote = fwrite(data, 1, size, dstFile);
+			size_t wrote = (size) ? fwrite(data, 1, size, dstFile) : 0;
 			if (fclose(dstFile) == 0) {
 				return wrote == size;
 			}
@@ -66,6 +137,60 @@ bool write(const char* const dstPath, const void* const data, size_t const size,
 	}
 	return false;
 }
+
+//********************************** XXH64 ************************************/
+
+/*
+ * XXH64 primes (see https://github.com/Cyan4973/xxHash). The vendored Zstd
+ * compiles its own xxHash as private, so we have our own (short) variant.
+ */
+uint64_t const XXH_PRIME64_1 = 0x9E3779B185EBCA87ULL;
+uint64_t const XXH_PRIME64_2 = 0xC2B2AE3D27D4EB4FULL;
+uint64_t const XXH_PRIME64_3 = 0x165667B19E3779F9ULL;
+uint64_t const XXH_PRIME64_4 = 0x85EBCA77C2B2AE63ULL;
+uint64_t const XXH_PRIME64_5 = 0x27D4EB2F165667C5ULL;
+
+/**
+ * Rotates \a val left by \a bits.
+ */
+inline uint64_t rotl64(uint64_t const val, unsigned const bits) {
+	return (val << bits) | (val >> (64 - bits));
+}
+
+/**
+ * Reads a little endian 64-bit value (regardless of the host's byte order).
+ */
+inline uint64_t readLE64(const uint8_t* const src) {
+	return (static_cast<uint64_t>(src[0]) <<  0) | (static_cast<uint64_t>(src[1]) <<  8)
+		 | (static_cast<uint64_t>(src[2]) << 16) | (static_cast<uint64_t>(src[3]) << 24)
+		 | (static_cast<uint64_t>(src[4]) << 32) | (static_cast<uint64_t>(src[5]) << 40)
+		 | (static_cast<uint64_t>(src[6]) << 48) | (static_cast<uint64_t>(src[7]) << 56);
+}
+
+/**
+ * Reads a little endian 32-bit value (regardless of the host's byte order).
+ */
+inline uint64_t readLE32(const uint8_t* const src) {
+	return (static_cast<uint64_t>(src[0]) <<  0) | (static_cast<uint64_t>(src[1]) <<  8)
+		 | (static_cast<uint64_t>(src[2]) << 16) | (static_cast<uint64_t>(src[3]) << 24);
+}
+
+/**
+ * XXH64 accumulator round.
+ */
+inline uint64_t xxhRound(uint64_t acc, uint64_t const input) {
+	acc += input * XXH_PRIME64_2;
+	acc  = rotl64(acc, 31);
+	return acc * XXH_PRIME64_1;
+}
+
+/**
+ * XXH64 merge of an accumulator into the hash.
+ */
+inline uint64_t xxhMerge(uint64_t acc, uint64_t const val) {
+	acc ^= xxhRound(0, val);
+	return acc * XXH_PRIME64_1 + XXH_PRIME64_4;
+}
 }
 
 //********************************* Public API ********************************/
@@ -75,26 +200,35 @@ bool write(const char* const dstPath, const void* const data, size_t const size,
 	if (data) {
 		if (zstd) {
 			/*
-			 * We use the simple API to compress the entire buffer in one go
-			 * (with a mono-threaded Zstd). This *should* generate a single Zstd
-			 * frame, containing a magic in the first four bytes, 0xFD2FB528,
-			 * always little endian, and the original frame content size (making
-			 * the compressed data self-contained).
+			 * We compress the entire buffer in one go (with a mono-threaded
+			 * Zstd, reusing this thread's context and buffer). This *should*
+			 * generate a single Zstd frame, containing a magic in the first
+			 * four bytes, 0xFD2FB528, always little endian, and the original
+			 * frame content size (making the compressed data self-contained,
+			 * other than needing any dictionary).
 			 */
 			size_t bounds = ZSTD_compressBound(size);
-			void* compBuf = malloc(bounds);
-			if (compBuf) {
-				size_t compSize = ZSTD_compress(compBuf, bounds, data, size, ZSTD_maxCLevel());
+			ZSTD_CCtx* cctx = impl::context.get();
+			std::vector<uint8_t>& compBuf = impl::context.comp;
+			if (compBuf.size() < bounds) {
+				compBuf.resize(bounds);
+			}
+			if (cctx) {
+				size_t compSize;
+				if (impl::dictionary.cdict) {
+					compSize = ZSTD_compress_usingCDict(cctx, compBuf.data(), bounds, data, size, impl::dictionary.cdict);
+				} else {
+					compSize = ZSTD_compressCCtx(cctx, compBuf.data(), bounds, data, size, ZSTD_maxCLevel());
+				}
 				if (ZSTD_isError(compSize)) {
 					fprintf(stderr, "Compression failed: %s\n", ZSTD_getErrorName(compSize));
 				} else {
-					if (size == static_cast<size_t>(ZSTD_getFrameContentSize(compBuf, compSize))) {
-						success = impl::write(dstPath, compBuf, compSize, text);
+					if (size == static_cast<size_t>(ZSTD_getFrameContentSize(compBuf.data(), compSize))) {
+						success = impl::write(dstPath, compBuf.data(), compSize, text);
 					} else {
 						fprintf(stderr, "Unexpected frame content size (internal error)\n");
 					}
 				}
-				free(compBuf);
 			}
 		} else {
 			success = impl::write(dstPath, data, size, text);
@@ -102,3 +236,348 @@ bool write(const char* const dstPath, const void* const data, size_t const size,
 	}
 	return success;
 }
+
+//******************************** StreamWriter *******************************/
+
+StreamWriter::StreamWriter()
+	: file (nullptr)
+	, total(0)
+	, added(0)
+	, count(0)
+	, text (false)
+	, zstd (false)
+	, valid(false) {}
+
+StreamWriter::~StreamWriter() {
+	close();
+}
+
+bool StreamWriter::open(const char* const dstPath, size_t const size, bool const text, bool const zstd) {
+	close();
+	if (dstPath) {
+		if (zstd) {
+			/*
+			 * The streaming equivalent of write(), with the pledged size so the
+			 * frame still contains the content size.
+			 */
+			ZSTD_CCtx* cctx = impl::context.get();
+			if (!cctx) {
+				return false;
+			}
+			ZSTD_CCtx_reset(cctx, ZSTD_reset_session_and_parameters);
+			ZSTD_CCtx_setParameter(cctx, ZSTD_c_compressionLevel, ZSTD_maxCLevel());
+			ZSTD_CCtx_refCDict(cctx, impl::dictionary.cdict);
+			ZSTD_CCtx_setPledgedSrcSize(cctx, size);
+			std::vector<uint8_t>& compBuf = impl::context.comp;
+			if (compBuf.size() < ZSTD_CStreamOutSize()) {
+				compBuf.resize(ZSTD_CStreamOutSize());
+			}
+		}
+		file = fopen(dstPath, (text) ? "w" : "wb");
+		this->total = size;
+		this->added = 0;
+		this->count = 0;
+		this->text  = text;
+		this->zstd  = zstd;
+		this->valid = file != nullptr;
+	}
+	return valid;
+}
+
+bool StreamWriter::write(const void* const data, size_t const size) {
+	if (file && valid && data) {
+		added += size;
+		if (zstd) {
+			ZSTD_CCtx* cctx = impl::context.get();
+			std::vector<uint8_t>& compBuf = impl::context.comp;
+			ZSTD_inBuffer in = {data, size, 0};
+			while (valid && in.pos < in.size) {
+				ZSTD_outBuffer out = {compBuf.data(), compBuf.size(), 0};
+				size_t err = ZSTD_compressStream2(cctx, &out, &in, ZSTD_e_continue);
+				if (ZSTD_isError(err)) {
+					fprintf(stderr, "Compression failed: %s\n", ZSTD_getErrorName(err));
+					valid = false;
+				} else {
+					valid = emit(out.dst, out.pos);
+				}
+			}
+		} else {
+			valid = emit(data, size);
+		}
+	}
+	return valid;
+}
+
+bool StreamWriter::close() {
+	if (!file) {
+		return false;
+	}
+	if (valid && zstd) {
+		ZSTD_CCtx* cctx = impl::context.get();
+		std::vector<uint8_t>& compBuf = impl::context.comp;
+		ZSTD_inBuffer in = {nullptr, 0, 0};
+		size_t remaining;
+		do {
+			ZSTD_outBuffer out = {compBuf.data(), compBuf.size(), 0};
+			remaining = ZSTD_compressStream2(cctx, &out, &in, ZSTD_e_end);
+			if (ZSTD_isError(remaining)) {
+				fprintf(stderr, "Compression failed: %s\n", ZSTD_getErrorName(remaining));
+				valid = false;
+			} else {
+				valid = emit(out.dst, out.pos);
+			}
+		} while (valid && remaining != 0);
+	}
+	if (text && count > 0) {
+		valid &= fputc('\n', file) != EOF;
+	}
+	valid &= fclose(file) == 0;
+	valid &= added == total;
+	file = nullptr;
+	return valid;
+}
+
+bool StreamWriter::emit(const void* const data, size_t const size) {
+	if (!text) {
+		return fwrite(data, 1, size, file) == size;
+	}
+	/*
+	 * Same format as write() but with the separator written *before* each
+	 * entry, since a compressed stream doesn't know its total size (the final
+	 * newline is written when closing).
+	 */
+	const uint8_t* bytes = static_cast<const uint8_t*>(data);
+	for (size_t n = 0; n < size; n++) {
+		if (count > 0) {
+			if (fputc((count % 12) ? ' ' : '\n', file) == EOF) {
+				return false;
+			}
+		}
+		if (fprintf(file, "0x%02X,", bytes[n]) < 0) {
+			return false;
+		}
+		count++;
+	}
+	return true;
+}
+
+//*****************************************************************************/
+
+bool setDictionary(const char* const dictPath) {
+	ZSTD_freeCDict(impl::dictionary.cdict);
+	impl::dictionary.cdict = nullptr;
+	if (dictPath) {
+		std::vector<uint8_t> dict;
+		if (read(dictPath, dict)) {
+			impl::dictionary.cdict = ZSTD_createCDict(dict.data(), dict.size(), ZSTD_maxCLevel());
+		}
+		return impl::dictionary.cdict != nullptr;
+	}
+	return true;
+}
+
+bool train(const char* const dictPath, const char* const* const srcPaths, size_t const count) {
+	/*
+	 * The samples are concatenated into a single buffer, with a separate
+	 * array of sizes, as required by the trainer.
+	 */
+	std::vector<uint8_t> samples;
+	std::vector<size_t>  sizes;
+	std::vector<uint8_t> data;
+	for (size_t n = 0; n < count; n++) {
+		if (read(srcPaths[n], data)) {
+			samples.insert(samples.end(), data.begin(), data.end());
+			sizes.push_back(data.size());
+		} else {
+			fprintf(stderr, "Unable to read: %s\n", (srcPaths[n]) ? srcPaths[n] : "null");
+		}
+	}
+	if (sizes.empty()) {
+		return false;
+	}
+	std::vector<uint8_t> dict(O2B_DICT_MAX_SIZE);
+	size_t dictSize = ZDICT_trainFromBuffer(dict.data(), dict.size(), samples.data(), sizes.data(), static_cast<unsigned>(sizes.size()));
+	if (ZDICT_isError(dictSize)) {
+		fprintf(stderr, "Dictionary training failed: %s\n", ZDICT_getErrorName(dictSize));
+		return false;
+	}
+	return impl::write(dictPath, dict.data(), dictSize);
+}
+
+bool read(const char* const srcPath, std::vector<uint8_t>& data) {
+	bool success = false;
+	if (srcPath) {
+		if (FILE* srcFile = fopen(srcPath, "rb")) {
+			if (fseek(srcFile, 0, SEEK_END) == 0) {
+				long size = ftell(srcFile);
+				if (size >= 0 && fseek(srcFile, 0, SEEK_SET) == 0) {
+					data.resize(static_cast<size_t>(size));
+					success = fread(data.data(), 1, data.size(), srcFile) == data.size();
+				}
+			}
+			fclose(srcFile);
+		}
+	}
+	return success;
+}
+
+//******************************** MappedFile *********************************/
+
+MappedFile::MappedFile()
+	: head  (nullptr)
+	, used  (0)
+	, mapped(false) {}
+
+MappedFile::~MappedFile() {
+	close();
+}
+
+bool MappedFile::open(const char* const srcPath) {
+	close();
+	if (!srcPath) {
+		return false;
+	}
+#ifdef O2B_HAS_MMAP
+	int const fd = ::open(srcPath, O_RDONLY);
+	if (fd >= 0) {
+		struct stat info;
+		bool valid = false;
+		if (fstat(fd, &info) == 0 && S_ISREG(info.st_mode)) {
+			valid = true;
+			if (info.st_size > 0) {
+				void* const data = mmap(nullptr, static_cast<size_t>(info.st_size), PROT_READ, MAP_PRIVATE, fd, 0);
+				if (data != MAP_FAILED) {
+					head   = static_cast<const uint8_t*>(data);
+					used   = static_cast<size_t>(info.st_size);
+					mapped = true;
+				}
+			}
+		}
+		::close(fd);
+		if (mapped || (valid && info.st_size == 0)) {
+			return true;
+		}
+	}
+#endif
+	// No mapping (or it failed) so fall back to reading the content
+	if (read(srcPath, copy)) {
+		head = copy.data();
+		used = copy.size();
+		return true;
+	}
+	return false;
+}
+
+void MappedFile::close() {
+#ifdef O2B_HAS_MMAP
+	if (mapped) {
+		munmap(const_cast<uint8_t*>(head), used);
+	}
+#endif
+	copy.clear();
+	head   = nullptr;
+	used   = 0;
+	mapped = false;
+}
+
+//*****************************************************************************/
+
+bool replace(const char* const dstPath, const void* const data, size_t const size) {
+	if (!dstPath) {
+		return false;
+	}
+	/*
+	 * The temporary is unique to this process (from the PID) and to each
+	 * call within it (from the counter), so concurrent writers of the same
+	 * destination (other build workers, or other threads) never share one.
+	 * The rename is atomic on POSIX; on Windows it fails if the destination
+	 * exists, so we remove it first and accept the tiny window.
+	 */
+	static std::atomic<unsigned> counter(0);
+#ifdef _WIN32
+	unsigned long const pid = static_cast<unsigned long>(_getpid());
+#elif defined(__unix__) || defined(__APPLE__)
+	unsigned long const pid = static_cast<unsigned long>(getpid());
+#else
+	unsigned long const pid = 0;
+#endif
+	std::vector<char> tmpPath(strlen(dstPath) + 48);
+	snprintf(tmpPath.data(), tmpPath.size(), "%s.%lu.%u.tmp", dstPath, pid, counter++);
+	if (impl::write(tmpPath.data(), data, size)) {
+	#ifdef _WIN32
+		remove(dstPath);
+	#endif
+		if (rename(tmpPath.data(), dstPath) == 0) {
+			return true;
+		}
+	}
+	remove(tmpPath.data());
+	return false;
+}
+
+bool copy(const char* const srcPath, const char* const dstPath) {
+	if (srcPath && dstPath) {
+		std::vector<uint8_t> data;
+		if (read(srcPath, data)) {
+			return replace(dstPath, data.data(), data.size());
+		}
+	}
+	return false;
+}
+
+bool exists(const char* const path) {
+	if (path) {
+		if (FILE* file = fopen(path, "rb")) {
+			fclose(file);
+			return true;
+		}
+	}
+	return false;
+}
+
+uint64_t hash(const void* const data, size_t const size, uint64_t const seed) {
+	const uint8_t* next = static_cast<const uint8_t*>(data);
+	const uint8_t* over = next + ((data) ? size : 0);
+	uint64_t h64;
+	if (size >= 32 && data) {
+		uint64_t v1 = seed + impl::XXH_PRIME64_1 + impl::XXH_PRIME64_2;
+		uint64_t v2 = seed + impl::XXH_PRIME64_2;
+		uint64_t v3 = seed;
+		uint64_t v4 = seed - impl::XXH_PRIME64_1;
+		do {
+			v1 = impl::xxhRound(v1, impl::readLE64(next +  0));
+			v2 = impl::xxhRound(v2, impl::readLE64(next +  8));
+			v3 = impl::xxhRound(v3, impl::readLE64(next + 16));
+			v4 = impl::xxhRound(v4, impl::readLE64(next + 24));
+			next += 32;
+		} while (next + 32 <= over);
+		h64 = impl::rotl64(v1, 1) + impl::rotl64(v2, 7) + impl::rotl64(v3, 12) + impl::rotl64(v4, 18);
+		h64 = impl::xxhMerge(h64, v1);
+		h64 = impl::xxhMerge(h64, v2);
+		h64 = impl::xxhMerge(h64, v3);
+		h64 = impl::xxhMerge(h64, v4);
+	} else {
+		h64 = seed + impl::XXH_PRIME64_5;
+	}
+	h64 += static_cast<uint64_t>(over - static_cast<const uint8_t*>(data));
+	while (next + 8 <= over) {
+		h64 ^= impl::xxhRound(0, impl::readLE64(next));
+		h64  = impl::rotl64(h64, 27) * impl::XXH_PRIME64_1 + impl::XXH_PRIME64_4;
+		next += 8;
+	}
+	if (next + 4 <= over) {
+		h64 ^= impl::readLE32(next) * impl::XXH_PRIME64_1;
+		h64  = impl::rotl64(h64, 23) * impl::XXH_PRIME64_2 + impl::XXH_PRIME64_3;
+		next += 4;
+	}
+	while (next < over) {
+		h64 ^= (*next++) * impl::XXH_PRIME64_5;
+		h64  = impl::rotl64(h64, 11) * impl::XXH_PRIME64_1;
+	}
+	h64 ^= h64 >> 33;
+	h64 *= impl::XXH_PRIME64_2;
+	h64 ^= h64 >> 29;
+	h64 *= impl::XXH_PRIME64_3;
+	h64 ^= h64 >> 32;
+	return h64;
+}
@@ -0,0 +1,756 @@
+/**
+ * \file gltf.cpp
+ *
+ * \copyright 2022 Numfum GmbH
+ */
+#include "gltf.h"
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+#include <algorithm>
+#include <string>
+
+/**
+ * \def O2B_JSON_MAX_DEPTH
+ * Deepest nesting of JSON arrays and objects accepted (glTF needs very few
+ * levels, this just stops malformed files overflowing the stack).
+ */
+#ifndef O2B_JSON_MAX_DEPTH
+#define O2B_JSON_MAX_DEPTH 64
+#endif
+
+namespace impl {
+/**
+ * \c .glb header magic (\c glTF as a little-endian 32-bit value).
+ */
+uint32_t const GLB_MAGIC = 0x46546C67;
+/**
+ * \c .glb JSON chunk type (\c JSON).
+ */
+uint32_t const GLB_JSON  = 0x4E4F534A;
+/**
+ * \c .glb binary chunk type (\c BIN followed by a zero).
+ */
+uint32_t const GLB_BIN   = 0x004E4942;
+/**
+ * Helper to read an unaligned little-endian 16-bit value (glTF's buffers are
+ * always little-endian, regardless of the host).
+ */
+inline uint16_t readLE16(const uint8_t* const src) {
+	return static_cast<uint16_t>(src[0] | (src[1] << 8));
+}
+/**
+ * Helper to read an unaligned little-endian 32-bit value.
+ */
+inline uint32_t readLE32(const uint8_t* const src) {
+	return  static_cast<uint32_t>(src[0])
+		 | (static_cast<uint32_t>(src[1]) <<  8)
+		 | (static_cast<uint32_t>(src[2]) << 16)
+		 | (static_cast<uint32_t>(src[3]) << 24);
+}
+/**
+ * Bytes per component of a \c GltfFile#ComponentType (or zero if invalid).
+ */
+size_t compSize(unsigned const type) {
+	switch (type) {
+	case GltfFile::BYTE:
+	case GltfFile::UBYTE:
+		return 1;
+	case GltfFile::SHORT:
+	case GltfFile::USHORT:
+		return 2;
+	case GltfFile::UINT:
+	case GltfFile::FLOAT:
+		return 4;
+	default:
+		return 0;
+	}
+}
+
+//******************************** JSON parsing *******************************/
+
+/**
+ * Type of a parsed JSON value.
+ */
+enum JsonType {
+	JSON_NULL,
+	JSON_BOOL,
+	JSON_NUMBER,
+	JSON_STRING,
+	JSON_ARRAY,
+	JSON_OBJECT,
+};
+/**
+ * A single parsed JSON value, with arrays and objects linking to their first
+ * child, and each child to its next sibling (as indices into \c Json#nodes).
+ */
+struct JsonNode {
+	JsonType type;    /**< Type of value. */
+	size_t key;       /**< Offset of the member name in the text (if the parent is an object). */
+	size_t keyLen;    /**< Number of bytes in the member name. */
+	size_t str;       /**< Offset of the string content in the text (escape sequences being left as-is). */
+	size_t strLen;    /**< Number of bytes in the string. */
+	double num;       /**< Number (or \c 1 for \c true). */
+	int first;        /**< First child (or \c -1 if none). */
+	int next;         /**< Next sibling (or \c -1 if none). */
+};
+/**
+ * Minimal JSON parser, for glTF's scene description. The text is parsed in one
+ * go into a flat list of nodes, with lookups being linear (which is fine for
+ * the handful of entries in a typical glTF).
+ */
+class Json
+{
+public:
+	/**
+	 * Parses a JSON document.
+	 *
+	 * \param[in] data start of the JSON text
+	 * \param[in] size number of bytes of text
+	 * \return \c true if the text was valid JSON (with the root being node \c 0)
+	 */
+	bool parse(const char* const data, size_t const size) {
+		text.assign(data, size);
+		nodes.clear();
+		next = 0;
+		if (value(0) == 0) {
+			skipSpace();
+			return next == text.size();
+		}
+		return false;
+	}
+	/**
+	 * Finds an object's member.
+	 *
+	 * \param[in] obj object node (with anything else, including \c -1, finding nothing)
+	 * \param[in] key member name
+	 * \return the member's node (or \c -1 if not found)
+	 */
+	int member(int const obj, const char* const key) const {
+		if (obj >= 0 && nodes[obj].type == JSON_OBJECT) {
+			size_t const len = strlen(key);
+			for (int n = nodes[obj].first; n >= 0; n = nodes[n].next) {
+				if (nodes[n].keyLen == len && text.compare(nodes[n].key, len, key) == 0) {
+					return n;
+				}
+			}
+		}
+		return -1;
+	}
+	/**
+	 * Finds an array's element.
+	 *
+	 * \param[in] arr array node (with anything else, including \c -1, finding nothing)
+	 * \param[in] idx element to find
+	 * \return the element's node (or \c -1 if out of range)
+	 */
+	int element(int const arr, size_t idx) const {
+		if (arr >= 0 && nodes[arr].type == JSON_ARRAY) {
+			for (int n = nodes[arr].first; n >= 0; n = nodes[n].next) {
+				if (idx-- == 0) {
+					return n;
+				}
+			}
+		}
+		return -1;
+	}
+	/**
+	 * Reads a number (or a \c bool as \c 0 or \c 1).
+	 *
+	 * \param[in] node number node
+	 * \param[in] def default if \a node isn't a number (or is \c -1)
+	 * \return the number (or \a def)
+	 */
+	double number(int const node, double const def) const {
+		if (node >= 0 && (nodes[node].type == JSON_NUMBER || nodes[node].type == JSON_BOOL)) {
+			return nodes[node].num;
+		}
+		return def;
+	}
+	/**
+	 * Reads a non-negative integer (e.g. an index into another array).
+	 *
+	 * \param[in] node number node
+	 * \param[out] dst destination for the integer
+	 * \return \c true if \a node was a number which could be stored in \a dst
+	 */
+	bool index(int const node, size_t& dst) const {
+		double const num = number(node, -1.0);
+		if (num >= 0.0 && num <= static_cast<double>(SIZE_MAX) && num == static_cast<double>(static_cast<size_t>(num))) {
+			dst = static_cast<size_t>(num);
+			return true;
+		}
+		return false;
+	}
+	/**
+	 * Reads a string (without processing escape sequences).
+	 *
+	 * \param[in] node string node
+	 * \param[out] dst destination for the string
+	 * \return \c true if \a node was a string
+	 */
+	bool string(int const node, std::string& dst) const {
+		if (node >= 0 && nodes[node].type == JSON_STRING) {
+			dst.assign(text, nodes[node].str, nodes[node].strLen);
+			return true;
+		}
+		return false;
+	}
+	/**
+	 * Tests whether a string node has a given value.
+	 *
+	 * \param[in] node string node
+	 * \param[in] str value to compare
+	 * \return \c true if \a node was a string matching \a str
+	 */
+	bool equals(int const node, const char* const str) const {
+		if (node >= 0 && nodes[node].type == JSON_STRING) {
+			size_t const len = strlen(str);
+			return nodes[node].strLen == len && text.compare(nodes[node].str, len, str) == 0;
+		}
+		return false;
+	}
+	/**
+	 * First child of an array or object (or \c -1 if empty or \a node is something else).
+	 */
+	int first(int const node) const {
+		return (node >= 0) ? nodes[node].first : -1;
+	}
+	/**
+	 * Next sibling (or \c -1 if \a node is the last).
+	 */
+	int sibling(int const node) const {
+		return nodes[node].next;
+	}
+private:
+	/**
+	 * Skips any whitespace.
+	 */
+	void skipSpace() {
+		while (next < text.size() && (text[next] == ' ' || text[next] == '\t' || text[next] == '\n' || text[next] == '\r')) {
+			next++;
+		}
+	}
+	/**
+	 * Parses the string starting at the current quote.
+	 *
+	 * \param[out] start offset of the string's content
+	 * \param[out] len number of bytes in the content
+	 * \return \c true if the string was terminated
+	 */
+	bool string(size_t& start, size_t& len) {
+		start = ++next;
+		while (next < text.size()) {
+			char const c = text[next++];
+			if (c == '"') {
+				len = next - start - 1;
+				return true;
+			}
+			if (c == '\\') {
+				next++;
+			}
+		}
+		return false;
+	}
+	/**
+	 * Parses the value at the current position (plus, for arrays and
+	 * objects, all of its children).
+	 *
+	 * \param[in] depth nesting depth of the value
+	 * \return the value's node (or \c -1 if the text was invalid)
+	 */
+	int value(unsigned const depth) {
+		skipSpace();
+		if (next >= text.size() || depth > O2B_JSON_MAX_DEPTH) {
+			return -1;
+		}
+		int const node = static_cast<int>(nodes.size());
+		JsonNode entry = {JSON_NULL, 0, 0, 0, 0, 0.0, -1, -1};
+		nodes.push_back(entry);
+		char const c = text[next];
+		if (c == '{' || c == '[') {
+			bool const isObj = (c == '{');
+			nodes[node].type = (isObj) ? JSON_OBJECT : JSON_ARRAY;
+			next++;
+			skipSpace();
+			if (next < text.size() && text[next] == (isObj ? '}' : ']')) {
+				next++;
+				return node;
+			}
+			int prev = -1;
+			while (true) {
+				size_t key = 0;
+				size_t keyLen = 0;
+				if (isObj) {
+					skipSpace();
+					if (next >= text.size() || text[next] != '"' || !string(key, keyLen)) {
+						return -1;
+					}
+					skipSpace();
+					if (next >= text.size() || text[next++] != ':') {
+						return -1;
+					}
+				}
+				int const child = value(depth + 1);
+				if (child < 0) {
+					return -1;
+				}
+				nodes[child].key    = key;
+				nodes[child].keyLen = keyLen;
+				if (prev < 0) {
+					nodes[node].first = child;
+				} else {
+					nodes[prev].next  = child;
+				}
+				prev = child;
+				skipSpace();
+				if (next >= text.size()) {
+					return -1;
+				}
+				char const term = text[next++];
+				if (term == (isObj ? '}' : ']')) {
+					return node;
+				}
+				if (term != ',') {
+					return -1;
+				}
+			}
+		}
+		if (c == '"') {
+			nodes[node].type = JSON_STRING;
+			return (string(nodes[node].str, nodes[node].strLen)) ? node : -1;
+		}
+		if (text.compare(next, 4, "true") == 0) {
+			nodes[node].type = JSON_BOOL;
+			nodes[node].num  = 1.0;
+			next += 4;
+			return node;
+		}
+		if (text.compare(next, 5, "false") == 0) {
+			nodes[node].type = JSON_BOOL;
+			next += 5;
+			return node;
+		}
+		if (text.compare(next, 4, "null") == 0) {
+			next += 4;
+			return node;
+		}
+		// The text is a std::string, so strtod() always stops at its terminator
+		const char* const from = text.c_str() + next;
+		char* end = nullptr;
+		nodes[node].type = JSON_NUMBER;
+		nodes[node].num  = strtod(from, &end);
+		if (end == from) {
+			return -1;
+		}
+		next += static_cast<size_t>(end - from);
+		return node;
+	}
+
+	std::string text;            /**< Copy of the JSON text (null terminated, for parsing numbers). */
+	std::vector<JsonNode> nodes; /**< Parsed values (the root being the first). */
+	size_t next;                 /**< Current parsing offset. */
+};
+
+//******************************* glTF helpers ********************************/
+
+/**
+ * Helper to decode a base64 data URI's payload.
+ *
+ * \param[in] uri data URI (\c data: followed by the media type and \c ;base64,)
+ * \param[out] dst destination for the decoded bytes
+ * \return \c true if \a uri was a base64 data URI
+ */
+bool decodeDataUri(const std::string& uri, std::vector<uint8_t>& dst) {
+	size_t const comma = uri.find(',');
+	if (uri.compare(0, 5, "data:") != 0 || comma == std::string::npos || comma < 7 || uri.compare(comma - 7, 7, ";base64") != 0) {
+		return false;
+	}
+	dst.clear();
+	dst.reserve((uri.size() - comma) / 4 * 3);
+	uint32_t bits  = 0;
+	unsigned count = 0;
+	for (size_t n = comma + 1; n < uri.size(); n++) {
+		char const c = uri[n];
+		uint32_t val;
+		if (c >= 'A' && c <= 'Z') {
+			val = c - 'A';
+		} else if (c >= 'a' && c <= 'z') {
+			val = c - 'a' + 26;
+		} else if (c >= '0' && c <= '9') {
+			val = c - '0' + 52;
+		} else if (c == '+' || c == '-') {
+			val = 62;
+		} else if (c == '/' || c == '_') {
+			val = 63;
+		} else if (c == '=') {
+			break;
+		} else {
+			return false;
+		}
+		bits = (bits << 6) | val;
+		if (++count == 4) {
+			dst.push_back(static_cast<uint8_t>(bits >> 16));
+			dst.push_back(static_cast<uint8_t>(bits >>  8));
+			dst.push_back(static_cast<uint8_t>(bits));
+			bits  = 0;
+			count = 0;
+		}
+	}
+	if (count >= 2) {
+		bits <<= 6 * (4 - count);
+		dst.push_back(static_cast<uint8_t>(bits >> 16));
+		if (count == 3) {
+			dst.push_back(static_cast<uint8_t>(bits >> 8));
+		}
+	}
+	return true;
+}
+/**
+ * Helper to create the path of a buffer relative to the glTF file (decoding
+ * any percent-encoded characters in the URI).
+ *
+ * \param[in] srcPath filename of the glTF file
+ * \param[in] uri relative URI of the buffer
+ * \return path to the buffer
+ */
+std::string relativePath(const char* const srcPath, const std::string& uri) {
+	std::string path(srcPath);
+	size_t const slash = path.find_last_of("/\\");
+	path.resize((slash == std::string::npos) ? 0 : slash + 1);
+	for (size_t n = 0; n < uri.size(); n++) {
+		if (uri[n] == '%' && n + 2 < uri.size()) {
+			char hex[3] = {uri[n + 1], uri[n + 2], 0};
+			char* end = nullptr;
+			long const val = strtol(hex, &end, 16);
+			if (end == hex + 2) {
+				path.push_back(static_cast<char>(val));
+				n += 2;
+				continue;
+			}
+		}
+		path.push_back(uri[n]);
+	}
+	return path;
+}
+/**
+ * Helper to find the JSON of a glTF file's content, either the entire content
+ * of a \c .gltf or the first chunk of a \c .glb (along with its optional
+ * binary chunk).
+ *
+ * \param[in] data start of the file's content
+ * \param[in] size number of bytes in the content
+ * \param[out] json start of the JSON text
+ * \param[out] jsonLen number of bytes of JSON
+ * \param[out] bin start of the \c .glb binary chunk (or \c null if there is none)
+ * \param[out] binLen number of bytes in the binary chunk
+ * \return \c true if the content was valid (with \a json set)
+ */
+bool findChunks(const uint8_t* const data, size_t const size, const char*& json, size_t& jsonLen, const uint8_t*& bin, size_t& binLen) {
+	bin    = nullptr;
+	binLen = 0;
+	if (size >= 12 && readLE32(data) == GLB_MAGIC) {
+		/*
+		 * Binary glTF: a 12-byte header, the JSON chunk, then an optional
+		 * binary chunk (which is buffer zero). Each chunk has an 8-byte header
+		 * of its length and type.
+		 */
+		if (readLE32(data + 4) != 2) {
+			fprintf(stderr, "Unsupported glTF version: %u\n", readLE32(data + 4));
+			return false;
+		}
+		size_t const total = std::min<size_t>(readLE32(data + 8), size);
+		if (total < 20 || readLE32(data + 16) != GLB_JSON) {
+			return false;
+		}
+		jsonLen = readLE32(data + 12);
+		if (jsonLen > total - 20) {
+			return false;
+		}
+		json = reinterpret_cast<const char*>(data + 20);
+		size_t const binHead = 20 + ((jsonLen + 3) & ~static_cast<size_t>(3));
+		if (binHead + 8 <= total && readLE32(data + binHead + 4) == GLB_BIN) {
+			binLen = std::min<size_t>(readLE32(data + binHead), total - binHead - 8);
+			bin    = data + binHead + 8;
+		}
+		return true;
+	}
+	// Otherwise the file is the JSON
+	json    = reinterpret_cast<const char*>(data);
+	jsonLen = size;
+	return true;
+}
+/**
+ * Helper to resolve an accessor from its index, validating it fits within its
+ * buffer view (and the view within its buffer).
+ *
+ * \param[in] doc glTF JSON
+ * \param[in] accessors the JSON's \c accessors array
+ * \param[in] views the JSON's \c bufferViews array
+ * \param[in] buffers resolved buffers
+ * \param[in] ref node containing the accessor's index (or \c -1 if the attribute is missing)
+ * \param[out] dst destination for the accessor (with \c null data if missing)
+ * \return \c true if the accessor was valid (or missing)
+ */
+bool accessor(const Json& doc, int const accessors, int const views, const std::vector<GltfFile::Buffer>& buffers, int const ref, GltfFile::Accessor& dst) {
+	dst.data = nullptr;
+	size_t idx = 0;
+	if (ref < 0) {
+		return true; // missing attributes aren't errors
+	}
+	if (!doc.index(ref, idx)) {
+		return false;
+	}
+	int const acc = doc.element(accessors, idx);
+	size_t viewIdx = 0;
+	if (acc < 0 || doc.member(acc, "sparse") >= 0 || !doc.index(doc.member(acc, "bufferView"), viewIdx)) {
+		fprintf(stderr, "Unsupported glTF accessor (sparse or without a buffer view)\n");
+		return false;
+	}
+	int const view = doc.element(views, viewIdx);
+	size_t bufIdx = 0;
+	size_t viewLen = 0;
+	if (view < 0 || !doc.index(doc.member(view, "buffer"), bufIdx) || bufIdx >= buffers.size()
+		|| !doc.index(doc.member(view, "byteLength"), viewLen)) {
+		return false;
+	}
+	size_t viewOff = 0;
+	size_t accOff  = 0;
+	size_t stride  = 0;
+	if (doc.member(view, "byteOffset") >= 0 && !doc.index(doc.member(view, "byteOffset"), viewOff)) {
+		return false;
+	}
+	if (doc.member(acc,  "byteOffset") >= 0 && !doc.index(doc.member(acc,  "byteOffset"), accOff)) {
+		return false;
+	}
+	if (doc.member(view, "byteStride") >= 0 && !doc.index(doc.member(view, "byteStride"), stride)) {
+		return false;
+	}
+	static const char* const types[] = {"SCALAR", "VEC2", "VEC3", "VEC4"};
+	int const type = doc.member(acc, "type");
+	dst.comps = 0;
+	for (unsigned n = 0; n < 4; n++) {
+		if (doc.equals(type, types[n])) {
+			dst.comps = n + 1;
+		}
+	}
+	size_t compType = 0;
+	if (!doc.index(doc.member(acc, "count"), dst.count) || !doc.index(doc.member(acc, "componentType"), compType) || dst.comps == 0) {
+		return false;
+	}
+	dst.compType   = static_cast<unsigned>(compType);
+	dst.normalized = doc.number(doc.member(acc, "normalized"), 0.0) != 0.0;
+	size_t const elemSize = impl::compSize(dst.compType) * dst.comps;
+	if (elemSize == 0) {
+		return false;
+	}
+	dst.stride = (stride) ? stride : elemSize;
+	const GltfFile::Buffer& buf = buffers[bufIdx];
+	if (viewOff > buf.size || viewLen > buf.size - viewOff || accOff > viewLen) {
+		return false;
+	}
+	if (dst.count > 0 && (dst.count - 1 > (viewLen - accOff) / dst.stride || (dst.count - 1) * dst.stride + elemSize > viewLen - accOff)) {
+		fprintf(stderr, "glTF accessor exceeds its buffer view\n");
+		return false;
+	}
+	dst.data = buf.data + viewOff + accOff;
+	return true;
+}
+}
+
+//*****************************************************************************/
+
+float GltfFile::Accessor::get(size_t const idx, unsigned const comp) const {
+	const uint8_t* const src = data + idx * stride + comp * impl::compSize(compType);
+	switch (compType) {
+	case BYTE: {
+		float const val = static_cast<int8_t>(src[0]);
+		return (normalized) ? std::max(val / 127.0f, -1.0f) : val;
+	}
+	case UBYTE: {
+		float const val = src[0];
+		return (normalized) ? val / 255.0f : val;
+	}
+	case SHORT: {
+		float const val = static_cast<int16_t>(impl::readLE16(src));
+		return (normalized) ? std::max(val / 32767.0f, -1.0f) : val;
+	}
+	case USHORT: {
+		float const val = impl::readLE16(src);
+		return (normalized) ? val / 65535.0f : val;
+	}
+	case UINT:
+		return static_cast<float>(impl::readLE32(src));
+	default: {
+		uint32_t const bits = impl::readLE32(src);
+		float val;
+		memcpy(&val, &bits, sizeof val);
+		return val;
+	}
+	}
+}
+
+uint32_t GltfFile::Accessor::index(size_t const idx) const {
+	const uint8_t* const src = data + idx * stride;
+	switch (compType) {
+	case UBYTE:
+		return src[0];
+	case USHORT:
+		return impl::readLE16(src);
+	default:
+		return impl::readLE32(src);
+	}
+}
+
+bool GltfFile::open(const char* const srcPath) {
+	prims.clear();
+	buffers.clear();
+	decoded.clear();
+	bins.clear();
+	const char* json = nullptr;
+	size_t jsonLen = 0;
+	const uint8_t* bin = nullptr;
+	size_t binLen = 0;
+	if (!file.open(srcPath) || !impl::findChunks(file.data(), file.size(), json, jsonLen, bin, binLen)) {
+		return false;
+	}
+	return parse(json, jsonLen, srcPath, bin, binLen);
+}
+
+bool GltfFile::externalPaths(const char* const srcPath, std::vector<std::string>& paths) {
+	paths.clear();
+	MappedFile src;
+	const char* json = nullptr;
+	size_t jsonLen = 0;
+	const uint8_t* bin = nullptr;
+	size_t binLen = 0;
+	impl::Json doc;
+	if (!src.open(srcPath) || !impl::findChunks(src.data(), src.size(), json, jsonLen, bin, binLen) || !doc.parse(json, jsonLen)) {
+		return false;
+	}
+	for (int buf = doc.first(doc.member(0, "buffers")); buf >= 0; buf = doc.sibling(buf)) {
+		std::string uri;
+		if (doc.string(doc.member(buf, "uri"), uri) && uri.compare(0, 5, "data:") != 0) {
+			paths.push_back(impl::relativePath(srcPath, uri));
+		}
+	}
+	return true;
+}
+
+bool GltfFile::parse(const char* const json, size_t const size, const char* const srcPath, const uint8_t* const bin, size_t const binSize) {
+	impl::Json doc;
+	if (!doc.parse(json, size)) {
+		fprintf(stderr, "Invalid glTF JSON\n");
+		return false;
+	}
+	int const root = 0;
+	// Compressed geometry can't be read directly, so is rejected
+	for (int ext = doc.first(doc.member(root, "extensionsRequired")); ext >= 0; ext = doc.sibling(ext)) {
+		if (doc.equals(ext, "KHR_draco_mesh_compression") || doc.equals(ext, "EXT_meshopt_compression")) {
+			std::string name;
+			doc.string(ext, name);
+			fprintf(stderr, "Unsupported glTF extension: %s\n", name.c_str());
+			return false;
+		}
+	}
+	/*
+	 * Buffers are either the .glb's binary chunk (the one without a URI),
+	 * base64 data URIs (decoded, so copied), or external files (mapped like
+	 * the .glb).
+	 */
+	for (int buf = doc.first(doc.member(root, "buffers")); buf >= 0; buf = doc.sibling(buf)) {
+		size_t len = 0;
+		if (!doc.index(doc.member(buf, "byteLength"), len)) {
+			return false;
+		}
+		Buffer entry = {nullptr, 0};
+		std::string uri;
+		if (doc.string(doc.member(buf, "uri"), uri)) {
+			if (uri.compare(0, 5, "data:") == 0) {
+				decoded.push_back(std::vector<uint8_t>());
+				if (!impl::decodeDataUri(uri, decoded.back())) {
+					fprintf(stderr, "Unsupported glTF buffer URI\n");
+					return false;
+				}
+				entry.data = decoded.back().data();
+				entry.size = decoded.back().size();
+			} else {
+				std::string const path = impl::relativePath(srcPath, uri);
+				bins.push_back(std::unique_ptr<MappedFile>(new MappedFile()));
+				if (!bins.back()->open(path.c_str())) {
+					fprintf(stderr, "Unable to read glTF buffer: %s\n", path.c_str());
+					return false;
+				}
+				entry.data = bins.back()->data();
+				entry.size = bins.back()->size();
+			}
+		} else {
+			entry.data = bin;
+			entry.size = binSize;
+		}
+		if (!entry.data || entry.size < len) {
+			fprintf(stderr, "Missing or truncated glTF buffer\n");
+			return false;
+		}
+		entry.size = len;
+		buffers.push_back(entry);
+	}
+	int const accessors = doc.member(root, "accessors");
+	int const views     = doc.member(root, "bufferViews");
+	/*
+	 * The first mesh with any triangles is taken, each triangle primitive
+	 * being validated (every index within the positions and every attribute
+	 * as long as the positions).
+	 */
+	for (int mesh = doc.first(doc.member(root, "meshes")); mesh >= 0 && prims.empty(); mesh = doc.sibling(mesh)) {
+		for (int prim = doc.first(doc.member(mesh, "primitives")); prim >= 0; prim = doc.sibling(prim)) {
+			size_t mode = TRIANGLES;
+			if (doc.member(prim, "mode") >= 0 && !doc.index(doc.member(prim, "mode"), mode)) {
+				return false;
+			}
+			if (mode != TRIANGLES && mode != TRIANGLE_STRIP && mode != TRIANGLE_FAN) {
+				continue;
+			}
+			int const attrs = doc.member(prim, "attributes");
+			Primitive entry;
+			entry.mode = static_cast<unsigned>(mode);
+			if (!impl::accessor(doc, accessors, views, buffers, doc.member(attrs, "POSITION"),   entry.posn)
+			 || !impl::accessor(doc, accessors, views, buffers, doc.member(attrs, "NORMAL"),     entry.norm)
+			 || !impl::accessor(doc, accessors, views, buffers, doc.member(attrs, "TEXCOORD_0"), entry.tex0)
+			 || !impl::accessor(doc, accessors, views, buffers, doc.member(attrs, "TEXCOORD_1"), entry.tex1)
+			 || !impl::accessor(doc, accessors, views, buffers, doc.member(attrs, "COLOR_0"),    entry.rgba)
+			 || !impl::accessor(doc, accessors, views, buffers, doc.member(attrs, "TANGENT"),    entry.tans)
+			 || !impl::accessor(doc, accessors, views, buffers, doc.member(prim,  "indices"),    entry.index)) {
+				fprintf(stderr, "Invalid glTF accessor\n");
+				return false;
+			}
+			if (!entry.posn.valid() || entry.posn.comps != 3) {
+				continue;
+			}
+			size_t const verts = entry.posn.count;
+			if ((entry.norm.valid() && (entry.norm.comps != 3 || entry.norm.count < verts))
+			 || (entry.tex0.valid() && (entry.tex0.comps != 2 || entry.tex0.count < verts))
+			 || (entry.tex1.valid() && (entry.tex1.comps != 2 || entry.tex1.count < verts))
+			 || (entry.rgba.valid() && (entry.rgba.comps  < 3 || entry.rgba.count < verts))
+			 || (entry.tans.valid() && (entry.tans.comps != 4 || entry.tans.count < verts))) {
+				fprintf(stderr, "Mismatched glTF vertex attributes\n");
+				return false;
+			}
+			if (entry.index.valid()) {
+				if (entry.index.comps != 1 || (entry.index.compType != UBYTE && entry.index.compType != USHORT && entry.index.compType != UINT)) {
+					return false;
+				}
+				for (size_t n = 0; n < entry.index.count; n++) {
+					if (entry.index.index(n) >= verts) {
+						fprintf(stderr, "glTF index out of range\n");
+						return false;
+					}
+				}
+			}
+			prims.push_back(entry);
+		}
+	}
+	return !prims.empty();
+}
@@ -17,16 +17,186 @@
  * \endcode
  */
 
+#include <cfloat>
+#include <cinttypes>
+#include <climits>
 #include <cstdlib>
 #include <cstdio>
+#include <cstring>
 
+#include <algorithm>
 #include <chrono>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
 
+#include "arena.h"
 #include "bufferlayout.h"
+#include "errorreport.h"
 #include "fileutils.h"
+#include "meshcache.h"
+#include "meshoptimizer.h"
 #include "objmesh.h"
 #include "tooloptions.h"
 
+/**
+ * \def O2B_METADATA_BYTES
+ * Size of the fixed part of the metadata: the magic, shortcode, offsets and
+ * sizes, then mesh scale and bias (followed by the variable sized layout).
+ */
+#ifndef O2B_METADATA_BYTES
+#define O2B_METADATA_BYTES (2 + 4 + 5 * 4 + 6 * 4)
+#endif
+
+/**
+ * \def O2B_SECTION_BYTES
+ * Size of each entry in the metadata's section table: the ID, offset, size in
+ * bytes and number of entries (see \c #SectionID).
+ */
+#ifndef O2B_SECTION_BYTES
+#define O2B_SECTION_BYTES (4 * 4)
+#endif
+
+/**
+ * \def O2B_CONTAINER_MAGIC
+ * Start of the v2 container (\c O2B2 as bytes in little endian files, so the
+ * byte order is also found from it, as it is from the original \c 0xBDA7).
+ */
+#ifndef O2B_CONTAINER_MAGIC
+#define O2B_CONTAINER_MAGIC 0x3242324FU
+#endif
+
+/**
+ * \def O2B_CONTAINER_VERSION
+ * Version of the container (following the magic). The original metadata,
+ * starting with \c 0xBDA7, is version \c 1.
+ */
+#ifndef O2B_CONTAINER_VERSION
+#define O2B_CONTAINER_VERSION 2
+#endif
+
+/**
+ * \def O2B_CONTAINER_BYTES
+ * Size of the fixed part of the v2 container's header: the magic, version,
+ * both shortcode words, section alignment and count, file size (as 64-bit),
+ * draw count, size of the layout, then mesh scale and bias (followed by the
+ * variable sized layout then, 8-byte aligned, the section table).
+ */
+#ifndef O2B_CONTAINER_BYTES
+#define O2B_CONTAINER_BYTES (4 + 4 + 4 + 4 + 4 + 4 + 8 + 4 + 4 + 6 * 4)
+#endif
+
+/**
+ * \def O2B_CONTAINER_SECTION_BYTES
+ * Size of each entry in the v2 container's section table: the ID and number
+ * of entries, then the offset and size in bytes (both as 64-bit).
+ */
+#ifndef O2B_CONTAINER_SECTION_BYTES
+#define O2B_CONTAINER_SECTION_BYTES (4 + 4 + 8 + 8)
+#endif
+
+/**
+ * \def O2B_STREAM_CHUNK
+ * Size in bytes of each chunk when streaming the output (see \c
+ * ToolOptions#stream).
+ */
+#ifndef O2B_STREAM_CHUNK
+#define O2B_STREAM_CHUNK (64 * 1024)
+#endif
+
+/**
+ * \def O2B_CONCURRENT_OUTPUTS
+ * Whether multiple outputs from the same source (see \c ToolOptions#outputs)
+ * are encoded and written concurrently, each on its own thread. Wasm builds
+ * aren't assumed to have threads.
+ */
+#ifndef O2B_CONCURRENT_OUTPUTS
+#ifdef __EMSCRIPTEN__
+#define O2B_CONCURRENT_OUTPUTS 0
+#else
+#define O2B_CONCURRENT_OUTPUTS 1
+#endif
+#endif
+
+/**
+ * IDs of the extra sections following the index data, listed in the
+ * metadata's section table (written after the layout header when the
+ * shortcode has \c ToolOptions#OPTS_EXTENDED set).
+ */
+enum SectionID {
+	/**
+	 * LOD ranges, each LOD stored as its first index and index count (as \c
+	 * uint32) followed by its error (as a \c float, in the mesh's original
+	 * units). For unindexed output the ranges are of vertices.
+	 */
+	SECTION_LODS = 1,
+	/**
+	 * Meshlet descriptors, each as the offset of its first vertex (in \c
+	 * SECTION_MESHLET_VERTS entries), offset of its first triangle (in \c
+	 * SECTION_MESHLET_TRIS bytes), vertex count and triangle count (all as \c
+	 * uint32).
+	 */
+	SECTION_MESHLETS = 2,
+	/**
+	 * Meshlet vertices, each an index into the vertex buffer (as \c uint32).
+	 */
+	SECTION_MESHLET_VERTS = 3,
+	/**
+	 * Meshlet triangles, as three bytes per triangle indexing the meshlet's
+	 * vertices (each meshlet's triangles are padded to four bytes).
+	 */
+	SECTION_MESHLET_TRIS = 4,
+	/**
+	 * Meshlet culling bounds, each as the bounding sphere's centre and radius,
+	 * normal cone's apex, then the cone's axis and cutoff (all as \c float, in
+	 * the mesh's original units).
+	 */
+	SECTION_MESHLET_BOUNDS = 5,
+	/**
+	 * Chunks of a split mesh, each stored as its first index and index count
+	 * followed by its base vertex (added to each of the chunk's indices) and
+	 * vertex count (all as \c uint32). Chunks never span LODs, so each LOD is
+	 * drawn as the chunks within its range.
+	 */
+	SECTION_CHUNKS = 6,
+	/**
+	 * Shadow index buffer for the full detail mesh, as a triangle list in the
+	 * same type as the main indices (padded with zeros to a multiple of four
+	 * bytes), referencing only vertices with unique positions (for
+	 * depth-only passes).
+	 */
+	SECTION_SHADOW = 7,
+	/**
+	 * Vertex data of one stream (only listed in the v2 container, with one
+	 * section per stream, in stream order). The count is the number of
+	 * vertices, with the stride being the bytes divided by the count.
+	 */
+	SECTION_VERTICES = 8,
+	/**
+	 * Index data, in the type from the shortcode (only listed in the v2
+	 * container, and only for indexed output).
+	 */
+	SECTION_INDICES = 9,
+};
+
+/**
+ * Extra section to write after the index data.
+ */
+struct Section {
+	SectionID id;    /**< Section type. */
+	unsigned  bytes; /**< Size of the section in bytes. */
+	unsigned  count; /**< Number of entries in the section. */
+};
+
+/**
+ * Mesh quality measured after an optimisation step (see \c #analyze()).
+ */
+struct Step {
+	const char*    name;  /**< Step name (e.g. \c "vcache"). */
+	ObjMesh::Stats stats; /**< Mesh quality after the step. */
+};
+
 /**
  * Helper to return the current time in milliseconds.
  *
@@ -38,60 +208,863 @@ static unsigned millis() {
 }
 
 /**
- * Load and convert.
+ * Helper to write a full chunk when streaming. If the \a packer doesn't have
+ * space for the next \a bytes its content is written to the \a stream then
+ * the packer is rewound (if not streaming the packer will always have space).
+ *
+ * \param[in] stream destination for the chunk (which may be unopened if not streaming)
+ * \param[in,out] packer packer wrapping the chunk
+ * \param[in] chunk start of the chunk (the packer's storage)
+ * \param[in] bytes number of bytes needed for the next addition
+ * \return \c VP_FAILED if writing the chunk failed
  */
-int main(int argc, const char* argv[]) {
-	ObjMesh mesh;
-	// Gather files and tool options
-	const char* srcPath = nullptr;
-	const char* dstPath = nullptr;
-	ToolOptions opts;
-	int srcIdx = opts.parseArgs(argv, argc);
+static VertexPacker::Failed flush(StreamWriter& stream, VertexPacker& packer, const uint8_t* const chunk, size_t const bytes) {
+	if (packer.remaining() < bytes) {
+		if (!stream.write(chunk, packer.size())) {
+			return VP_FAILED;
+		}
+		packer.rewind();
+	}
+	return VP_SUCCEEDED;
+}
+
+/**
+ * Helper to list the extra sections to write after the index data. These are
+ * only written with the metadata (since they're found from its table). The v2
+ * container also lists the vertices and indices, as the first sections.
+ *
+ * \param[in] opts tool options
+ * \param[in] layout buffer layout (for the container's vertex streams)
+ * \param[in] mesh mesh containing the section content (LODs, meshlets, etc.)
+ * \param[out] sections destination for the section descriptions
+ */
+static void gatherSections(const ToolOptions& opts, const BufferLayout& layout, const ObjMesh& mesh, std::vector<Section>& sections) {
+	sections.clear();
+	if (O2B_HAS_OPT(opts.opts, ToolOptions::OPTS_WRITE_METADATA)) {
+		if (opts.container) {
+			unsigned const verts = static_cast<unsigned>((opts.idxs) ? mesh.verts.size() : mesh.index.size());
+			for (unsigned s = 0; s < layout.getStreams(); s++) {
+				sections.push_back({SECTION_VERTICES, verts * layout.getStride(s), verts});
+			}
+			if (opts.idxs) {
+				unsigned const count = static_cast<unsigned>(mesh.index.size());
+				sections.push_back({SECTION_INDICES, count * opts.idxs.bytes(), count});
+			}
+		}
+		if (!mesh.lods.empty()) {
+			unsigned const count = static_cast<unsigned>(mesh.lods.size());
+			sections.push_back({SECTION_LODS, count * 12, count});
+		}
+		if (!mesh.meshlets.empty()) {
+			unsigned const count = static_cast<unsigned>(mesh.meshlets.size());
+			unsigned const verts = static_cast<unsigned>(mesh.meshletVerts.size());
+			unsigned const tris  = static_cast<unsigned>(mesh.meshletTris.size());
+			sections.push_back({SECTION_MESHLETS,       count * 16, count});
+			sections.push_back({SECTION_MESHLET_VERTS,  verts *  4, verts});
+			sections.push_back({SECTION_MESHLET_TRIS,   tris,       tris});
+			sections.push_back({SECTION_MESHLET_BOUNDS, count * 44, count});
+		}
+		if (!mesh.chunks.empty()) {
+			unsigned const count = static_cast<unsigned>(mesh.chunks.size());
+			sections.push_back({SECTION_CHUNKS, count * 16, count});
+		}
+		if (!mesh.shadow.empty()) {
+			unsigned const count = static_cast<unsigned>(mesh.shadow.size());
+			sections.push_back({SECTION_SHADOW, (count * opts.idxs.bytes() + 3) & ~3, count});
+		}
+	}
+}
+
+/**
+ * Helper to write the content of an extra section (see \c #SectionID for
+ * the formats).
+ *
+ * \param[in] stream destination for full chunks (see \c #flush())
+ * \param[in,out] packer packer wrapping the chunk
+ * \param[in] chunk start of the chunk (the packer's storage)
+ * \param[in] opts tool options (for the index type)
+ * \param[in] mesh mesh containing the section content
+ * \param[in] section which section to write
+ * \return \c VP_FAILED if adding to the \a packer failed
+ */
+static VertexPacker::Failed writeSection(StreamWriter& stream, VertexPacker& packer, const uint8_t* const chunk, const ToolOptions& opts, const ObjMesh& mesh, const Section& section) {
+	VertexPacker::Failed failed = false;
+	switch (section.id) {
+	case SECTION_VERTICES:
+		// Written by writeVertices() (needing the layout)
+		failed = VP_FAILED;
+		break;
+	case SECTION_INDICES:
+		for (std::vector<unsigned>::const_iterator it = mesh.index.begin(); it != mesh.index.end(); ++it) {
+			failed |= flush(stream, packer, chunk, opts.idxs.bytes());
+			failed |= packer.add(static_cast<int>(*it), opts.idxs);
+		}
+		break;
+	case SECTION_LODS:
+		for (std::vector<ObjMesh::Lod>::const_iterator it = mesh.lods.begin(); it != mesh.lods.end(); ++it) {
+			failed |= flush(stream, packer, chunk, 12);
+			failed |= packer.add(static_cast<int>(it->first), VertexPacker::Storage::UINT32C);
+			failed |= packer.add(static_cast<int>(it->count), VertexPacker::Storage::UINT32C);
+			failed |= packer.add(it->error, VertexPacker::Storage::FLOAT32);
+		}
+		break;
+	case SECTION_MESHLETS:
+		for (std::vector<ObjMesh::Meshlet>::const_iterator it = mesh.meshlets.begin(); it != mesh.meshlets.end(); ++it) {
+			failed |= flush(stream, packer, chunk, 16);
+			failed |= packer.add(it->vertOffset, VertexPacker::Storage::UINT32C);
+			failed |= packer.add(it->trisOffset, VertexPacker::Storage::UINT32C);
+			failed |= packer.add(it->vertCount,  VertexPacker::Storage::UINT32C);
+			failed |= packer.add(it->trisCount,  VertexPacker::Storage::UINT32C);
+		}
+		break;
+	case SECTION_MESHLET_VERTS:
+		for (std::vector<unsigned>::const_iterator it = mesh.meshletVerts.begin(); it != mesh.meshletVerts.end(); ++it) {
+			failed |= flush(stream, packer, chunk, 4);
+			failed |= packer.add(*it, VertexPacker::Storage::UINT32C);
+		}
+		break;
+	case SECTION_MESHLET_TRIS:
+		for (std::vector<uint8_t>::const_iterator it = mesh.meshletTris.begin(); it != mesh.meshletTris.end(); ++it) {
+			failed |= flush(stream, packer, chunk, 1);
+			failed |= packer.add(*it, VertexPacker::Storage::UINT08C);
+		}
+		break;
+	case SECTION_MESHLET_BOUNDS:
+		for (std::vector<ObjMesh::Meshlet>::const_iterator it = mesh.meshlets.begin(); it != mesh.meshlets.end(); ++it) {
+			failed |= flush(stream, packer, chunk, 44);
+			failed |= it->sphere  .store(packer, VertexPacker::Storage::FLOAT32);
+			failed |= it->coneApex.store(packer, VertexPacker::Storage::FLOAT32);
+			failed |= it->cone    .store(packer, VertexPacker::Storage::FLOAT32);
+		}
+		break;
+	case SECTION_CHUNKS:
+		for (std::vector<ObjMesh::Chunk>::const_iterator it = mesh.chunks.begin(); it != mesh.chunks.end(); ++it) {
+			failed |= flush(stream, packer, chunk, 16);
+			failed |= packer.add(static_cast<int>(it->first), VertexPacker::Storage::UINT32C);
+			failed |= packer.add(static_cast<int>(it->count), VertexPacker::Storage::UINT32C);
+			failed |= packer.add(static_cast<int>(it->base),  VertexPacker::Storage::UINT32C);
+			failed |= packer.add(static_cast<int>(it->verts), VertexPacker::Storage::UINT32C);
+		}
+		break;
+	case SECTION_SHADOW:
+		for (std::vector<unsigned>::const_iterator it = mesh.shadow.begin(); it != mesh.shadow.end(); ++it) {
+			failed |= flush(stream, packer, chunk, opts.idxs.bytes());
+			failed |= packer.add(static_cast<int>(*it), opts.idxs);
+		}
+		for (unsigned n = section.count * opts.idxs.bytes(); n < section.bytes; n++) {
+			failed |= flush(stream, packer, chunk, 1);
+			failed |= packer.add(0, VertexPacker::Storage::UINT08C);
+		}
+		break;
+	}
+	return failed;
+}
+
+/**
+ * Helper to write one stream of the vertex data, either each vertex once
+ * (indexed) or expanded from the indices (unindexed). Rather than pack each
+ * shared vertex every time it's used, unindexed vertices are packed once to a
+ * scratch buffer then copied.
+ *
+ * \param[in] stream destination for full chunks (see \c #flush())
+ * \param[in,out] packer packer wrapping the chunk
+ * \param[in] chunk start of the chunk (the packer's storage)
+ * \param[in] layout buffer layout
+ * \param[in] mesh mesh containing the vertices and indices
+ * \param[in] indexed \c true if the output is indexed
+ * \param[in] s index of the stream to write
+ * \param[in] base offset in the chunk from where the vertices are aligned
+ * \param[in] packOpts packer options (for the scratch buffer)
+ * \return \c VP_FAILED if adding to the \a packer failed
+ */
+static VertexPacker::Failed writeVertices(StreamWriter& stream, VertexPacker& packer, const uint8_t* const chunk, const BufferLayout& layout, const ObjMesh& mesh, bool const indexed, unsigned const s, size_t const base, unsigned const packOpts) {
+	VertexPacker::Failed failed = false;
+	int const only = (layout.getStreams() > 1) ? static_cast<int>(s) : -1;
+	size_t const streamStride = layout.getStride(s);
+	if (indexed) {
+		for (ObjVertex::Container::const_iterator it = mesh.verts.begin(); it != mesh.verts.end(); ++it) {
+			failed |= flush(stream, packer, chunk, streamStride);
+			failed |= layout.writeVertex(packer, *it, base, only);
+		}
+	} else {
+		std::vector<uint8_t, ArenaAllocator<uint8_t> > scratch(mesh.verts.size() * streamStride);
+		VertexPacker unique(scratch.data(), scratch.size(), packOpts);
+		for (ObjVertex::Container::const_iterator it = mesh.verts.begin(); it != mesh.verts.end(); ++it) {
+			failed |= layout.writeVertex(unique, *it, 0, only);
+		}
+		for (std::vector<unsigned>::const_iterator it = mesh.index.begin(); it != mesh.index.end(); ++it) {
+			if (*it < mesh.verts.size()) {
+				failed |= flush(stream, packer, chunk, streamStride);
+				failed |= packer.copy(scratch.data() + *it * streamStride, streamStride);
+			}
+		}
+	}
+	return failed;
+}
+
+/**
+ * Helper to add a 64-bit value as two 32-bit words, in the packer's byte
+ * order.
+ *
+ * \param[in,out] packer target for the value
+ * \param[in] val value to add
+ * \param[in] bigEndian \c true if the packer is writing big endian
+ * \return \c VP_FAILED if adding to the \a packer failed
+ */
+static VertexPacker::Failed add64(VertexPacker& packer, uint64_t const val, bool const bigEndian) {
+	VertexPacker::Failed failed = false;
+	unsigned const lo = static_cast<unsigned>(val);
+	unsigned const hi = static_cast<unsigned>(val >> 32);
+	failed |= packer.add((bigEndian) ? hi : lo, VertexPacker::Storage::UINT32C);
+	failed |= packer.add((bigEndian) ? lo : hi, VertexPacker::Storage::UINT32C);
+	return failed;
+}
+
+/**
+ * Helper to write the v2 container's header (see \c #O2B_CONTAINER_BYTES),
+ * the layout, then the section table. Unlike the original metadata, every
+ * part of the file is found from the table (so a runtime can map the file
+ * and use each section in-place).
+ *
+ * \param[in,out] packer target for the header
+ * \param[in] opts tool options
+ * \param[in] layout buffer layout
+ * \param[in] mesh mesh (for the scale and bias)
+ * \param[in] sections every section, in file order
+ * \param[in] offsets offset of each section from the start of the file
+ * \param[in] totalBytes size of the entire file
+ * \param[in] drawCount number of indices (or, for unindexed output, vertices) in the full detail mesh
+ * \return \c VP_FAILED if adding to the \a packer failed
+ */
+static VertexPacker::Failed writeContainer(VertexPacker& packer, const ToolOptions& opts, const BufferLayout& layout, const ObjMesh& mesh,
+		const std::vector<Section>& sections, const std::vector<size_t>& offsets, size_t const totalBytes, size_t const drawCount) {
+	VertexPacker::Failed failed = false;
+	bool const bigEndian = O2B_HAS_OPT(opts.opts, ToolOptions::OPTS_BIG_ENDIAN);
+	failed |= packer.add(O2B_CONTAINER_MAGIC,   VertexPacker::Storage::UINT32C);
+	failed |= packer.add(O2B_CONTAINER_VERSION, VertexPacker::Storage::UINT32C);
+	failed |= packer.add(opts.getAllOptions(),  VertexPacker::Storage::UINT32C);
+	failed |= packer.add(opts.getExtOptions(),  VertexPacker::Storage::UINT32C);
+	failed |= packer.add(opts.align,            VertexPacker::Storage::UINT32C);
+	failed |= packer.add(static_cast<unsigned>(sections.size()), VertexPacker::Storage::UINT32C);
+	failed |= add64(packer, totalBytes, bigEndian);
+	failed |= packer.add(static_cast<unsigned>(drawCount), VertexPacker::Storage::UINT32C);
+	failed |= packer.add(layout.getHeaderSize(),           VertexPacker::Storage::UINT32C);
+	failed |= mesh.scale.store(packer, VertexPacker::Storage::FLOAT32);
+	failed |= mesh.bias.store (packer, VertexPacker::Storage::FLOAT32);
+	failed |= layout.writeHeader(packer);
+	while (packer.size() & 7) {
+		failed |= packer.add(0, VertexPacker::Storage::UINT08C);
+	}
+	for (size_t n = 0; n < sections.size(); n++) {
+		failed |= packer.add(static_cast<unsigned>(sections[n].id), VertexPacker::Storage::UINT32C);
+		failed |= packer.add(sections[n].count, VertexPacker::Storage::UINT32C);
+		failed |= add64(packer, offsets[n], bigEndian);
+		failed |= add64(packer, sections[n].bytes, bigEndian);
+	}
+	return failed;
+}
+
+/**
+ * Helper to chain a file's content onto a hash (mapping rather than reading
+ * the file, so large sources aren't copied).
+ *
+ * \param[in] srcPath filename of the file
+ * \param[in,out] key hash to chain onto
+ * \return \c true if the file was read
+ */
+static bool hashFile(const char* const srcPath, uint64_t& key) {
+	MappedFile file;
+	if (srcPath && file.open(srcPath)) {
+		key = hash(file.data(), file.size(), key);
+		return true;
+	}
+	return false;
+}
+
+/**
+ * Helper to hash a source's content along with the other files it loads (a
+ * glTF file's external buffers), since the output depends on them as much as
+ * on the source itself. This is done once per conversion, with each cache key
+ * seeded from the result.
+ *
+ * \param[in] srcPath filename of the source file
+ * \param[out] key destination for the hash
+ * \return \c true if every file was read (otherwise the source can't be cached)
+ */
+static bool hashSource(const char* const srcPath, uint64_t& key) {
+	key = 0;
+	std::vector<std::string> paths;
+	if (!hashFile(srcPath, key) || !ObjMesh::dependencies(srcPath, paths)) {
+		return false;
+	}
+	for (std::vector<std::string>::const_iterator it = paths.begin(); it != paths.end(); ++it) {
+		if (!hashFile(it->c_str(), key)) {
+			return false;
+		}
+	}
+	return true;
+}
+
+/**
+ * Helper to create the path of a cached result. The key is the hash of the
+ * source file's content (and any external buffers), seeded with the shortcode
+ * and tool version (the output is a pure function of all three, plus any
+ * dictionary).
+ *
+ * \param[in] opts tool options (containing the cache directory)
+ * \param[in] srcKey hash of the source (see \c #hashSource())
+ * \param[in] dictKey hash of the dictionary (if \a opts has one)
+ * \param[out] dstPath destination for the cached file's path
+ * \return \c true if caching and \a dstPath was created
+ */
+static bool cachePath(const ToolOptions& opts, uint64_t const srcKey, uint64_t const dictKey, std::vector<char>& dstPath) {
+	if (opts.cache) {
+		uint64_t seed = (static_cast<uint64_t>(O2B_VERSION) << 32) | opts.getAllOptions();
+		if (uint32_t const ext = opts.getExtOptions()) {
+			// As do the extended options and their tuning
+			seed = hash(&ext, sizeof ext, seed);
+			if (opts.lods) {
+				float const tuning[] = {opts.lodRatio, opts.lodError};
+				seed = hash(tuning, sizeof tuning, seed);
+			}
+			if (opts.meshlets) {
+				float const tuning[] = {static_cast<float>(opts.meshletVerts), static_cast<float>(opts.meshletTris), opts.meshletCone};
+				seed = hash(tuning, sizeof tuning, seed);
+			}
+			if (opts.container) {
+				seed = hash(&opts.align, sizeof opts.align, seed);
+			}
+		}
+		if (opts.autoLayout) {
+			// The chosen types depend on the error budget (the requested types only choose the attributes)
+			float const budget[] = {opts.autoPosnError, opts.autoTexError, static_cast<float>(opts.autoTexSize), opts.autoNormError};
+			seed = hash(budget, sizeof budget, seed);
+		}
+		if (opts.dict && O2B_HAS_OPT(opts.opts, ToolOptions::OPTS_COMPRESS_ZSTD)) {
+			// A dictionary changes the compressed output so also forms part of the key
+			seed = hash(&dictKey, sizeof dictKey, seed);
+		}
+		uint64_t const key = hash(&srcKey, sizeof srcKey, seed);
+		dstPath.resize(strlen(opts.cache) + 22);
+		snprintf(dstPath.data(), dstPath.size(), "%s/%016" PRIX64 ".o2b", opts.cache, key);
+		return true;
+	}
+	return false;
+}
+
+/**
+ * Helper to choose the destination path, taking the argument after the source
+ * if it exists, otherwise a default based on the output format (unless only
+ * the additional \c -c \c code:path outputs are written).
+ *
+ * \param[in] opts tool options (the file format affects the default name)
+ * \param[in] argv arguments containing the source (and optional destination)
+ * \param[in] argc number of entries in \a argv
+ * \param[in] srcIdx index of the source in \a argv
+ * \return destination path (or \c null if there was no source or only additional outputs)
+ */
+static const char* dstPathFrom(const ToolOptions& opts, const char* const argv[], int const argc, int const srcIdx) {
 	if (srcIdx < argc) {
-		srcPath = argv[srcIdx];
 		if (srcIdx + 1 < argc) {
-			dstPath = argv[srcIdx + 1];
+			return argv[srcIdx + 1];
+		}
+		if (!opts.outputs.empty()) {
+			// Only the additional outputs are written
+			return nullptr;
+		}
+		if (O2B_HAS_OPT(opts.opts, ToolOptions::OPTS_ASCII_FILE)) {
+			return "out.inc";
+		}
+		return "out.bin";
+	}
+	return nullptr;
+}
+
+/**
+ * Helper to create the path of a cached processed mesh. The key is the hash
+ * of the source file's content (and any external buffers), seeded with the
+ * tool and \c .o2bmesh versions plus only the options affecting the loading
+ * and processing (those compared in \c #sharesMesh()), leaving the types and
+ * encoding free to change.
+ *
+ * \param[in] opts tool options (containing the mesh cache directory)
+ * \param[in] srcKey hash of the source (see \c #hashSource())
+ * \param[out] dstPath destination for the cached mesh's path
+ * \return \c true if caching meshes and \a dstPath was created
+ */
+static bool meshCachePath(const ToolOptions& opts, uint64_t const srcKey, std::vector<char>& dstPath) {
+	if (opts.meshCache) {
+		bool const tans = opts.tans != VertexPacker::Storage::EXCLUDE;
+		uint32_t const flags[] = {
+			tans,
+			tans && O2B_HAS_OPT(opts.opts, ToolOptions::OPTS_TANGENTS_FLIP_G),
+			opts.tex1 != VertexPacker::Storage::EXCLUDE,
+			opts.idxs.bytes(),
+			opts.lods,
+			opts.lodSloppy,
+			opts.meshlets,
+			opts.meshletVerts,
+			opts.meshletTris,
+			static_cast<uint32_t>(opts.topology),
+			static_cast<uint32_t>(opts.profile),
+			opts.vcacheSize,
+			opts.shadow,
+			opts.split && O2B_HAS_OPT(opts.opts, ToolOptions::OPTS_WRITE_METADATA),
+		};
+		float const tuning[] = {
+			opts.lodRatio,
+			opts.lodError,
+			opts.meshletCone,
+			opts.getOverdrawThreshold(),
+		};
+		uint64_t seed = (static_cast<uint64_t>(O2B_VERSION) << 32) | O2B_MESH_VERSION;
+		seed = hash(flags,  sizeof flags,  seed);
+		seed = hash(tuning, sizeof tuning, seed);
+		uint64_t const key = hash(&srcKey, sizeof srcKey, seed);
+		dstPath.resize(strlen(opts.meshCache) + 26);
+		snprintf(dstPath.data(), dstPath.size(), "%s/%016" PRIX64 ".o2bmesh", opts.meshCache, key);
+		return true;
+	}
+	return false;
+}
+
+/**
+ * Helper to measure the mesh after an optimisation step (if measuring).
+ *
+ * \param[in] opts tool options (for the simulated vertex cache size)
+ * \param[in] mesh mesh to measure
+ * \param[in] name name of the step
+ * \param[in] vertexSize bytes per vertex for the simulated vertex fetch
+ * \param[out] steps destination for the step (or \c null to skip measuring)
+ */
+static void measure(const ToolOptions& opts, const ObjMesh& mesh, const char* const name, unsigned const vertexSize, std::vector<Step>* const steps) {
+	if (steps) {
+		Step step;
+		step.name  = name;
+		step.stats = mesh.analyse(opts.vcacheSize, vertexSize);
+		steps->push_back(step);
+	}
+}
+
+/**
+ * Runs the optimisation steps of the chosen profile (see \c
+ * ToolOptions#Profile), optionally measuring the mesh before and after each.
+ *
+ * \param[in] opts tool options (profile, overdraw threshold, cache size and topology)
+ * \param[in,out] mesh mesh to optimise
+ * \param[out] steps optional destination for the metrics of the source then each step run (\c null to skip measuring)
+ * \param[in] vertexSize bytes per vertex for the simulated vertex fetch (when measuring)
+ */
+static void optimise(const ToolOptions& opts, ObjMesh& mesh, std::vector<Step>* const steps = nullptr, unsigned const vertexSize = 0) {
+	bool const strips = opts.topology != ToolOptions::TOPOLOGY_LIST || opts.profile == ToolOptions::PROFILE_STRIP;
+	measure(opts, mesh, "source", vertexSize, steps);
+	switch (opts.profile) {
+	case ToolOptions::PROFILE_NONE:
+		break;
+	case ToolOptions::PROFILE_FAST:
+		mesh.optimiseVertexCacheFifo(opts.vcacheSize);
+		measure(opts, mesh, "vcache", vertexSize, steps);
+		mesh.optimiseVertexFetch();
+		measure(opts, mesh, "vfetch", vertexSize, steps);
+		break;
+	default:
+		mesh.optimiseVertexCache(strips);
+		measure(opts, mesh, "vcache", vertexSize, steps);
+		mesh.optimiseOverdraw(opts.getOverdrawThreshold());
+		measure(opts, mesh, "overdraw", vertexSize, steps);
+		mesh.optimiseVertexFetch();
+		measure(opts, mesh, "vfetch", vertexSize, steps);
+	}
+}
+
+/**
+ * Helper to print a string as a JSON value (quoted, with any quotes,
+ * backslashes and control characters escaped).
+ *
+ * \param[in] file destination (e.g. \c stdout)
+ * \param[in] str string to print
+ */
+static void printJson(FILE* const file, const char* const str) {
+	fputc('"', file);
+	for (const char* next = str; next && *next; next++) {
+		unsigned char const c = static_cast<unsigned char>(*next);
+		if (c == '"' || c == '\\') {
+			fprintf(file, "\\%c", c);
+		} else if (c < 0x20) {
+			fprintf(file, "\\u%04X", c);
+		} else {
+			fputc(c, file);
+		}
+	}
+	fputc('"', file);
+}
+
+/**
+ * Writes the quantisation errors (see \c ErrorReport) as JSON, for example:
+ * \code
+ *	{"file": "cube.obj", "code": "8115507B", "vertices": 24, "attributes": [
+ *	  {"attribute": "posn", "type": "short", "units": "size", "mean": 1.1e-05, "p99": 1.4e-05, "max": 1.5e-05},
+ *	  ...
+ *	]}
+ * \endcode
+ *
+ * \param[in] dstPath filename of the report
+ * \param[in] srcPath filename of the source file
+ * \param[in] opts tool options (for the shortcode)
+ * \param[in] mesh measured mesh
+ * \param[in] report measured errors
+ * \return \c true if the report was written
+ */
+static bool writeErrors(const char* const dstPath, const char* const srcPath, const ToolOptions& opts, const ObjMesh& mesh, const ErrorReport& report) {
+	FILE* file = fopen(dstPath, "w");
+	if (!file) {
+		return false;
+	}
+	fprintf(file, "{\"file\": ");
+	printJson(file, srcPath);
+	if (uint32_t const ext = opts.getExtOptions()) {
+		fprintf(file, ", \"code\": \"%08X%08X\"", ext, opts.getAllOptions());
+	} else {
+		fprintf(file, ", \"code\": \"%08X\"", opts.getAllOptions());
+	}
+	fprintf(file, ", \"vertices\": %d, \"attributes\": [\n", static_cast<int>(mesh.verts.size()));
+	for (size_t n = 0; n < report.attrs.size(); n++) {
+		const ErrorReport::Attr& attr = report.attrs[n];
+		fprintf(file, "  {\"attribute\": \"%s\", \"type\": \"%s\", \"units\": \"%s\", \"mean\": %g, \"p99\": %g, \"max\": %g}%s\n",
+			attr.name, attr.type.toString(), attr.units, attr.mean, attr.p99, attr.max, (n + 1 < report.attrs.size()) ? "," : "");
+	}
+	fprintf(file, "]}\n");
+	return fclose(file) == 0;
+}
+
+/**
+ * Helper to track the best type for \c #chooseLayout(): the smallest stride
+ * meeting the error budget, with ties going to the smaller error (or, if no
+ * type meets the budget, simply the smallest error).
+ */
+struct Choice
+{
+	/**
+	 * Starts with no type chosen.
+	 *
+	 * \param[in] budget maximum error for a type to be considered
+	 */
+	Choice(float const budget)
+		: budget (budget)
+		, type   (VertexPacker::Storage::EXCLUDE)
+		, encoded(false)
+		, stride (UINT_MAX)
+		, error  (FLT_MAX)
+		, within (false) {}
+	/**
+	 * Tests a candidate type, keeping it if it's better than the current choice.
+	 *
+	 * \param[in] candType candidate storage type
+	 * \param[in] candEncoded \c true if the candidate is octahedral encoded (normals only)
+	 * \param[in] candStride vertex stride with the candidate type
+	 * \param[in] candError measured error with the candidate type
+	 */
+	void test(VertexPacker::Storage const candType, bool const candEncoded, unsigned const candStride, float const candError) {
+		bool better;
+		if (candError <= budget) {
+			better = !within || candStride < stride || (candStride == stride && candError < error);
+			within = true;
+		} else {
+			better = !within && candError < error;
+		}
+		if (better) {
+			type    = candType;
+			encoded = candEncoded;
+			stride  = candStride;
+			error   = candError;
+		}
+	}
+	float budget;               /**< Maximum error for a type to be considered. */
+	VertexPacker::Storage type; /**< Chosen type (or \c EXCLUDE if none were tested). */
+	bool encoded;               /**< \c true if the chosen normals are octahedral encoded. */
+	unsigned stride;            /**< Vertex stride with the chosen type. */
+	float error;                /**< Measured error with the chosen type. */
+	bool within;                /**< \c true if the chosen type meets the budget. */
+};
+
+/**
+ * Helper to calculate the vertex stride from a candidate set of options.
+ *
+ * \param[in] opts tool options with candidate types (before fixing up)
+ * \return the vertex stride (in bytes)
+ */
+static unsigned strideFor(const ToolOptions& opts) {
+	ToolOptions trial(opts);
+	O2B_CLEAR_OPT(trial.opts, ToolOptions::OPTS_TANGENTS_PACKED);
+	trial.fixUp();
+	return BufferLayout(trial).getStride();
+}
+
+/**
+ * Chooses the vertex types for \c ToolOptions#autoLayout from the loaded
+ * mesh. Each attribute in turn takes the type giving the smallest stride
+ * whilst meeting its error budget (with the normals, tangents and bitangents
+ * choosing together, with or without octahedral encoding). Only requested
+ * attributes are chosen, and normalised position types are only considered if
+ * scaling was requested (since drawing then needs the scale and bias).
+ *
+ * \note QTangents keep their requested type.
+ *
+ * \param[in] mesh loaded mesh to measure (before any normalising or encoding)
+ * \param[in,out] opts tool options to update with the chosen types
+ * \param[in] verbose \c true if the measured errors should be printed to \c stdout
+ */
+static void chooseLayout(const ObjMesh& mesh, ToolOptions& opts, bool const verbose) {
+	static VertexPacker::Storage::Type const posnTypes[] = {
+		VertexPacker::Storage::SINT08N,
+		VertexPacker::Storage::SINT10_2N,
+		VertexPacker::Storage::SINT16N,
+		VertexPacker::Storage::FLOAT16,
+		VertexPacker::Storage::FLOAT32,
+	};
+	static VertexPacker::Storage::Type const textTypes[] = {
+		VertexPacker::Storage::UINT08N,
+		VertexPacker::Storage::SINT08N,
+		VertexPacker::Storage::UINT16N,
+		VertexPacker::Storage::SINT16N,
+		VertexPacker::Storage::FLOAT16,
+		VertexPacker::Storage::FLOAT32,
+	};
+	static VertexPacker::Storage::Type const normTypes[] = {
+		VertexPacker::Storage::SINT08N,
+		VertexPacker::Storage::SINT10_2N,
+		VertexPacker::Storage::SINT16N,
+		VertexPacker::Storage::FLOAT16,
+		VertexPacker::Storage::FLOAT32,
+	};
+	bool const legacy  = O2B_HAS_OPT(opts.opts, ToolOptions::OPTS_SIGNED_LEGACY);
+	bool const scaled  = O2B_HAS_OPT(opts.opts, ToolOptions::OPTS_POSITIONS_SCALE);
+	bool const uniform = O2B_HAS_OPT(opts.opts, ToolOptions::OPTS_SCALE_UNIFORM);
+	bool const biased  = !O2B_HAS_OPT(opts.opts, ToolOptions::OPTS_SCALE_NO_BIAS);
+	if (verbose) {
+		printf("Auto layout errors:\n");
+	}
+	if (opts.posn) {
+		Choice posn(opts.autoPosnError);
+		for (size_t n = 0; n < sizeof posnTypes / sizeof posnTypes[0]; n++) {
+			ToolOptions trial(opts);
+			trial.posn = posnTypes[n];
+			if (scaled || !trial.posn.isNormalized()) {
+				posn.test(trial.posn, false, strideFor(trial), mesh.posnError(trial.posn, scaled, uniform, !biased, legacy));
+			}
+		}
+		opts.posn = posn.type;
+		if (verbose) {
+			printf("Positions:   %g (of the mesh size)\n", posn.error);
+		}
+	}
+	for (unsigned uv = 0; uv < 2; uv++) {
+		VertexPacker::Storage& text = (uv == 0) ? opts.text : opts.tex1;
+		if (text) {
+			Choice best(opts.autoTexError);
+			for (size_t n = 0; n < sizeof textTypes / sizeof textTypes[0]; n++) {
+				ToolOptions trial(opts);
+				((uv == 0) ? trial.text : trial.tex1) = textTypes[n];
+				best.test(textTypes[n], false, strideFor(trial), mesh.texError(textTypes[n], uv != 0, legacy) * opts.autoTexSize);
+			}
+			text = best.type;
+			if (verbose) {
+				printf("%s %g texels\n", (uv == 0) ? "Texture UVs:" : "Second UVs: ", best.error);
+			}
+		}
+	}
+	if (opts.norm && !opts.qtangent) {
+		bool const tans = opts.tans != VertexPacker::Storage::EXCLUDE;
+		bool const btan = tans && !O2B_HAS_OPT(opts.opts, ToolOptions::OPTS_BITANGENTS_SIGN);
+		Choice best(opts.autoNormError);
+		for (size_t n = 0; n < sizeof normTypes / sizeof normTypes[0]; n++) {
+			for (unsigned encoded = 0; encoded < 2; encoded++) {
+				ToolOptions trial(opts);
+				trial.norm = normTypes[n];
+				trial.tans = (tans) ? normTypes[n] : VertexPacker::Storage::EXCLUDE;
+				if (encoded) {
+					if (trial.norm.isPacked()) {
+						// Two encoded components gain nothing over shorts
+						continue;
+					}
+					O2B_SET_OPT(trial.opts, ToolOptions::OPTS_NORMALS_ENCODED);
+				} else {
+					O2B_CLEAR_OPT(trial.opts, ToolOptions::OPTS_NORMALS_ENCODED);
+				}
+				best.test(trial.norm, encoded != 0, strideFor(trial),
+					ObjVertex::normalError(mesh.verts, trial.norm, trial.tans, btan, encoded != 0, legacy));
+			}
+		}
+		opts.norm = best.type;
+		if (tans) {
+			opts.tans = best.type;
+		}
+		if (best.encoded) {
+			O2B_SET_OPT(opts.opts, ToolOptions::OPTS_NORMALS_ENCODED);
+		} else {
+			O2B_CLEAR_OPT(opts.opts, ToolOptions::OPTS_NORMALS_ENCODED);
+		}
+		if (verbose) {
+			printf("Normals:     %g degrees\n", best.error);
+		}
+	}
+	O2B_CLEAR_OPT(opts.opts, ToolOptions::OPTS_TANGENTS_PACKED);
+	opts.fixUp();
+	if (verbose) {
+		printf("\n");
+	}
+}
+
+/**
+ * A single destination of a conversion: the command-line's own, or one of its
+ * \c -c \c code:path outputs (see \c ToolOptions#outputs), plus the sizes
+ * once written (for the verbose report).
+ */
+struct Target {
+	ToolOptions opts;         /**< Options for this destination (with any automatic layout chosen). */
+	const char* dstPath;      /**< Filename of the destination. */
+	std::vector<char> cached; /**< Path of the cached result (empty if not caching). */
+	bool hit;                 /**< \c true if the result was copied from the cache. */
+	bool report;              /**< \c true if this destination writes any error report (only the first). */
+	bool written;             /**< \c true if the destination was written. */
+	unsigned headerBytes;     /**< Bytes of metadata. */
+	unsigned vertexBytes;     /**< Bytes of vertex data. */
+	unsigned indexBytes;      /**< Bytes of index data. */
+	unsigned extraBytes;      /**< Bytes of any extra sections (including their padding). */
+	size_t totalBytes;        /**< Total bytes packed. */
+};
+
+/**
+ * Tests whether two destinations can share the same loaded and processed mesh:
+ * they need the same vertices (since generated tangents and second UVs both
+ * affect which vertices are unique) and the same index processing.
+ *
+ * \param[in] lhs options of the first destination
+ * \param[in] rhs options of the second destination
+ * \return \c true if only the encoding and writing differ
+ */
+static bool sharesMesh(const ToolOptions& lhs, const ToolOptions& rhs) {
+	bool const lhsTans = lhs.tans != VertexPacker::Storage::EXCLUDE;
+	bool const rhsTans = rhs.tans != VertexPacker::Storage::EXCLUDE;
+	bool const lhsFlip = O2B_HAS_OPT(lhs.opts, ToolOptions::OPTS_TANGENTS_FLIP_G);
+	bool const rhsFlip = O2B_HAS_OPT(rhs.opts, ToolOptions::OPTS_TANGENTS_FLIP_G);
+	bool const lhsSplit = lhs.split && O2B_HAS_OPT(lhs.opts, ToolOptions::OPTS_WRITE_METADATA);
+	bool const rhsSplit = rhs.split && O2B_HAS_OPT(rhs.opts, ToolOptions::OPTS_WRITE_METADATA);
+	return lhsTans == rhsTans && (!lhsTans || lhsFlip == rhsFlip)
+		&& (lhs.tex1 != VertexPacker::Storage::EXCLUDE) == (rhs.tex1 != VertexPacker::Storage::EXCLUDE)
+		&& lhs.idxs       == rhs.idxs
+		&& lhs.lods       == rhs.lods
+		&& lhs.lodSloppy  == rhs.lodSloppy
+		&& lhs.meshlets   == rhs.meshlets
+		&& lhs.topology   == rhs.topology
+		&& lhs.profile    == rhs.profile
+		&& lhs.vcacheSize == rhs.vcacheSize
+		&& lhs.shadow     == rhs.shadow
+		&& lhsSplit       == rhsSplit
+		&& lhs.getOverdrawThreshold() == rhs.getOverdrawThreshold();
+}
+
+/**
+ * Processes the loaded mesh's indices (LODs, optimisation, meshlets,
+ * splitting, shadow indices then strips), the work shared by every
+ * destination for which \c #sharesMesh() is \c true.
+ *
+ * \param[in] opts tool options
+ * \param[in,out] mesh mesh to process
+ * \return number of full detail triangles (counted before any strips)
+ */
+static size_t process(const ToolOptions& opts, ObjMesh& mesh) {
+	// Optional LOD chain (appended to the indices, so before optimising)
+	if (opts.lods) {
+		mesh.simplify(opts.lods, opts.lodRatio, opts.lodError, opts.lodSloppy);
+	}
+	// Vertex cache, overdraw, and vertex fetch optimisations (per the profile)
+	optimise(opts, mesh);
+	// Meshlets from the final vertex order (and before any normalising)
+	if (opts.meshlets) {
+		if (opts.idxs) {
+			mesh.buildMeshlets(opts.meshletVerts, opts.meshletTris, opts.meshletCone);
 		} else {
-			if (O2B_HAS_OPT(opts.opts, ToolOptions::OPTS_ASCII_FILE)) {
-				dstPath = "out.inc";
+			fprintf(stderr, "Meshlets need indexed output (skipping)\n");
+		}
+	}
+	// The maximum value of the index type (e.g. 0xFFFF for shorts) is only kept free if it's the primitive restart
+	bool const restart = opts.topology == ToolOptions::TOPOLOGY_STRIP_RESTART;
+	unsigned const maxIndex = (opts.idxs.bytes() < 4) ? (1U << (opts.idxs.bytes() * 8)) - 1 : 0xFFFFFFFFU;
+	size_t const maxVerts = (restart) ? maxIndex : static_cast<size_t>(std::min<uint64_t>(uint64_t(maxIndex) + 1, SIZE_MAX));
+	if (opts.idxs) {
+		if (opts.split) {
+			if (O2B_HAS_OPT(opts.opts, ToolOptions::OPTS_WRITE_METADATA)) {
+				// Split after the meshlets (which are remapped) and before the strips (made per chunk)
+				mesh.split(maxVerts);
+			} else {
+				fprintf(stderr, "Splitting needs metadata (skipping)\n");
+			}
+		}
+		if (mesh.chunks.empty() && mesh.verts.size() > maxVerts) {
+			fprintf(stderr, "Too many vertices for the index type (see -i or --split)\n");
+		}
+		// Shadow indices from the final vertex order (optimised as the profile would the main indices)
+		if (opts.shadow) {
+			if (mesh.verts.size() > maxVerts) {
+				fprintf(stderr, "Shadow indices need an index type addressing every vertex (skipping)\n");
 			} else {
-				dstPath = "out.bin";
+				mesh.generateShadow();
+				switch (opts.profile) {
+				case ToolOptions::PROFILE_NONE:
+					break;
+				case ToolOptions::PROFILE_FAST:
+					mesh.optimiseShadow(opts.vcacheSize);
+					break;
+				default:
+					mesh.optimiseShadow();
+				}
 			}
 		}
+	} else if (opts.shadow) {
+		fprintf(stderr, "Shadow indices need indexed output (skipping)\n");
 	}
-	opts.dump();
-	// Decide how the options create the buffer layout
-	BufferLayout const layout(opts);
-	// Now we start
-	unsigned const startMs = millis();
-	bool const tans = opts.tans != VertexPacker::Storage::EXCLUDE;
-	bool const flip = O2B_HAS_OPT(opts.opts, ToolOptions::OPTS_TANGENTS_FLIP_G);
-	if (!mesh.load(srcPath, tans, flip)) {
-		fprintf(stderr, "Unable to read: %s\n", (srcPath) ? srcPath : "null");
-		return EXIT_FAILURE;
+	// Triangle strips (after the meshlets, which are built from the list)
+	size_t const numTris = ((mesh.lods.empty()) ? mesh.index.size() : mesh.lods[0].count) / 3;
+	if (opts.topology != ToolOptions::TOPOLOGY_LIST) {
+		mesh.stripify((restart) ? maxIndex : 0);
 	}
-	// Vertex cache, overdraw, and vertex fetch optimisations (see function notes)
-	mesh.optimise();
+	return numTris;
+}
+
+/**
+ * Normalises, encodes, packs then writes the processed mesh for a single
+ * destination (modifying the mesh's vertices in the process).
+ *
+ * \param[in,out] target destination (with its sizes filled once packed)
+ * \param[in,out] mesh processed mesh
+ * \param[in] srcPath filename of the source file (for the error report)
+ * \return \c true if the destination was packed and written
+ */
+static bool emit(Target& target, ObjMesh& mesh, const char* const srcPath) {
+	const ToolOptions& opts = target.opts;
+	const char* const dstPath = target.dstPath;
+	BufferLayout const layout(opts);
 	// Perform an in-place scale/bias if requested
 	if (O2B_HAS_OPT(opts.opts, ToolOptions::OPTS_POSITIONS_SCALE)) {
 		mesh.normalise(O2B_HAS_OPT(opts.opts, ToolOptions::OPTS_SCALE_UNIFORM),
 					   O2B_HAS_OPT(opts.opts, ToolOptions::OPTS_SCALE_NO_BIAS));
 	}
-	// In-place normals/tangents/bitangents encode (into the X/Y components)
-	if (O2B_HAS_OPT(opts.opts, ToolOptions::OPTS_NORMALS_ENCODED)) {
+	// Quantisation errors against the source (after normalising, so before any encoding)
+	if (target.report && opts.errors) {
+		ErrorReport report;
+		report.measure(opts, mesh);
+		if (!writeErrors(opts.errors, srcPath, opts, mesh, report)) {
+			fprintf(stderr, "Unable to write: %s\n", opts.errors);
+		}
+	}
+	// In-place normals/tangents/bitangents encode (into the X/Y components, or as a QTangent)
+	if (opts.qtangent) {
+		ObjVertex::encodeQTangents(mesh.verts, opts.tans);
+	} else if (O2B_HAS_OPT(opts.opts, ToolOptions::OPTS_NORMALS_ENCODED)) {
 		ObjVertex::encodeNormals(mesh.verts, opts.norm, opts.tans,
 			!O2B_HAS_OPT(opts.opts, ToolOptions::OPTS_BITANGENTS_SIGN));
 	}
-	printf("\n");
-	printf("Vertices:  %d\n", static_cast<int>(mesh.verts.size()));
-	printf("Indices:   %d\n", static_cast<int>(mesh.index.size()));
-	printf("Triangles: %d\n", static_cast<int>(mesh.index.size() / 3));
-	// Maximum buffer size: metadata + vert posn, norm, UVs, tans, bitans + indices
-	size_t const maxBufBytes = 54 + 20 //<-- max metadata size
-			+ std::max(mesh.verts.size(), mesh.index.size())
-				* sizeof(float) * (3 + 3 + 2 + 3 + 3)
-			+ mesh.index.size() * sizeof(uint32_t);
-	std::vector<uint8_t> backing(maxBufBytes);
 	// Tool options to packer options
 	unsigned packOpts = VertexPacker::OPTS_DEFAULT;
 	if (O2B_HAS_OPT(opts.opts, ToolOptions::OPTS_BIG_ENDIAN)) {
@@ -100,83 +1073,572 @@ int main(int argc, const char* argv[]) {
 	if (O2B_HAS_OPT(opts.opts, ToolOptions::OPTS_SIGNED_LEGACY)) {
 		packOpts |= VertexPacker::OPTS_SIGNED_LEGACY;
 	}
+	// Extra sections following the indices (or, in the container, every section)
+	bool const metadata  = O2B_HAS_OPT(opts.opts, ToolOptions::OPTS_WRITE_METADATA);
+	bool const extended  = O2B_HAS_OPT(opts.getAllOptions(), ToolOptions::OPTS_EXTENDED);
+	bool const container = metadata && opts.container;
+	std::vector<Section> sections;
+	gatherSections(opts, layout, mesh, sections);
+	// Exact sizes: metadata, indexed or unindexed vertices, indices, then any sections
+	unsigned const numVerts    = static_cast<unsigned>((opts.idxs) ? mesh.verts.size() : mesh.index.size());
+	unsigned const vertexBytes = numVerts * layout.getStride();
+	unsigned const indexBytes  = static_cast<unsigned>((opts.idxs) ? mesh.index.size() * opts.idxs.bytes() : 0);
+	unsigned headerBytes  = 0;
+	unsigned sectionPad   = 0;
+	unsigned sectionBytes = 0;
+	size_t totalBytes;
+	std::vector<size_t> offsets;
+	if (container) {
+		// The table's 64-bit values are 8-byte aligned, then each section starts on the alignment boundary
+		headerBytes = ((O2B_CONTAINER_BYTES + layout.getHeaderSize() + 7) & ~7U)
+			+ static_cast<unsigned>(sections.size()) * O2B_CONTAINER_SECTION_BYTES;
+		totalBytes  = headerBytes;
+		for (std::vector<Section>::const_iterator it = sections.begin(); it != sections.end(); ++it) {
+			offsets.push_back((totalBytes + opts.align - 1) & ~static_cast<size_t>(opts.align - 1));
+			totalBytes = offsets.back() + it->bytes;
+		}
+		// Everything that isn't the vertices or indices (including the padding)
+		sectionBytes = static_cast<unsigned>(totalBytes - headerBytes - vertexBytes - indexBytes);
+	} else {
+		if (metadata) {
+			headerBytes = O2B_METADATA_BYTES + layout.getHeaderSize();
+			if (extended) {
+				headerBytes += 4 + 4 + static_cast<unsigned>(sections.size()) * O2B_SECTION_BYTES;
+			}
+		}
+		if (!sections.empty()) {
+			// Sections start 4-byte aligned (they contain 32-bit values)
+			sectionPad = (4 - ((headerBytes + vertexBytes + indexBytes) & 3)) & 3;
+			for (std::vector<Section>::const_iterator it = sections.begin(); it != sections.end(); ++it) {
+				sectionBytes += it->bytes;
+			}
+		}
+		totalBytes = static_cast<size_t>(headerBytes) + vertexBytes + indexBytes + sectionPad + sectionBytes;
+	}
+	// The full detail is what's drawn by default (the LODs follow it)
+	size_t const drawCount = (mesh.lods.empty()) ? mesh.index.size() : mesh.lods[0].count;
+	/*
+	 * The backing is either the entire buffer or, when streaming, a fixed-size
+	 * chunk that's written each time it fills (and it needs no zeroing, since
+	 * every byte is written by the packer).
+	 */
+	bool const ascii = O2B_HAS_OPT(opts.opts, ToolOptions::OPTS_ASCII_FILE);
+	bool const zstd  = O2B_HAS_OPT(opts.opts, ToolOptions::OPTS_COMPRESS_ZSTD);
+	size_t const backingBytes = (opts.stream) ? std::min<size_t>(totalBytes, O2B_STREAM_CHUNK) : totalBytes;
+	std::unique_ptr<uint8_t, void (*)(void*)> backing(static_cast<uint8_t*>(Arena::allocate(std::max<size_t>(backingBytes, 1))), Arena::release);
+	if (!backing) {
+		fprintf(stderr, "Unable to allocate: %d bytes\n", static_cast<int>(backingBytes));
+		return false;
+	}
+	StreamWriter stream;
+	if (opts.stream && !stream.open(dstPath, totalBytes, ascii, zstd)) {
+		fprintf(stderr, "Unable to write: %s\n", (dstPath) ? dstPath : "null");
+		return false;
+	}
 	// Pack the vertex data
 	VertexPacker::Failed failed = false;
-	VertexPacker packer(backing.data(), maxBufBytes, packOpts);
-	unsigned preOffBytes = 0;
-	unsigned offsetBytes = 0;
-	if (O2B_HAS_OPT(opts.opts, ToolOptions::OPTS_WRITE_METADATA)) {
+	VertexPacker packer(backing.get(), backingBytes, packOpts);
+	if (container) {
+		failed |= writeContainer(packer, opts, layout, mesh, sections, offsets, totalBytes, drawCount);
+		failed |= packer.size() != headerBytes;
+	} else if (metadata) {
 		// Endianness test/file magic
 		packer.add(0xBDA7, VertexPacker::Storage::UINT16C);
 		// Serialised tool 'shortcode' for exporting
 		packer.add(opts.getAllOptions(), VertexPacker::Storage::UINT32C);
-		// Metadata offsets placeholder (retroactively written after the content)
-		preOffBytes = static_cast<unsigned>(packer.size());
-		for (int n = 0; n < 5; n++) {
-			failed |= packer.add(0, VertexPacker::Storage::UINT32C);
-		}
-		offsetBytes = static_cast<unsigned>(packer.size()) - preOffBytes;
+		// Metadata offsets (known upfront from the exact sizes)
+		failed |= packer.add(headerBytes,  VertexPacker::Storage::UINT32C);
+		failed |= packer.add(vertexBytes,  VertexPacker::Storage::UINT32C);
+		failed |= packer.add(headerBytes + vertexBytes, VertexPacker::Storage::UINT32C);
+		failed |= packer.add(indexBytes,   VertexPacker::Storage::UINT32C);
+		failed |= packer.add((opts.idxs) ? static_cast<int>(drawCount) : 0, VertexPacker::Storage::UINT32C);
 		// Mesh scale/bias (more than likely not used but it's only 24 bytes)
 		failed |= mesh.scale.store(packer, VertexPacker::Storage::FLOAT32);
 		failed |= mesh.bias.store (packer, VertexPacker::Storage::FLOAT32);
 		// Buffer layout (attributes, sizes, offset, etc.)
 		failed |= layout.writeHeader(packer);
+		if (extended) {
+			// Extended options then the table of sections following the indices
+			failed |= packer.add(opts.getExtOptions(), VertexPacker::Storage::UINT32C);
+			failed |= packer.add(static_cast<int>(sections.size()), VertexPacker::Storage::UINT32C);
+			unsigned offset = headerBytes + vertexBytes + indexBytes + sectionPad;
+			for (std::vector<Section>::const_iterator it = sections.begin(); it != sections.end(); ++it) {
+				failed |= packer.add(it->id,    VertexPacker::Storage::UINT32C);
+				failed |= packer.add(offset,    VertexPacker::Storage::UINT32C);
+				failed |= packer.add(it->bytes, VertexPacker::Storage::UINT32C);
+				failed |= packer.add(it->count, VertexPacker::Storage::UINT32C);
+				offset += it->bytes;
+			}
+		}
+		failed |= packer.size() != headerBytes;
 	}
-	unsigned headerBytes = static_cast<unsigned>(packer.size());
-	unsigned vertexBytes = 0;
-	unsigned indexBytes  = 0;
-	if (opts.idxs) {
-		// Indexed vertices
-		for (ObjVertex::Container::const_iterator it = mesh.verts.begin(); it != mesh.verts.end(); ++it) {
-			failed |= layout.writeVertex(packer, *it, headerBytes);
+	unsigned const numStreams = layout.getStreams();
+	if (container) {
+		// Each section is preceded by the padding to its offset
+		size_t prevEnd = headerBytes;
+		unsigned nextStream = 0;
+		for (size_t n = 0; n < sections.size(); n++) {
+			for (size_t pad = prevEnd; pad < offsets[n]; pad++) {
+				failed |= flush(stream, packer, backing.get(), 1);
+				failed |= packer.add(0, VertexPacker::Storage::UINT08C);
+			}
+			if (sections[n].id == SECTION_VERTICES) {
+				if (opts.stream) {
+					// As below, streamed vertices start at the beginning of a chunk
+					failed |= !stream.write(backing.get(), packer.size());
+					packer.rewind();
+				}
+				failed |= writeVertices(stream, packer, backing.get(), layout, mesh, opts.idxs, nextStream++, packer.size(), packOpts);
+			} else {
+				failed |= writeSection(stream, packer, backing.get(), opts, mesh, sections[n]);
+			}
+			prevEnd = offsets[n] + sections[n].bytes;
+		}
+	} else {
+		if (opts.stream) {
+			// Streamed vertices start at the beginning of a chunk (to keep the alignment)
+			failed |= !stream.write(backing.get(), packer.size());
+			packer.rewind();
+		}
+		// Vertices are aligned from where they start (not the start of the buffer)
+		size_t const base = packer.size();
+		// Each vertex stream is written in its entirety before the next
+		for (unsigned s = 0; s < numStreams; s++) {
+			failed |= writeVertices(stream, packer, backing.get(), layout, mesh, opts.idxs, s, base, packOpts);
 		}
-		vertexBytes = static_cast<unsigned>(packer.size()) - headerBytes;
 		// Add the indices
-		for (std::vector<unsigned>::const_iterator it = mesh.index.begin(); it != mesh.index.end(); ++it) {
-			failed |= packer.add(static_cast<int>(*it), opts.idxs);
+		if (opts.idxs) {
+			Section const indices = {SECTION_INDICES, indexBytes, static_cast<unsigned>(mesh.index.size())};
+			failed |= writeSection(stream, packer, backing.get(), opts, mesh, indices);
 		}
-		indexBytes  = static_cast<unsigned>(packer.size()) - (headerBytes + vertexBytes);
-	} else {
-		// Manually write unindexed vertices from the indices
-		for (std::vector<unsigned>::const_iterator it = mesh.index.begin(); it != mesh.index.end(); ++it) {
-			unsigned idx = static_cast<unsigned>(*it);
-			if (idx < mesh.verts.size()) {
-				failed |= layout.writeVertex(packer, mesh.verts[idx], headerBytes);
+		if (!sections.empty()) {
+			for (unsigned n = 0; n < sectionPad; n++) {
+				failed |= flush(stream, packer, backing.get(), 1);
+				failed |= packer.add(0, VertexPacker::Storage::UINT08C);
+			}
+			for (std::vector<Section>::const_iterator it = sections.begin(); it != sections.end(); ++it) {
+				failed |= writeSection(stream, packer, backing.get(), opts, mesh, *it);
 			}
 		}
-		vertexBytes = static_cast<unsigned>(packer.size()) - headerBytes;
 	}
-	if (O2B_HAS_OPT(opts.opts, ToolOptions::OPTS_WRITE_METADATA)) {
-		// Overwrite in the space for the offsets we reserved earlier
-		VertexPacker header(backing.data() + preOffBytes, offsetBytes, packOpts);
-		failed |= header.add(headerBytes,  VertexPacker::Storage::UINT32C);
-		failed |= header.add(vertexBytes,  VertexPacker::Storage::UINT32C);
-		failed |= header.add(headerBytes + vertexBytes, VertexPacker::Storage::UINT32C);
-		failed |= header.add(indexBytes,   VertexPacker::Storage::UINT32C);
-		failed |= header.add((opts.idxs) ? static_cast<int>(mesh.index.size()) : 0, VertexPacker::Storage::UINT32C);
+	if (failed) {
+		fprintf(stderr, "Buffer packing failed (bytes used: %d)\n", static_cast<int>(totalBytes));
+	}
+	target.headerBytes = headerBytes;
+	target.vertexBytes = vertexBytes;
+	target.indexBytes  = indexBytes;
+	target.extraBytes  = (sectionBytes) ? sectionPad + sectionBytes : 0;
+	target.totalBytes  = totalBytes;
+	// Write the result (or the remainder of the stream)
+	bool written;
+	if (opts.stream) {
+		written = stream.write(backing.get(), packer.size()) && stream.close();
+	} else {
+		written = write(dstPath, backing.get(), packer.size(), ascii, zstd);
+	}
+	if (!written) {
+		fprintf(stderr, "Unable to write: %s\n", (dstPath) ? dstPath : "null");
+		return false;
 	}
 	if (failed) {
-		printf("Buffer packing failed (bytes used: %d)\n", vertexBytes + indexBytes);
+		// Written for inspection but, being incomplete, neither cached nor successful
+		return false;
+	}
+	if (!target.cached.empty() && !copy(dstPath, target.cached.data())) {
+		fprintf(stderr, "Unable to cache: %s\n", target.cached.data());
+	}
+	target.written = true;
+	return true;
+}
+
+/**
+ * Thread entry for \c #emit(), working on its own copy of the shared mesh
+ * (allocated from its own arena, since arenas are per thread).
+ *
+ * \param[in,out] target destination
+ * \param[in] mesh shared processed mesh (only read)
+ * \param[in] srcPath filename of the source file
+ */
+static void emitCopy(Target* const target, const ObjMesh* const mesh, const char* const srcPath) {
+	Arena arena;
+	Arena::Scope scope(arena);
+	ObjMesh copy(*mesh);
+	emit(*target, copy, srcPath);
+}
+
+/**
+ * Prints a written destination's mesh statistics, sizes and GL layout.
+ *
+ * \param[in] target written destination
+ * \param[in] mesh processed mesh
+ * \param[in] numTris number of full detail triangles
+ * \param[in] dumpOpts \c true if the options should be printed first
+ */
+static void printTarget(const Target& target, const ObjMesh& mesh, size_t const numTris, bool const dumpOpts) {
+	if (dumpOpts) {
+		target.opts.dump();
 	}
-	// Dump the buffer sizes and GL layout calls
 	printf("\n");
-	printf("Header bytes: %d\n", headerBytes);
-	printf("Vertex bytes: %d\n", vertexBytes);
-	printf("Index bytes:  %d\n", indexBytes);
-	printf("Total bytes:  %d\n", headerBytes + vertexBytes + indexBytes);
+	printf("Vertices:  %d\n", static_cast<int>(mesh.verts.size()));
+	printf("Indices:   %d\n", static_cast<int>(mesh.index.size()));
+	printf("Triangles: %d\n", static_cast<int>(numTris));
+	for (size_t n = 0; n < mesh.lods.size(); n++) {
+		printf("LOD %d:     %d indices (error %g)\n", static_cast<int>(n),
+			static_cast<int>(mesh.lods[n].count), mesh.lods[n].error);
+	}
+	if (!mesh.meshlets.empty()) {
+		printf("Meshlets:  %d\n", static_cast<int>(mesh.meshlets.size()));
+	}
+	if (!mesh.chunks.empty()) {
+		printf("Chunks:    %d\n", static_cast<int>(mesh.chunks.size()));
+	}
+	if (!mesh.shadow.empty()) {
+		printf("Shadow:    %d indices\n", static_cast<int>(mesh.shadow.size()));
+	}
+	// Dump the buffer sizes and GL layout calls
 	printf("\n");
-	layout.dump();
-	// Write the result
-	bool written = write(dstPath, backing.data(), packer.size(),
-		O2B_HAS_OPT(opts.opts, ToolOptions::OPTS_ASCII_FILE),
-		O2B_HAS_OPT(opts.opts, ToolOptions::OPTS_COMPRESS_ZSTD));
-	if (!written) {
-		fprintf(stderr, "Unable to write: %s\n", (dstPath) ? dstPath : "null");
-		return EXIT_FAILURE;
+	printf("Header bytes: %d\n", target.headerBytes);
+	printf("Vertex bytes: %d\n", target.vertexBytes);
+	printf("Index bytes:  %d\n", target.indexBytes);
+	if (target.extraBytes) {
+		printf("Extra bytes:  %d\n", target.extraBytes);
 	}
+	printf("Total bytes:  %d\n", static_cast<int>(target.totalBytes));
 	printf("\n");
-	printf("Source file: %s\n", ToolOptions::filename(srcPath));
-	printf("Destination: %s\n", ToolOptions::filename(dstPath));
-	printf("Total time:  %dms\n", millis() - startMs);
+	BufferLayout(target.opts).dump();
+}
+
+/**
+ * Load, convert and write a single file, to one or more destinations. The
+ * source is loaded and processed once for all destinations sharing the mesh
+ * (see \c #sharesMesh()), with each destination then encoded and written
+ * concurrently.
+ *
+ * \param[in] request tool options (including any additional outputs)
+ * \param[in] srcPath filename of the source \c .obj, FBX, glTF or PLY file
+ * \param[in] dstPath filename of the destination (or \c null if there are only additional outputs)
+ * \param[in] verbose \c true if the options, layout and timings should be printed to \c stdout
+ * \return \c true if the conversion was successful (for every destination)
+ */
+static bool convert(const ToolOptions& request, const char* const srcPath, const char* const dstPath, bool const verbose) {
+	// The request's own destination then each additional output
+	std::vector<Target> targets;
+	Target target = {};
+	target.opts    = request;
+	target.dstPath = dstPath;
+	target.report  = true;
+	if (dstPath || request.outputs.empty()) {
+		targets.push_back(target);
+	}
+	for (std::vector<ToolOptions::Output>::const_iterator it = request.outputs.begin(); it != request.outputs.end(); ++it) {
+		target.opts.setShortcode(it->code);
+		target.dstPath = it->dstPath;
+		target.report  = targets.empty();
+		targets.push_back(target);
+	}
+	bool const single = targets.size() == 1;
+	if (verbose && single && !request.autoLayout) {
+		request.dump();
+	}
+	// Now we start
+	unsigned const startMs = millis();
+	// The source (and any dictionary) is hashed once for every cache key
+	uint64_t srcKey  = 0;
+	uint64_t dictKey = 0;
+	bool const keyed = (request.cache || request.meshCache) && hashSource(srcPath, srcKey);
+	if (keyed && request.cache && request.dict) {
+		hashFile(request.dict, dictKey);
+	}
+	// A cache hit skips all the processing (a miss is stored after writing)
+	for (std::vector<Target>::iterator it = targets.begin(); it != targets.end(); ++it) {
+		if (keyed && !(it->report && it->opts.errors) && cachePath(it->opts, srcKey, dictKey, it->cached)) {
+			if (exists(it->cached.data()) && copy(it->cached.data(), it->dstPath)) {
+				it->hit     = true;
+				it->written = true;
+				if (verbose) {
+					printf("\n");
+					printf("Cached file: %s\n", ToolOptions::filename(it->cached.data()));
+					printf("Destination: %s\n", ToolOptions::filename(it->dstPath));
+					if (single) {
+						printf("Total time:  %dms\n", millis() - startMs);
+					}
+				}
+			}
+		}
+	}
+	/*
+	 * Then each group of destinations sharing the mesh is loaded and processed
+	 * once, with the encoding and writing of each destination in its own
+	 * thread (on a copy of the mesh).
+	 */
+	std::vector<bool> done(targets.size());
+	unsigned printed = 0;
+	for (size_t first = 0; first < targets.size(); first++) {
+		if (targets[first].hit || done[first]) {
+			continue;
+		}
+		std::vector<Target*> group;
+		for (size_t n = first; n < targets.size(); n++) {
+			if (!targets[n].hit && !done[n] && sharesMesh(targets[first].opts, targets[n].opts)) {
+				group.push_back(&targets[n]);
+				done[n] = true;
+			}
+		}
+		const ToolOptions& lead = targets[first].opts;
+		bool const tans = lead.tans != VertexPacker::Storage::EXCLUDE;
+		bool const flip = O2B_HAS_OPT(lead.opts, ToolOptions::OPTS_TANGENTS_FLIP_G);
+		ObjMesh mesh;
+		size_t numTris = 0;
+		// A processed mesh cache hit skips the loading and processing (a miss is stored before encoding)
+		std::vector<char> meshPath;
+		bool const meshHit = keyed && meshCachePath(lead, srcKey, meshPath) && readMesh(meshPath.data(), mesh, numTris);
+		if (!meshHit && !mesh.load(srcPath, tans, flip, lead.tex1 != VertexPacker::Storage::EXCLUDE)) {
+			fprintf(stderr, "Unable to read: %s\n", (srcPath) ? srcPath : "null");
+			return false;
+		}
+		if (verbose && meshHit) {
+			printf("Cached mesh: %s\n", ToolOptions::filename(meshPath.data()));
+		}
+		// The types are either as requested or chosen from the loaded mesh
+		for (std::vector<Target*>::iterator it = group.begin(); it != group.end(); ++it) {
+			if ((*it)->opts.autoLayout) {
+				chooseLayout(mesh, (*it)->opts, verbose && single);
+			}
+		}
+		if (!meshHit) {
+			numTris = process(lead, mesh);
+			if (!meshPath.empty() && !writeMesh(meshPath.data(), mesh, numTris)) {
+				fprintf(stderr, "Unable to cache: %s\n", meshPath.data());
+			}
+		}
+		if (group.size() == 1) {
+			emit(*group[0], mesh, srcPath);
+		} else {
+			std::vector<std::thread> workers;
+			for (size_t n = 1; n < group.size(); n++) {
+			#if O2B_CONCURRENT_OUTPUTS
+				workers.emplace_back(emitCopy, group[n], &mesh, srcPath);
+			#else
+				emitCopy(group[n], &mesh, srcPath);
+			#endif
+			}
+			emitCopy(group[0], &mesh, srcPath);
+			for (std::vector<std::thread>::iterator it = workers.begin(); it != workers.end(); ++it) {
+				it->join();
+			}
+		}
+		if (verbose) {
+			for (std::vector<Target*>::const_iterator it = group.begin(); it != group.end(); ++it) {
+				if ((*it)->written) {
+					if (!single && printed++) {
+						printf("\n");
+					}
+					printTarget(**it, mesh, numTris, !single || (*it)->opts.autoLayout);
+					if (!single) {
+						printf("\n");
+						printf("Destination: %s\n", ToolOptions::filename((*it)->dstPath));
+					}
+				}
+			}
+		}
+	}
+	bool success = true;
+	for (std::vector<Target>::const_iterator it = targets.begin(); it != targets.end(); ++it) {
+		success &= it->written;
+	}
+	if (verbose && success && !(single && targets[0].hit)) {
+		printf("\n");
+		printf("Source file: %s\n", ToolOptions::filename(srcPath));
+		if (single) {
+			printf("Destination: %s\n", ToolOptions::filename(dstPath));
+		}
+		printf("Total time:  %dms\n", millis() - startMs);
+	}
+	return success;
+}
+
+/**
+ * Analyses each source file, reporting the mesh quality metrics (see \c
+ * ObjMesh#Stats) before and after each optimisation step of the chosen
+ * profile (see \c ToolOptions#Profile) as a JSON array on \c stdout. For
+ * example:
+ * \code
+ *	[
+ *	  {"file": "cube.obj", "vertices": 24, "triangles": 12, "profile": "default", "cacheSize": 16, "vertexSize": 32, "steps": [
+ *	    {"step": "source", "acmr": 1.5, ...},
+ *	    {"step": "vcache", ...},
+ *	    {"step": "overdraw", ...},
+ *	    {"step": "vfetch", ...}
+ *	  ]}
+ *	]
+ * \endcode
+ *
+ * \param[in] opts tool options (tangent generation, cache and fetch sizes, etc.)
+ * \param[in] srcPaths filenames of the source files
+ * \param[in] count number of entries in \a srcPaths
+ * \return \c EXIT_SUCCESS if every file could be analysed
+ */
+static int analyze(const ToolOptions& opts, const char* const* const srcPaths, size_t const count) {
+	BufferLayout const layout(opts);
+	unsigned const vertexSize = (opts.vfetchSize) ? opts.vfetchSize : layout.getStride();
+	bool const tans   = opts.tans != VertexPacker::Storage::EXCLUDE;
+	bool const flip   = O2B_HAS_OPT(opts.opts, ToolOptions::OPTS_TANGENTS_FLIP_G);
+	bool analysed = true;
+	bool first    = true;
+	printf("[\n");
+	Arena arena;
+	Arena::Scope scope(arena);
+	for (size_t n = 0; n < count; n++) {
+		// Each file reuses the arena (the previous mesh having been freed)
+		arena.reset();
+		ObjMesh mesh;
+		if (!mesh.load(srcPaths[n], tans, flip, opts.tex1 != VertexPacker::Storage::EXCLUDE)) {
+			fprintf(stderr, "Unable to read: %s\n", (srcPaths[n]) ? srcPaths[n] : "null");
+			analysed = false;
+			continue;
+		}
+		// Measure before then after each step of the profile
+		std::vector<Step> steps;
+		optimise(opts, mesh, &steps, vertexSize);
+		if (!first) {
+			printf(",\n");
+		}
+		first = false;
+		printf("  {\"file\": ");
+		printJson(stdout, srcPaths[n]);
+		printf(", \"vertices\": %d, \"triangles\": %d, \"profile\": \"%s\", \"cacheSize\": %d, \"vertexSize\": %d, \"steps\": [\n",
+			static_cast<int>(mesh.verts.size()), static_cast<int>(mesh.index.size() / 3), ToolOptions::toString(opts.profile), opts.vcacheSize, vertexSize);
+		for (size_t step = 0; step < steps.size(); step++) {
+			const ObjMesh::Stats& stats = steps[step].stats;
+			printf("    {\"step\": \"%s\", \"acmr\": %.4f, \"atvr\": %.4f, \"overdraw\": %.4f, \"overfetch\": %.4f}%s\n",
+				steps[step].name, stats.acmr, stats.atvr, stats.overdraw, stats.overfetch, (step + 1 < steps.size()) ? "," : "");
+		}
+		printf("  ]}");
+	}
+	printf("%s]\n", (first) ? "" : "\n");
+	return (analysed) ? EXIT_SUCCESS : EXIT_FAILURE;
+}
+
+/**
+ * Helper to read an entire line (of any length) from a file.
+ *
+ * \param[in] file source file (e.g. \c stdin)
+ * \param[out] line destination for the line (without the newline, and null terminated)
+ * \return \c true if a line was read (\c false at the end of the file)
+ */
+static bool readLine(FILE* const file, std::vector<char>& line) {
+	line.clear();
+	int c;
+	while ((c = fgetc(file)) != EOF && c != '\n') {
+		line.push_back(static_cast<char>(c));
+	}
+	bool const read = c != EOF || !line.empty();
+	line.push_back('\0');
+	return read;
+}
+
+/**
+ * Runs as a persistent server, reading conversion requests from \c stdin and
+ * answering on \c stdout, avoiding the process launch for every conversion.
+ * Each request is a single line of arguments, exactly as they would be passed
+ * on the command-line (minus the program name), e.g.:
+ * \code
+ *	-c 8115547B in.obj out.bin
+ * \endcode
+ * Each answer is a single line, either \c OK followed by the destination and
+ * conversion time, or \c ERR followed by the source (or, for an invalid
+ * request, the reason it was rejected). An empty line or \c quit ends the
+ * server (as does closing \c stdin).
+ *
+ * \note Arguments are split on whitespace (so paths cannot contain spaces).
+ * Unlike the command-line, invalid options only reject the request. A request
+ * with its own \c --dict has that dictionary loaded in place of the server's
+ * (which is reloaded for the next request without one).
+ *
+ * \param[in] defaults server options (the cache directories and dictionary) applied to every request
+ * \return \c EXIT_SUCCESS when \c stdin is closed or the server is told to quit
+ */
+static int serve(const ToolOptions& defaults) {
+	Arena arena;
+	Arena::Scope scope(arena);
+	std::vector<char> line;
+	// Dictionary currently set (loaded by main(), so starting as the server's)
+	std::string loaded((defaults.dict) ? defaults.dict : "");
+	while (readLine(stdin, line)) {
+		std::vector<const char*> args;
+		for (char* arg = strtok(line.data(), " \t\r"); arg; arg = strtok(nullptr, " \t\r")) {
+			args.push_back(arg);
+		}
+		if (args.empty() || strcmp(args[0], "quit") == 0) {
+			break;
+		}
+		ToolOptions opts;
+		opts.cache     = defaults.cache;
+		opts.meshCache = defaults.meshCache;
+		opts.dict      = defaults.dict;
+		int const argc   = static_cast<int>(args.size());
+		int const srcIdx = opts.parseArgs(args.data(), argc, false);
+		if (!opts.error[0] && opts.mode != ToolOptions::MODE_CONVERT) {
+			snprintf(opts.error, sizeof opts.error, "Only conversions can be requested");
+		}
+		if (!opts.error[0] && loaded != ((opts.dict) ? opts.dict : "")) {
+			// Only a successfully set dictionary is recorded (a failure clears it)
+			bool const valid = setDictionary(opts.dict);
+			loaded = (valid && opts.dict) ? opts.dict : "";
+			if (!valid) {
+				snprintf(opts.error, sizeof opts.error, "Unable to read: %s", opts.dict);
+			}
+		}
+		if (opts.error[0]) {
+			printf("ERR %s\n", opts.error);
+			fflush(stdout);
+			continue;
+		}
+		const char* srcPath = (srcIdx < argc) ? args[srcIdx] : nullptr;
+		const char* dstPath = dstPathFrom(opts, args.data(), argc, srcIdx);
+		unsigned const startMs = millis();
+		// Each request reuses the arena (avoiding the allocator churn of a long-running server)
+		arena.reset();
+		if (srcPath && convert(opts, srcPath, dstPath, false)) {
+			printf("OK %s %dms\n", (dstPath) ? dstPath : srcPath, millis() - startMs);
+		} else {
+			printf("ERR %s\n", (srcPath) ? srcPath : "null");
+		}
+		fflush(stdout);
+	}
 	return EXIT_SUCCESS;
 }
+
+/**
+ * Load and convert (or start the server).
+ */
+int main(int argc, const char* argv[]) {
+	// Conversions allocate from an arena, including meshoptimizer's temporary buffers
+	meshopt_setAllocator(Arena::allocate, Arena::release);
+	// Gather files and tool options
+	ToolOptions opts;
+	int const srcIdx = opts.parseArgs(argv, argc);
+	if (opts.mode == ToolOptions::MODE_TRAIN_DICT) {
+		if (!train(opts.dict, argv + srcIdx, static_cast<size_t>(argc - srcIdx))) {
+			fprintf(stderr, "Unable to train: %s\n", (opts.dict) ? opts.dict : "null");
+			return EXIT_FAILURE;
+		}
+		printf("Dictionary: %s\n", ToolOptions::filename(opts.dict));
+		return EXIT_SUCCESS;
+	}
+	if (opts.dict && !setDictionary(opts.dict)) {
+		fprintf(stderr, "Unable to read: %s\n", opts.dict);
+		return EXIT_FAILURE;
+	}
+	if (opts.mode == ToolOptions::MODE_SERVE) {
+		return serve(opts);
+	}
+	if (opts.mode == ToolOptions::MODE_ANALYZE) {
+		return analyze(opts, argv + srcIdx, static_cast<size_t>(argc - srcIdx));
+	}
+	const char* srcPath = (srcIdx < argc) ? argv[srcIdx] : nullptr;
+	const char* dstPath = dstPathFrom(opts, argv, argc, srcIdx);
+	Arena arena;
+	Arena::Scope scope(arena);
+	return (convert(opts, srcPath, dstPath, true)) ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,209 @@
+/**
+ * \file meshcache.cpp
+ *
+ * \copyright 2022 Numfum GmbH
+ */
+#include "meshcache.h"
+
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+
+#include <vector>
+
+#include "arena.h"
+#include "fileutils.h"
+#include "objmesh.h"
+
+/**
+ * \def O2B_MESH_MAGIC
+ * Start of every \c .o2bmesh file (\c O2BM as bytes, so reading it with the
+ * other endianness also fails).
+ */
+#ifndef O2B_MESH_MAGIC
+#define O2B_MESH_MAGIC 0x4D42324FU
+#endif
+
+/**
+ * \def O2B_MESH_ALIGN
+ * Alignment of the header and each array (from the start of the file).
+ */
+#ifndef O2B_MESH_ALIGN
+#define O2B_MESH_ALIGN 16
+#endif
+
+namespace impl {
+/**
+ * Arrays following the header, in file order.
+ */
+enum ArrayId {
+	ARRAY_VERTS,
+	ARRAY_INDEX,
+	ARRAY_LODS,
+	ARRAY_CHUNKS,
+	ARRAY_SHADOW,
+	ARRAY_MESHLETS,
+	ARRAY_MESHLET_VERTS,
+	ARRAY_MESHLET_TRIS,
+	ARRAY_COUNT,
+};
+
+/**
+ * Fixed-size start of the file. The structure sizes stand in for a layout
+ * version, invalidating files from builds where they differ.
+ */
+struct Header {
+	uint32_t magic;        /**< Always \c O2B_MESH_MAGIC. */
+	uint32_t version;      /**< Always \c O2B_MESH_VERSION. */
+	uint32_t vertBytes;    /**< \c sizeof(ObjVertex). */
+	uint32_t lodBytes;     /**< \c sizeof(ObjMesh::Lod). */
+	uint32_t chunkBytes;   /**< \c sizeof(ObjMesh::Chunk). */
+	uint32_t meshletBytes; /**< \c sizeof(ObjMesh::Meshlet). */
+	uint64_t numTris;      /**< Number of full detail triangles. */
+	float scale[3];        /**< \c ObjMesh#scale. */
+	float bias [3];        /**< \c ObjMesh#bias. */
+	uint64_t counts[ARRAY_COUNT]; /**< Number of entries in each array. */
+};
+
+/**
+ * Helper to round a size up to the array alignment.
+ *
+ * \param[in] size size to round
+ * \return \a size rounded up to \c O2B_MESH_ALIGN
+ */
+inline size_t roundUp(size_t const size) {
+	return (size + O2B_MESH_ALIGN - 1) & ~static_cast<size_t>(O2B_MESH_ALIGN - 1);
+}
+
+/**
+ * Helper to copy an array to the file's content (leaving the zeroed padding).
+ *
+ * \param[in] src array to copy
+ * \param[in] data start of the file's content
+ * \param[in,out] offset offset into \a data (moved past the array and its padding)
+ */
+template<typename T, typename Alloc>
+void put(const std::vector<T, Alloc>& src, uint8_t* const data, size_t& offset) {
+	size_t const bytes = src.size() * sizeof(T);
+	if (bytes) {
+		memcpy(data + offset, src.data(), bytes);
+	}
+	offset += roundUp(bytes);
+}
+
+/**
+ * Helper to copy an array from the file's content.
+ *
+ * \param[in] data start of the file's content
+ * \param[in] size number of bytes in the content
+ * \param[in,out] offset offset into \a data (moved past the array and its padding)
+ * \param[in] count number of entries in the array
+ * \param[out] dst destination array
+ * \return \c true if the array (and its padding) was within the content
+ */
+template<typename T, typename Alloc>
+bool get(const uint8_t* const data, size_t const size, size_t& offset, uint64_t const count, std::vector<T, Alloc>& dst) {
+	if (offset > size || count > (size - offset) / sizeof(T)) {
+		return false;
+	}
+	size_t const bytes = static_cast<size_t>(count) * sizeof(T);
+	dst.resize(static_cast<size_t>(count));
+	if (bytes) {
+		memcpy(dst.data(), data + offset, bytes);
+	}
+	offset += roundUp(bytes);
+	return offset <= size;
+}
+}
+
+//*****************************************************************************/
+
+bool writeMesh(const char* const dstPath, const ObjMesh& mesh, size_t const numTris) {
+	if (!dstPath) {
+		return false;
+	}
+	impl::Header header;
+	memset(&header, 0, sizeof header);
+	header.magic        = O2B_MESH_MAGIC;
+	header.version      = O2B_MESH_VERSION;
+	header.vertBytes    = sizeof(ObjVertex);
+	header.lodBytes     = sizeof(ObjMesh::Lod);
+	header.chunkBytes   = sizeof(ObjMesh::Chunk);
+	header.meshletBytes = sizeof(ObjMesh::Meshlet);
+	header.numTris      = numTris;
+	header.scale[0] = mesh.scale.x;
+	header.scale[1] = mesh.scale.y;
+	header.scale[2] = mesh.scale.z;
+	header.bias [0] = mesh.bias.x;
+	header.bias [1] = mesh.bias.y;
+	header.bias [2] = mesh.bias.z;
+	header.counts[impl::ARRAY_VERTS]         = mesh.verts.size();
+	header.counts[impl::ARRAY_INDEX]         = mesh.index.size();
+	header.counts[impl::ARRAY_LODS]          = mesh.lods.size();
+	header.counts[impl::ARRAY_CHUNKS]        = mesh.chunks.size();
+	header.counts[impl::ARRAY_SHADOW]        = mesh.shadow.size();
+	header.counts[impl::ARRAY_MESHLETS]      = mesh.meshlets.size();
+	header.counts[impl::ARRAY_MESHLET_VERTS] = mesh.meshletVerts.size();
+	header.counts[impl::ARRAY_MESHLET_TRIS]  = mesh.meshletTris.size();
+	size_t const total = impl::roundUp(sizeof header)
+		+ impl::roundUp(mesh.verts.size()        * sizeof(ObjVertex))
+		+ impl::roundUp(mesh.index.size()        * sizeof(unsigned))
+		+ impl::roundUp(mesh.lods.size()         * sizeof(ObjMesh::Lod))
+		+ impl::roundUp(mesh.chunks.size()       * sizeof(ObjMesh::Chunk))
+		+ impl::roundUp(mesh.shadow.size()       * sizeof(unsigned))
+		+ impl::roundUp(mesh.meshlets.size()     * sizeof(ObjMesh::Meshlet))
+		+ impl::roundUp(mesh.meshletVerts.size() * sizeof(unsigned))
+		+ impl::roundUp(mesh.meshletTris.size()  * sizeof(uint8_t));
+	// Zeroed, so the padding is deterministic
+	std::vector<uint8_t, ArenaAllocator<uint8_t> > data(total);
+	memcpy(data.data(), &header, sizeof header);
+	size_t offset = impl::roundUp(sizeof header);
+	impl::put(mesh.verts,        data.data(), offset);
+	impl::put(mesh.index,        data.data(), offset);
+	impl::put(mesh.lods,         data.data(), offset);
+	impl::put(mesh.chunks,       data.data(), offset);
+	impl::put(mesh.shadow,       data.data(), offset);
+	impl::put(mesh.meshlets,     data.data(), offset);
+	impl::put(mesh.meshletVerts, data.data(), offset);
+	impl::put(mesh.meshletTris,  data.data(), offset);
+	// Written to a unique temporary then renamed (see replace())
+	return replace(dstPath, data.data(), data.size());
+}
+
+bool readMesh(const char* const srcPath, ObjMesh& mesh, size_t& numTris) {
+	mesh.reset();
+	MappedFile file;
+	if (!file.open(srcPath) || file.size() < sizeof(impl::Header)) {
+		return false;
+	}
+	impl::Header header;
+	memcpy(&header, file.data(), sizeof header);
+	if (header.magic        != O2B_MESH_MAGIC
+	 || header.version      != O2B_MESH_VERSION
+	 || header.vertBytes    != sizeof(ObjVertex)
+	 || header.lodBytes     != sizeof(ObjMesh::Lod)
+	 || header.chunkBytes   != sizeof(ObjMesh::Chunk)
+	 || header.meshletBytes != sizeof(ObjMesh::Meshlet)) {
+		return false;
+	}
+	const uint8_t* const data = file.data();
+	size_t const size = file.size();
+	size_t offset = impl::roundUp(sizeof header);
+	bool const valid = impl::get(data, size, offset, header.counts[impl::ARRAY_VERTS],         mesh.verts)
+		&& impl::get(data, size, offset, header.counts[impl::ARRAY_INDEX],         mesh.index)
+		&& impl::get(data, size, offset, header.counts[impl::ARRAY_LODS],          mesh.lods)
+		&& impl::get(data, size, offset, header.counts[impl::ARRAY_CHUNKS],        mesh.chunks)
+		&& impl::get(data, size, offset, header.counts[impl::ARRAY_SHADOW],        mesh.shadow)
+		&& impl::get(data, size, offset, header.counts[impl::ARRAY_MESHLETS],      mesh.meshlets)
+		&& impl::get(data, size, offset, header.counts[impl::ARRAY_MESHLET_VERTS], mesh.meshletVerts)
+		&& impl::get(data, size, offset, header.counts[impl::ARRAY_MESHLET_TRIS],  mesh.meshletTris)
+		&& offset == size;
+	if (!valid || mesh.verts.empty()) {
+		mesh.reset();
+		return false;
+	}
+	mesh.scale = vec3(header.scale[0], header.scale[1], header.scale[2]);
+	mesh.bias  = vec3(header.bias [0], header.bias [1], header.bias [2]);
+	numTris = static_cast<size_t>(header.numTris);
+	return true;
+}
@@ -30,6 +30,14 @@
 
 #include "mikktspace.h"
 
+/*
+ * obj2buf: allocations go through the conversion arena (see arena.h).
+ */
+void* o2b_malloc(size_t size);
+void  o2b_free(void* ptr);
+#define malloc o2b_malloc
+#define free   o2b_free
+
 #define TFALSE		0
 #define TTRUE		1
 
@@ -367,3 +367,23 @@ float utils::halfToFloat(utils::float16 const val) {
 #endif
 #endif
 }
+
+uint16_t utils::floatToUFloat(float const val, unsigned const bits) {
+	/*
+	 * Both share the half's exponent, so we drop the sign (clamping negatives
+	 * and NaNs to zero) then round off the extra mantissa bits.
+	 */
+	unsigned const shift = 15 - bits;
+	uint16_t const half  = (val > 0.0f) ? floatToHalf(val) & 0x7FFF : 0;
+	if ((half & 0x7C00) == 0x7C00) {
+		// Infinity (positive values only get here)
+		return static_cast<uint16_t>(half >> shift);
+	}
+	unsigned const maxFinite = (0x7C00 >> shift) - 1;
+	unsigned const rounded   = (half + (1U << (shift - 1))) >> shift;
+	return static_cast<uint16_t>((rounded < maxFinite) ? rounded : maxFinite);
+}
+
+float utils::ufloatToFloat(uint16_t const val, unsigned const bits) {
+	return halfToFloat(static_cast<float16>((val << (15 - bits)) & 0x7FFF));
+}
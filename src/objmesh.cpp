@@ -1,9 +1,13 @@
 #include "objmesh.h"
 
+#include <cctype>
 #include <cfloat>
+#include <cstdint>
 #include <cstdio>
 #include <cstring>
 
+#include <algorithm>
+
 #include "meshoptimizer.h"
 
 /**
@@ -22,7 +26,7 @@
  */
 namespace impl {
 /*
- * Performs work common to both the \c .obj and FBX mesh extraction (tangent
+ * Performs work common to the \c .obj, FBX, glTF and PLY mesh extraction (tangent
  * generation, then creating vertex and index buffers).
  *
  * \note The vertices are triangles here, with triangulation having been
@@ -108,9 +112,10 @@ void extract(fastObjMesh* const obj, bool const genTans, bool const flipG, ObjMe
  * \param[in] obj valid \c fast_obj content
  * \param[in] genTans \c true if tangents should be generated
  * \param[in] flipG generate tangents for a flipped green channel (by negating the texture's y-axis)
+ * \param[in] uv2 \c true if the second UV channel should be kept (otherwise it's zeroed)
  * \param[out] mesh destination for the \c .obj file content
  */
-void extract(ufbx_mesh* const fbx, bool const genTans, bool const flipG, ObjMesh& mesh) {
+void extract(ufbx_mesh* const fbx, bool const genTans, bool const flipG, bool const uv2, ObjMesh& mesh) {
 	/*
 	 * This follows the same pattern as the fast_obj variant, create a single
 	 * mesh and triangulate it with fans in *exactly* the same way.
@@ -135,6 +140,9 @@ void extract(ufbx_mesh* const fbx, bool const genTans, bool const flipG, ObjMesh
 				}
 			}
 			verts.emplace_back(fbx, vertBase + vert);
+			if (!uv2) {
+				verts.back().tex1 = 0.0f;
+			}
 			if (vert > 2) {
 				if ((vert & 1) != 0) {
 					verts.push_back(verts[polyStart]);
@@ -166,6 +174,173 @@ void extract(ufbx_mesh* const fbx, bool const genTans, bool const flipG, ObjMesh
 	}
 	postExtract(verts, genTans, flipG, mesh);
 }
+/**
+ * Extracts the triangles from a glTF file's primitives, expanding any strips
+ * and fans (see \c #postExtract()). glTF's tangents are MikkTSpace so are
+ * kept, unless any primitive is missing them, when they're all regenerated.
+ *
+ * \param[in] gltf the glTF file's first mesh
+ * \param[in] genTans \c true if tangents should be generated
+ * \param[in] flipG generate tangents for a flipped green channel (by negating the texture's y-axis)
+ * \param[in] uv2 \c true if the second UV channel is extracted (otherwise it's zeroed)
+ * \param[out] mesh destination for the indexed mesh content
+ */
+void extract(const GltfFile& gltf, bool const genTans, bool const flipG, bool const uv2, ObjMesh& mesh) {
+	size_t maxVerts = 0;
+	bool hasTans = true;
+	for (std::vector<GltfFile::Primitive>::const_iterator it = gltf.prims.begin(); it != gltf.prims.end(); ++it) {
+		size_t const count = (it->index.valid()) ? it->index.count : it->posn.count;
+		if (it->mode == GltfFile::TRIANGLES) {
+			maxVerts += count / 3 * 3;
+		} else if (count > 2) {
+			maxVerts += (count - 2) * 3;
+		}
+		hasTans &= it->tans.valid();
+	}
+	ObjVertex::Container verts;
+	verts.reserve(maxVerts);
+	for (std::vector<GltfFile::Primitive>::const_iterator it = gltf.prims.begin(); it != gltf.prims.end(); ++it) {
+		size_t const count = (it->index.valid()) ? it->index.count : it->posn.count;
+		size_t const tris  = (it->mode == GltfFile::TRIANGLES) ? count / 3 : ((count > 2) ? count - 2 : 0);
+		for (size_t tri = 0; tri < tris; tri++) {
+			// Corners of each triangle (with strips alternating their winding)
+			size_t corner[3];
+			switch (it->mode) {
+			case GltfFile::TRIANGLE_STRIP:
+				corner[0] = tri;
+				corner[1] = tri + 1 + (tri & 1);
+				corner[2] = tri + 2 - (tri & 1);
+				break;
+			case GltfFile::TRIANGLE_FAN:
+				corner[0] = tri + 1;
+				corner[1] = tri + 2;
+				corner[2] = 0;
+				break;
+			default:
+				corner[0] = tri * 3 + 0;
+				corner[1] = tri * 3 + 1;
+				corner[2] = tri * 3 + 2;
+			}
+			for (unsigned n = 0; n < 3; n++) {
+				size_t const idx = (it->index.valid()) ? it->index.index(corner[n]) : corner[n];
+				verts.push_back(ObjVertex(*it, idx));
+				ObjVertex& vert = verts.back();
+				if (!uv2) {
+					vert.tex1 = 0.0f;
+				}
+				if (!genTans || !hasTans) {
+					// Either unwanted or regenerated (so cleared to not prevent merging)
+					vert.tans = 0.0f;
+					vert.btan = 0.0f;
+					vert.sign = 0.0f;
+				} else if (flipG) {
+					vert.btan = vert.btan * -1.0f;
+					vert.sign = -vert.sign;
+				}
+			}
+		}
+	}
+	postExtract(verts, genTans && !hasTans, flipG, mesh);
+}
+/**
+ * Extracts the PLY file's triangulated faces (see \c #postExtract()).
+ *
+ * \param[in] ply the PLY file
+ * \param[in] genTans \c true if tangents should be generated
+ * \param[in] flipG generate tangents for a flipped green channel (by negating the texture's y-axis)
+ * \param[out] mesh destination for the indexed mesh content
+ */
+void extract(const PlyFile& ply, bool const genTans, bool const flipG, ObjMesh& mesh) {
+	ObjVertex::Container verts;
+	verts.reserve(ply.tris.size());
+	for (std::vector<uint32_t>::const_iterator it = ply.tris.begin(); it != ply.tris.end(); ++it) {
+		verts.push_back(ObjVertex(ply, *it));
+	}
+	postExtract(verts, genTans, flipG, mesh);
+}
+/**
+ * Helper to test a filename's extension (ignoring the case).
+ *
+ * \param[in] path filename to test
+ * \param[in] ext extension (including the dot, in lowercase)
+ * \return \c true if \a path ends with \a ext
+ */
+bool hasExtension(const char* const path, const char* const ext) {
+	size_t const pathLen = strlen(path);
+	size_t const extLen  = strlen(ext);
+	if (pathLen <= extLen) {
+		return false;
+	}
+	for (size_t n = 0; n < extLen; n++) {
+		if (tolower(static_cast<unsigned char>(path[pathLen - extLen + n])) != ext[n]) {
+			return false;
+		}
+	}
+	return true;
+}
+/**
+ * ufbx allocation callback (see \c Arena#allocate()).
+ *
+ * \param[in] size number of bytes to allocate
+ * \return start of the allocation
+ */
+void* ufbxAlloc(void*, size_t size) {
+	return Arena::allocate(size);
+}
+/**
+ * ufbx reallocation callback (see \c Arena#reallocate()).
+ *
+ * \param[in] ptr previous allocation
+ * \param[in] size new number of bytes
+ * \return start of the resized allocation
+ */
+void* ufbxRealloc(void*, void* ptr, size_t, size_t size) {
+	return Arena::reallocate(ptr, size);
+}
+/**
+ * ufbx free callback (see \c Arena#release()).
+ *
+ * \param[in] ptr allocation to free
+ */
+void ufbxFree(void*, void* ptr, size_t) {
+	Arena::release(ptr);
+}
+/**
+ * Calculates the scale and bias to normalise the positions between \c -1 and
+ * \c 1 (see \c ObjMesh#normalise()).
+ *
+ * \param[in] verts vertices to normalise
+ * \param[in] uniform \c true if the same scale should be applied to all axes (otherwise a per-axis scale is applied)
+ * \param[in] unbiased  \c true if the origin should be maintained at zero (otherwise a bias is applied to make the most of the normalised range)
+ * \param[out] scale destination for the mesh scale
+ * \param[out] bias destination for the mesh bias (zero if \a unbiased)
+ */
+void scaleBias(const ObjVertex::Container& verts, bool const uniform, bool const unbiased, vec3& scale, vec3& bias) {
+	// Get min and max for each component
+	vec3 minPosn({ FLT_MAX,  FLT_MAX,  FLT_MAX});
+	vec3 maxPosn({-FLT_MAX, -FLT_MAX, -FLT_MAX});
+	for (ObjVertex::Container::const_iterator it = verts.begin(); it != verts.end(); ++it) {
+		minPosn = vec3::min(minPosn, it->posn);
+		maxPosn = vec3::max(maxPosn, it->posn);
+	}
+	// Which gives the global mesh scale and offset
+	scale = (maxPosn - minPosn);
+	if (!unbiased) {
+		scale = scale / 2.0f;
+	}
+	// Clamp scale so we don't divide-by-zero on 2D meshes
+	scale = vec3::max(scale, vec3(O2B_SMALL_VERT_POS, O2B_SMALL_VERT_POS, O2B_SMALL_VERT_POS));
+	if (uniform) {
+		// Uniform needs to be max(), otherwise the verts could be clamped
+		scale = std::max(std::max(scale.x, scale.y), scale.z);
+	}
+	// Optionally bias to make the most of the range
+	if (!unbiased) {
+		bias  = (maxPosn + minPosn) / 2.0f;
+	} else {
+		bias  = 0.0f;
+	}
+}
 }
 
 //*****************************************************************************/
@@ -173,11 +348,17 @@ void extract(ufbx_mesh* const fbx, bool const genTans, bool const flipG, ObjMesh
 void ObjMesh::reset() {
 	verts.clear();
 	index.clear();
+	lods.clear();
+	chunks.clear();
+	shadow.clear();
+	meshlets.clear();
+	meshletVerts.clear();
+	meshletTris.clear();
 	scale = 1.0f;
 	bias  = 0.0f;
 }
 
-bool ObjMesh::load(const char* const srcPath, bool const genTans, bool const flipG) {
+bool ObjMesh::load(const char* const srcPath, bool const genTans, bool const flipG, bool const uv2) {
 	bool loaded = false;
 	reset();
 	if (srcPath) {
@@ -194,6 +375,13 @@ bool ObjMesh::load(const char* const srcPath, bool const genTans, bool const fli
 				opts.ignore_animation   = true;
 				opts.ignore_embedded    = true;
 				opts.skip_skin_vertices = true;
+				// Allocations go through the conversion arena
+				opts.temp_allocator.allocator.alloc_fn     = impl::ufbxAlloc;
+				opts.temp_allocator.allocator.realloc_fn   = impl::ufbxRealloc;
+				opts.temp_allocator.allocator.free_fn      = impl::ufbxFree;
+				opts.result_allocator.allocator.alloc_fn   = impl::ufbxAlloc;
+				opts.result_allocator.allocator.realloc_fn = impl::ufbxRealloc;
+				opts.result_allocator.allocator.free_fn    = impl::ufbxFree;
 				if (ufbx_scene* scene = ufbx_load_file(srcPath, &opts, NULL)) {
 					for (size_t n = 0; n < scene->nodes.count; n++) {
 						ufbx_node* node = scene->nodes.data[n];
@@ -202,7 +390,7 @@ bool ObjMesh::load(const char* const srcPath, bool const genTans, bool const fli
 							 * We found the first valid mesh, extract the data
 							 * then stop processing.
 							 */
-							impl::extract(node->mesh, genTans, flipG, *this);
+							impl::extract(node->mesh, genTans, flipG, uv2, *this);
 							loaded = true;
 							break;
 						}
@@ -211,7 +399,32 @@ bool ObjMesh::load(const char* const srcPath, bool const genTans, bool const fli
 				}
 			}
 		}
-		if (!loaded) {
+		bool const gltf = impl::hasExtension(srcPath, ".glb") || impl::hasExtension(srcPath, ".gltf");
+		if (gltf) {
+			/*
+			 * glTF, taking the first mesh with triangles (the .glb's binary
+			 * chunk, or any external buffers, being mapped and read in-place).
+			 * There's no falling back to an obj since it's never text.
+			 */
+			GltfFile file;
+			if (file.open(srcPath)) {
+				impl::extract(file, genTans, flipG, uv2, *this);
+				loaded = !index.empty();
+			}
+		}
+		bool const ply = impl::hasExtension(srcPath, ".ply");
+		if (ply) {
+			/*
+			 * Binary PLY (e.g. from scanners), with the vertices read in-place
+			 * from the mapped file. As with glTF, there's no falling back.
+			 */
+			PlyFile file;
+			if (file.open(srcPath)) {
+				impl::extract(file, genTans, flipG, *this);
+				loaded = !index.empty();
+			}
+		}
+		if (!loaded && !gltf && !ply) {
 			if (fastObjMesh* obj = fast_obj_read(srcPath)) {
 				/*
 				 * If fast_obj can open a file it will always return a mesh
@@ -228,41 +441,319 @@ bool ObjMesh::load(const char* const srcPath, bool const genTans, bool const fli
 	return loaded;
 }
 
-void ObjMesh::optimise() {
-	meshopt_optimizeVertexCache(index.data(), index.data(), index.size(), verts.size());
-	meshopt_optimizeOverdraw   (index.data(), index.data(), index.size(), verts[0].posn, verts.size(), sizeof(ObjVertex), 1.01f /*allow 1% worse ACMR*/);
-	meshopt_optimizeVertexFetch(verts.data(), index.data(), index.size(), verts.data(),  verts.size(), sizeof(ObjVertex));
+bool ObjMesh::dependencies(const char* const srcPath, std::vector<std::string>& paths) {
+	paths.clear();
+	if (impl::hasExtension(srcPath, ".glb") || impl::hasExtension(srcPath, ".gltf")) {
+		return GltfFile::externalPaths(srcPath, paths);
+	}
+	return true;
 }
 
-void ObjMesh::normalise(bool const uniform, bool const unbiased) {
-	// Get min and max for each component
-	vec3 minPosn({ FLT_MAX,  FLT_MAX,  FLT_MAX});
-	vec3 maxPosn({-FLT_MAX, -FLT_MAX, -FLT_MAX});
-	for (std::vector<ObjVertex>::iterator it = verts.begin(); it != verts.end(); ++it) {
-		minPosn = vec3::min(minPosn, it->posn);
-		maxPosn = vec3::max(maxPosn, it->posn);
+void ObjMesh::simplify(unsigned const count, float const ratio, float const error, bool const sloppy) {
+	lods.clear();
+	if (count == 0 || index.empty()) {
+		return;
 	}
-	// Which gives the global mesh scale and offset
-	scale = (maxPosn - minPosn);
-	if (!unbiased) {
-		scale = scale / 2.0f;
+	size_t const fullCount = index.size();
+	lods.push_back({0, fullCount, 0.0f});
+	// Errors are relative, so we store them scaled back to the mesh's units
+	float const units = meshopt_simplifyScale(verts[0].posn, verts.size(), sizeof(ObjVertex));
+	std::vector<unsigned> lod(fullCount);
+	float target = 1.0f;
+	for (unsigned n = 0; n < count; n++) {
+		target *= ratio;
+		size_t const targetCount = static_cast<size_t>(fullCount * target) / 3 * 3;
+		float lodError = 0.0f;
+		size_t lodCount;
+		if (sloppy) {
+			lodCount = meshopt_simplifySloppy(lod.data(), index.data(), fullCount, verts[0].posn, verts.size(), sizeof(ObjVertex), targetCount, error, &lodError);
+		} else {
+			lodCount = meshopt_simplify      (lod.data(), index.data(), fullCount, verts[0].posn, verts.size(), sizeof(ObjVertex), targetCount, error, 0, &lodError);
+		}
+		if (lodCount == 0 || lodCount >= lods.back().count) {
+			// No further reduction is possible within the error limit
+			break;
+		}
+		lods.push_back({index.size(), lodCount, lodError * units});
+		index.insert(index.end(), lod.begin(), lod.begin() + lodCount);
 	}
-	// Clamp scale so we don't divide-by-zero on 2D meshes
-	scale = vec3::max(scale, vec3(O2B_SMALL_VERT_POS, O2B_SMALL_VERT_POS, O2B_SMALL_VERT_POS));
-	if (uniform) {
-		// Uniform needs to be max(), otherwise the verts could be clamped
-		scale = std::max(std::max(scale.x, scale.y), scale.z);
+}
+
+void ObjMesh::buildMeshlets(unsigned const maxVerts, unsigned const maxTris, float const coneWeight) {
+	meshlets.clear();
+	meshletVerts.clear();
+	meshletTris.clear();
+	if (index.empty()) {
+		return;
 	}
-	// Optionally bias to make the most of the range
-	if (!unbiased) {
-		bias  = (maxPosn + minPosn) / 2.0f;
+	size_t const fullCount = (lods.empty()) ? index.size() : lods[0].count;
+	size_t const maxCount  = meshopt_buildMeshletsBound(fullCount, maxVerts, maxTris);
+	std::vector<meshopt_Meshlet> built(maxCount);
+	meshletVerts.resize(maxCount * maxVerts);
+	meshletTris .resize(maxCount * maxTris * 3);
+	built.resize(meshopt_buildMeshlets(built.data(), meshletVerts.data(), meshletTris.data(), index.data(), fullCount,
+		verts[0].posn, verts.size(), sizeof(ObjVertex), maxVerts, maxTris, coneWeight));
+	meshlets.resize(built.size());
+	for (size_t n = 0; n < built.size(); n++) {
+		const meshopt_Meshlet& src = built[n];
+		// Improve the locality of each meshlet's vertex and triangle order
+		meshopt_optimizeMeshlet(&meshletVerts[src.vertex_offset], &meshletTris[src.triangle_offset], src.triangle_count, src.vertex_count);
+		meshopt_Bounds const bounds = meshopt_computeMeshletBounds(&meshletVerts[src.vertex_offset], &meshletTris[src.triangle_offset],
+			src.triangle_count, verts[0].posn, verts.size(), sizeof(ObjVertex));
+		Meshlet& dst = meshlets[n];
+		dst.vertOffset = src.vertex_offset;
+		dst.trisOffset = src.triangle_offset;
+		dst.vertCount  = src.vertex_count;
+		dst.trisCount  = src.triangle_count;
+		dst.sphere.x   = bounds.center[0];
+		dst.sphere.y   = bounds.center[1];
+		dst.sphere.z   = bounds.center[2];
+		dst.sphere.w   = bounds.radius;
+		dst.coneApex   = vec3(bounds.cone_apex[0], bounds.cone_apex[1], bounds.cone_apex[2]);
+		dst.cone.x     = bounds.cone_axis[0];
+		dst.cone.y     = bounds.cone_axis[1];
+		dst.cone.z     = bounds.cone_axis[2];
+		dst.cone.w     = bounds.cone_cutoff;
+	}
+	// Trim to the end of the last meshlet (whose triangles are padded to four bytes)
+	if (!built.empty()) {
+		const meshopt_Meshlet& last = built.back();
+		meshletVerts.resize(last.vertex_offset + last.vertex_count);
+		meshletTris .resize(last.triangle_offset + ((last.triangle_count * 3 + 3) & ~3));
+	} else {
+		meshletVerts.clear();
+		meshletTris .clear();
+	}
+}
+
+void ObjMesh::split(size_t const maxVerts) {
+	chunks.clear();
+	if (index.empty() || maxVerts < 3) {
+		return;
+	}
+	size_t const numLods = std::max<size_t>(lods.size(), 1);
+	if (verts.size() <= maxVerts) {
+		// Already fits, so one chunk per LOD sharing all the vertices
+		for (size_t n = 0; n < numLods; n++) {
+			size_t const lodFirst = (lods.empty()) ? 0 : lods[n].first;
+			size_t const lodCount = (lods.empty()) ? index.size() : lods[n].count;
+			chunks.push_back({lodFirst, lodCount, 0, verts.size()});
+		}
+		return;
+	}
+	ObjVertex::Container split;
+	std::vector<unsigned> remap(verts.size(), UINT32_MAX); // source vertex to chunk vertex
+	std::vector<unsigned> first(verts.size(), UINT32_MAX); // source vertex to first copy (for the meshlets)
+	std::vector<unsigned> added;                           // source vertices in the current chunk
+	for (size_t n = 0; n < numLods; n++) {
+		size_t const lodFirst = (lods.empty()) ? 0 : lods[n].first;
+		size_t const lodCount = (lods.empty()) ? index.size() : lods[n].count;
+		Chunk chunk = {lodFirst, 0, split.size(), 0};
+		for (size_t tri = lodFirst; tri < lodFirst + lodCount; tri += 3) {
+			size_t needed = 0;
+			for (size_t i = 0; i < 3; i++) {
+				unsigned const vert = index[tri + i];
+				if (remap[vert] == UINT32_MAX && (i < 1 || vert != index[tri]) && (i < 2 || vert != index[tri + 1])) {
+					needed++;
+				}
+			}
+			if (chunk.verts + needed > maxVerts) {
+				// Close this chunk and start the next from this triangle
+				chunks.push_back(chunk);
+				for (std::vector<unsigned>::const_iterator it = added.begin(); it != added.end(); ++it) {
+					remap[*it] = UINT32_MAX;
+				}
+				added.clear();
+				chunk = {tri, 0, split.size(), 0};
+			}
+			for (size_t i = 0; i < 3; i++) {
+				unsigned const vert = index[tri + i];
+				if (remap[vert] == UINT32_MAX) {
+					remap[vert] = static_cast<unsigned>(chunk.verts++);
+					added.push_back(vert);
+					if (first[vert] == UINT32_MAX) {
+						first[vert] = static_cast<unsigned>(split.size());
+					}
+					split.push_back(verts[vert]);
+				}
+				index[tri + i] = remap[vert];
+			}
+			chunk.count += 3;
+		}
+		chunks.push_back(chunk);
+		for (std::vector<unsigned>::const_iterator it = added.begin(); it != added.end(); ++it) {
+			remap[*it] = UINT32_MAX;
+		}
+		added.clear();
+	}
+	// Meshlets were built from the full detail, which always has the first copies
+	for (std::vector<unsigned>::iterator it = meshletVerts.begin(); it != meshletVerts.end(); ++it) {
+		*it = first[*it];
+	}
+	verts.swap(split);
+}
+
+void ObjMesh::generateShadow() {
+	size_t const fullCount = (lods.empty()) ? index.size() : lods[0].count;
+	shadow.resize(fullCount);
+	if (fullCount) {
+		meshopt_generateShadowIndexBuffer(shadow.data(), index.data(), fullCount, verts[0].posn, verts.size(), sizeof verts[0].posn, sizeof(ObjVertex));
+	}
+}
+
+void ObjMesh::optimiseShadow(unsigned const cacheSize) {
+	if (cacheSize) {
+		meshopt_optimizeVertexCacheFifo(shadow.data(), shadow.data(), shadow.size(), verts.size(), cacheSize);
+	} else {
+		meshopt_optimizeVertexCache(shadow.data(), shadow.data(), shadow.size(), verts.size());
+	}
+}
+
+void ObjMesh::optimise(bool const strips) {
+	optimiseVertexCache(strips);
+	optimiseOverdraw();
+	optimiseVertexFetch();
+}
+
+void ObjMesh::optimiseVertexCache(bool const strips) {
+	size_t const numLods = std::max<size_t>(lods.size(), 1);
+	for (size_t n = 0; n < numLods; n++) {
+		unsigned* const lodIndex = index.data() + ((lods.empty()) ? 0 : lods[n].first);
+		size_t    const lodCount = (lods.empty()) ? index.size() : lods[n].count;
+		if (strips) {
+			meshopt_optimizeVertexCacheStrip(lodIndex, lodIndex, lodCount, verts.size());
+		} else {
+			meshopt_optimizeVertexCache(lodIndex, lodIndex, lodCount, verts.size());
+		}
+	}
+}
+
+void ObjMesh::optimiseVertexCacheFifo(unsigned const cacheSize) {
+	size_t const numLods = std::max<size_t>(lods.size(), 1);
+	for (size_t n = 0; n < numLods; n++) {
+		unsigned* const lodIndex = index.data() + ((lods.empty()) ? 0 : lods[n].first);
+		size_t    const lodCount = (lods.empty()) ? index.size() : lods[n].count;
+		meshopt_optimizeVertexCacheFifo(lodIndex, lodIndex, lodCount, verts.size(), cacheSize);
 	}
+}
+
+void ObjMesh::optimiseOverdraw(float const threshold) {
+	size_t const numLods = std::max<size_t>(lods.size(), 1);
+	for (size_t n = 0; n < numLods; n++) {
+		unsigned* const lodIndex = index.data() + ((lods.empty()) ? 0 : lods[n].first);
+		size_t    const lodCount = (lods.empty()) ? index.size() : lods[n].count;
+		meshopt_optimizeOverdraw(lodIndex, lodIndex, lodCount, verts[0].posn, verts.size(), sizeof(ObjVertex), threshold);
+	}
+}
+
+void ObjMesh::optimiseVertexFetch() {
+	meshopt_optimizeVertexFetch(verts.data(), index.data(), index.size(), verts.data(),  verts.size(), sizeof(ObjVertex));
+}
+
+ObjMesh::Stats ObjMesh::analyse(unsigned const cacheSize, unsigned const vertexSize) const {
+	Stats stats = {};
+	if (!index.empty()) {
+		size_t const fullCount = (lods.empty()) ? index.size() : lods[0].count;
+		meshopt_VertexCacheStatistics const vcache = meshopt_analyzeVertexCache(index.data(), fullCount, verts.size(), cacheSize, 0, 0);
+		meshopt_OverdrawStatistics    const ovdraw = meshopt_analyzeOverdraw   (index.data(), fullCount, verts[0].posn, verts.size(), sizeof(ObjVertex));
+		meshopt_VertexFetchStatistics const vfetch = meshopt_analyzeVertexFetch(index.data(), fullCount, verts.size(), vertexSize);
+		stats.acmr      = vcache.acmr;
+		stats.atvr      = vcache.atvr;
+		stats.overdraw  = ovdraw.overdraw;
+		stats.overfetch = vfetch.overfetch;
+	}
+	return stats;
+}
+
+void ObjMesh::stripify(unsigned const restart) {
+	std::vector<unsigned> strips;
+	std::vector<unsigned> lod(meshopt_stripifyBound(index.size()));
+	if (!chunks.empty()) {
+		/*
+		 * Each chunk is its own strip (with its own base vertex), and since
+		 * chunks never span LODs each LOD becomes the run of its chunks.
+		 */
+		std::vector<Lod> const prev(lods);
+		for (std::vector<Chunk>::iterator it = chunks.begin(); it != chunks.end(); ++it) {
+			size_t const chunkEnd = it->first + it->count;
+			for (size_t n = 0; n < prev.size(); n++) {
+				if (it->first == prev[n].first) {
+					lods[n].first = strips.size();
+				}
+			}
+			size_t const numStrip = meshopt_stripify(lod.data(), index.data() + it->first, it->count, it->verts, restart);
+			it->first = strips.size();
+			it->count = numStrip;
+			strips.insert(strips.end(), lod.begin(), lod.begin() + numStrip);
+			for (size_t n = 0; n < prev.size(); n++) {
+				if (chunkEnd == prev[n].first + prev[n].count) {
+					lods[n].count = strips.size() - lods[n].first;
+				}
+			}
+		}
+		index.swap(strips);
+		return;
+	}
+	size_t const numLods = std::max<size_t>(lods.size(), 1);
+	for (size_t n = 0; n < numLods; n++) {
+		const unsigned* const lodIndex = index.data() + ((lods.empty()) ? 0 : lods[n].first);
+		size_t const lodCount = (lods.empty()) ? index.size() : lods[n].count;
+		size_t const numStrip = meshopt_stripify(lod.data(), lodIndex, lodCount, verts.size(), restart);
+		if (!lods.empty()) {
+			lods[n].first = strips.size();
+			lods[n].count = numStrip;
+		}
+		strips.insert(strips.end(), lod.begin(), lod.begin() + numStrip);
+	}
+	index.swap(strips);
+}
+
+void ObjMesh::normalise(bool const uniform, bool const unbiased) {
+	impl::scaleBias(verts, uniform, unbiased, scale, bias);
 	// Apply to each vert to normalise
-	for (std::vector<ObjVertex>::iterator it = verts.begin(); it != verts.end(); ++it) {
+	for (ObjVertex::Container::iterator it = verts.begin(); it != verts.end(); ++it) {
 		it->posn = (it->posn - bias) / scale;
 	}
 }
 
+float ObjMesh::posnError(VertexPacker::Storage const type, bool const scaled, bool const uniform, bool const unbiased, bool const legacy) const {
+	if (verts.empty()) {
+		return 0.0f;
+	}
+	// The largest extent is the unbiased, non-uniform scale (before clamping)
+	vec3 posnScale;
+	vec3 posnBias;
+	impl::scaleBias(verts, false, true, posnScale, posnBias);
+	float const extent = std::max(std::max(posnScale.x, posnScale.y), posnScale.z);
+	// Then the real scale and bias (or none if unscaled)
+	if (scaled) {
+		impl::scaleBias(verts, uniform, unbiased, posnScale, posnBias);
+	} else {
+		posnScale = 1.0f;
+		posnBias  = 0.0f;
+	}
+	float maxErr = 0.0f;
+	for (ObjVertex::Container::const_iterator it = verts.begin(); it != verts.end(); ++it) {
+		vec3 const posn = (it->posn - posnBias) / posnScale;
+		vec3 const diff = vec3(
+			posn.x - VertexPacker::roundtrip(posn.x, type, legacy),
+			posn.y - VertexPacker::roundtrip(posn.y, type, legacy),
+			posn.z - VertexPacker::roundtrip(posn.z, type, legacy)) * posnScale;
+		maxErr = std::max(maxErr, diff.len());
+	}
+	return maxErr / extent;
+}
+
+float ObjMesh::texError(VertexPacker::Storage const type, bool const second, bool const legacy) const {
+	float maxErr = 0.0f;
+	for (ObjVertex::Container::const_iterator it = verts.begin(); it != verts.end(); ++it) {
+		vec2 const& uv = (second) ? it->tex1 : it->tex0;
+		maxErr = std::max(maxErr, std::abs(uv.x - VertexPacker::roundtrip(uv.x, type, legacy)));
+		maxErr = std::max(maxErr, std::abs(uv.y - VertexPacker::roundtrip(uv.y, type, legacy)));
+	}
+	return maxErr;
+}
+
 void ObjMesh::resize(size_t const numVerts, size_t const numIndex) {
 	verts.resize(numVerts);
 	index.resize(numIndex);
@@ -213,8 +213,9 @@ namespace impl {
 /**
  * Helper to accumulate angular errors.
  *
- * \note We're not (currently) using this to look at the actual encoded error
- * when lowering the bit-depth, it's for verifying any encoding is correct.
+ * \note As well as verifying any encoding is correct, this measures the
+ * stored error when choosing types for an error budget (see \c
+ * ObjVertex#normalError()).
  */
 class Accumulator {
 public:
@@ -262,6 +263,14 @@ public:
 	void print(const char* const name) const {
 		printf("%s: mean: %0.5f, max: %0.5f (all in degrees)\n", name, sumAbs / count, maxAbs);
 	}
+	/**
+	 * Returns the maximum error.
+	 *
+	 * \return largest of the entries added (in degrees)
+	 */
+	float max() const {
+		return maxAbs;
+	}
 private:
 	float sumAbs;   /**< Absolute sum of the entries added. */
 	float maxAbs;   /**< Absolute maximum of any of the entries added. */
@@ -329,6 +338,16 @@ static vec2 roundtrip(const vec2& vec, VertexPacker::Storage const type, bool co
 		VertexPacker::roundtrip(vec.y, type, legacy, rounding)
 	);
 }
+/**
+ * \copydoc roundtrip(const vec2&,VertexPacker::Storage,bool,VertexPacker::Rounding)
+ */
+static vec3 roundtrip(const vec3& vec, VertexPacker::Storage const type, bool const legacy = false, VertexPacker::Rounding rounding = VertexPacker::ROUND_NEAREST) {
+	return vec3(
+		VertexPacker::roundtrip(vec.x, type, legacy, rounding),
+		VertexPacker::roundtrip(vec.y, type, legacy, rounding),
+		VertexPacker::roundtrip(vec.z, type, legacy, rounding)
+	);
+}
 
 //******************************* Oct Encoding ********************************/
 
@@ -472,6 +491,124 @@ vec2 encodeOct(const vec3& vec, VertexPacker::Storage type, bool const legacy =
 zeroed:
 	return bestEnc;
 }
+/**
+ * Helper to store then restore a normal vector (optionally octahedral
+ * encoded), returning the vector as it would be seen at runtime.
+ *
+ * \param[in] vec normal vector (the emphasis on this being normalised)
+ * \param[in] type conversion and byte storage
+ * \param[in] encoded \c true if the vector is octahedral encoded
+ * \param[in] legacy see \c VertexPacker::Options#OPTS_SIGNED_LEGACY
+ * \return the decoded normal vector
+ */
+vec3 decodeStored(const vec3& vec, VertexPacker::Storage type, bool const encoded, bool const legacy) {
+	if (encoded) {
+		return decodeOct(encodeOct(vec, type, legacy));
+	}
+	return roundtrip(vec, type, legacy).normalize();
+}
+
+//****************************** QTangent Encoding ****************************/
+
+/**
+ * Encodes a tangent frame as a \e QTangent, a normalised quaternion (Frey and
+ * Herzeg 2011) with the bitangent's reflection folded into its sign. The
+ * frame is first orthonormalised (Gram-Schmidt, keeping the normal) since the
+ * quaternion can only represent a rotation.
+ *
+ * \see https://www.crytek.com/download/izfrey_siggraph2011.pdf
+ *
+ * \param[in] norm normal vector
+ * \param[in] tans tangent vector
+ * \param[in] sign bitangent sign (\c -1 if the frame is reflected)
+ * \param[in] bias smallest magnitude of \c w (so that its sign survives being stored)
+ * \return encoded quaternion (with \c w negative for reflected frames)
+ */
+vec4 encodeQTangent(const vec3& norm, const vec3& tans, float const sign, float const bias) {
+	vec3 const n = norm.normalize();
+	vec3 t = (tans - n * vec3::dot(n, tans)).normalize();
+	if (t.len() == 0.0f) {
+		// Missing (or degenerate) tangents get an arbitrary perpendicular
+		t = vec3::cross(n, (std::abs(n.x) < 0.9f) ? vec3(1.0f, 0.0f, 0.0f) : vec3(0.0f, 1.0f, 0.0f)).normalize();
+	}
+	vec3 const b = vec3::cross(n, t);
+	/*
+	 * Rotation matrix with the columns T, B, N, converted to a quaternion
+	 * choosing the largest diagonal term for precision.
+	 */
+	float const trace = t.x + b.y + n.z;
+	vec4 q;
+	if (trace > 0.0f) {
+		float const s = std::sqrt(trace + 1.0f) * 2.0f;
+		q.w = 0.25f * s;
+		q.x = (b.z - n.y) / s;
+		q.y = (n.x - t.z) / s;
+		q.z = (t.y - b.x) / s;
+	} else if (t.x > b.y && t.x > n.z) {
+		float const s = std::sqrt(1.0f + t.x - b.y - n.z) * 2.0f;
+		q.w = (b.z - n.y) / s;
+		q.x = 0.25f * s;
+		q.y = (b.x + t.y) / s;
+		q.z = (n.x + t.z) / s;
+	} else if (b.y > n.z) {
+		float const s = std::sqrt(1.0f + b.y - t.x - n.z) * 2.0f;
+		q.w = (n.x - t.z) / s;
+		q.x = (b.x + t.y) / s;
+		q.y = 0.25f * s;
+		q.z = (n.y + b.z) / s;
+	} else {
+		float const s = std::sqrt(1.0f + n.z - t.x - b.y) * 2.0f;
+		q.w = (t.y - b.x) / s;
+		q.x = (n.x + t.z) / s;
+		q.y = (n.y + b.z) / s;
+		q.z = 0.25f * s;
+	}
+	// Normalise, with a positive w (q and -q being the same rotation)
+	float len = std::sqrt(q.x * q.x + q.y * q.y + q.z * q.z + q.w * q.w);
+	if (q.w < 0.0f) {
+		len = -len;
+	}
+	vec3 xyz = vec3(q.x, q.y, q.z) / len;
+	float  w = q.w / len;
+	if (w < bias) {
+		/*
+		 * Too small a w would store as zero (which has no sign) so it's
+		 * raised to the bias, scaling the rest to keep unit length.
+		 */
+		w = bias;
+		float const xyzLen = xyz.len();
+		if (xyzLen > 0.0f) {
+			xyz = xyz * (std::sqrt(1.0f - bias * bias) / xyzLen);
+		}
+	}
+	if (sign < 0.0f) {
+		xyz = xyz * -1.0f;
+		w   = -w;
+	}
+	return vec4(xyz, w);
+}
+/**
+ * Performs the reverse of \c encodeQTangent(), extracting the normal and
+ * tangent from a QTangent.
+ *
+ * \note This is here for test purposes (the shader equivalent being the same
+ * two quaternion rotations).
+ *
+ * \param[in] qtan encoded quaternion
+ * \param[out] norm decoded normal
+ * \param[out] tans decoded tangent
+ */
+void decodeQTangent(const vec4& qtan, vec3& norm, vec3& tans) {
+	vec3 const q(qtan.x, qtan.y, qtan.z);
+	float const w = qtan.w;
+	// Rotating the Z and X axes: v + 2w(q x v) + 2(q x (q x v))
+	vec3 const z(0.0f, 0.0f, 1.0f);
+	vec3 const x(1.0f, 0.0f, 0.0f);
+	vec3 const qz = vec3::cross(q, z);
+	vec3 const qx = vec3::cross(q, x);
+	norm = (z + qz * (2.0f * w) + vec3::cross(q, qz) * 2.0f).normalize();
+	tans = (x + qx * (2.0f * w) + vec3::cross(q, qx) * 2.0f).normalize();
+}
 
 //*****************************************************************************/
 
@@ -551,6 +688,7 @@ ObjVertex::ObjVertex(fastObjMesh* obj, fastObjIndex* idx) {
 	norm.z = obj->normals  [idx->n * 3 + 2];
 	tans   = 0.0f;
 	btan   = 0.0f;
+	rgba   = 1.0f;
 	sign   = 0.0f;
 	norm   = norm.normalize();
 }
@@ -564,24 +702,101 @@ ObjVertex::ObjVertex(ufbx_mesh* fbx, size_t const idx) {
 	 * orientation and need correcting, and 2. so that we have the same
 	 * MikkTSpace calculations throughout).
 	 *
-	 * TODO: extract (and support) tex1 from ufbx_uv_set_list
+	 * Missing colours are opaque white (so they can be written regardless).
+	 *
   	 * TODO: if the FBX contains tangents (in the UV sets) take those?
 	 */
 	impl::copyVec(fbx->vertex_position,  idx, posn);
 	impl::copyVec(fbx->vertex_uv,        idx, tex0);
-	tex1 = 0.0f;
+	if (fbx->uv_sets.count > 1) {
+		impl::copyVec(fbx->uv_sets.data[1].vertex_uv, idx, tex1);
+	} else {
+		tex1 = 0.0f;
+	}
 	impl::copyVec(fbx->vertex_normal,    idx, norm);
-	impl::copyVec(fbx->vertex_color,     idx, rgba);
+	if (!impl::copyVec(fbx->vertex_color, idx, rgba)) {
+		rgba = 1.0f;
+	}
 	tans = 0.0f;
 	btan = 0.0f;
 	sign = 0.0f;
+}
 
-	// Hack to put tex1 into tex0 for testing
+ObjVertex::ObjVertex(const GltfFile::Primitive& prim, size_t const idx) {
 	/*
-	if (fbx->uv_sets.count > 1) {
-		impl::copyVec(fbx->uv_sets[1].vertex_uv, idx, tex0);
+	 * Missing attributes are zeroed (and colours opaque white), as with FBX.
+	 * glTF's UVs have their origin top-left, so are flipped to the bottom-left
+	 * of .obj (and FBX), which also flips the bitangents.
+	 *
+	 * Note: glTF's tangents are already MikkTSpace so can be taken as-is
+	 * (they're only kept if every primitive has them, see ObjMesh#load()).
+	 */
+	posn.x = prim.posn.get(idx, 0);
+	posn.y = prim.posn.get(idx, 1);
+	posn.z = prim.posn.get(idx, 2);
+	if (prim.tex0.valid()) {
+		tex0.x = prim.tex0.get(idx, 0);
+		tex0.y = 1.0f - prim.tex0.get(idx, 1);
+	} else {
+		tex0   = 0.0f;
+	}
+	if (prim.tex1.valid()) {
+		tex1.x = prim.tex1.get(idx, 0);
+		tex1.y = 1.0f - prim.tex1.get(idx, 1);
+	} else {
+		tex1   = 0.0f;
+	}
+	if (prim.norm.valid()) {
+		norm.x = prim.norm.get(idx, 0);
+		norm.y = prim.norm.get(idx, 1);
+		norm.z = prim.norm.get(idx, 2);
+		norm   = norm.normalize();
+	} else {
+		norm   = 0.0f;
+	}
+	if (prim.tans.valid()) {
+		tans.x = prim.tans.get(idx, 0);
+		tans.y = prim.tans.get(idx, 1);
+		tans.z = prim.tans.get(idx, 2);
+		tans   = tans.normalize();
+		sign   = (prim.tans.get(idx, 3) < 0.0f) ? 1.0f : -1.0f;
+		btan   = vec3::cross(norm, tans) * sign;
+	} else {
+		tans   = 0.0f;
+		btan   = 0.0f;
+		sign   = 0.0f;
+	}
+	if (prim.rgba.valid()) {
+		rgba.x = prim.rgba.get(idx, 0);
+		rgba.y = prim.rgba.get(idx, 1);
+		rgba.z = prim.rgba.get(idx, 2);
+		rgba.w = (prim.rgba.comps > 3) ? prim.rgba.get(idx, 3) : 1.0f;
+	} else {
+		rgba   = 1.0f;
 	}
+}
+
+ObjVertex::ObjVertex(const PlyFile& ply, size_t const idx) {
+	/*
+	 * Missing properties read as zero, except colours which are opaque white
+	 * (integer colours are normalised, float colours taken as-is).
 	 */
+	posn.x = ply.get(ply.posn[0], idx);
+	posn.y = ply.get(ply.posn[1], idx);
+	posn.z = ply.get(ply.posn[2], idx);
+	tex0.x = ply.get(ply.tex0[0], idx);
+	tex0.y = ply.get(ply.tex0[1], idx);
+	tex1   = 0.0f;
+	norm.x = ply.get(ply.norm[0], idx);
+	norm.y = ply.get(ply.norm[1], idx);
+	norm.z = ply.get(ply.norm[2], idx);
+	tans   = 0.0f;
+	btan   = 0.0f;
+	sign   = 0.0f;
+	for (unsigned n = 0; n < 4; n++) {
+		rgba[n] = (ply.rgba[n].valid()) ? ply.get(ply.rgba[n], idx, true) : 1.0f;
+	}
+	norm   = norm.normalize();
 }
 
 bool ObjVertex::generateTangents(Container& verts, bool const flipG) {
@@ -605,6 +820,72 @@ bool ObjVertex::generateTangents(Container& verts, bool const flipG) {
 	return genTangSpaceDefault(&mCtx) != 0;
 }
 
+void ObjVertex::encodeQTangents(Container& verts, VertexPacker::Storage type) {
+#ifndef NDEBUG
+	impl::Accumulator normErr;
+	impl::Accumulator tansErr;
+#endif
+	// The bias is the smallest non-zero value of the (signed normalised) type
+	float const bias = 1.0f / ((1 << (type.bytes() * 8 - 1)) - 1);
+	for (Container::iterator it = verts.begin(); it != verts.end(); ++it) {
+		vec4 const qtan = impl::encodeQTangent(it->norm, it->tans, it->sign, bias);
+	#ifndef NDEBUG
+		vec3 decNorm;
+		vec3 decTans;
+		impl::decodeQTangent(qtan, decNorm, decTans);
+		normErr.add(it->norm.normalize(), decNorm);
+		tansErr.add(it->tans.normalize(), decTans);
+	#endif
+		it->norm = qtan.xyz();
+		it->sign = qtan.w;
+		it->tans = 0.0f;
+		it->btan = 0.0f;
+	}
+#ifndef NDEBUG
+	printf("\n");
+	normErr.print("QTangent norm error");
+	tansErr.print("QTangent tans error");
+#endif
+}
+
+float ObjVertex::normalError(const Container& verts, VertexPacker::Storage norm, VertexPacker::Storage tans, bool const btan, bool const encoded, bool const legacy) {
+	impl::Accumulator err;
+	for (Container::const_iterator it = verts.begin(); it != verts.end(); ++it) {
+		err.add(it->norm, impl::decodeStored(it->norm, norm, encoded, legacy));
+		if (tans) {
+			err.add(it->tans, impl::decodeStored(it->tans, tans, encoded, legacy));
+			if (btan) {
+				err.add(it->btan, impl::decodeStored(it->btan, tans, encoded, legacy));
+			}
+		}
+	}
+	return err.max();
+}
+
+void ObjVertex::roundtripFrame(const ObjVertex& vert, VertexPacker::Storage norm, VertexPacker::Storage tans, bool const encoded, bool const qtangent, bool const btanSign, bool const legacy, vec3& decNorm, vec3& decTans, vec3& decBtan) {
+	float sign = vert.sign;
+	if (qtangent) {
+		// As encodeQTangents() (the bias being the smallest non-zero value)
+		float const bias = 1.0f / ((1 << (tans.bytes() * 8 - 1)) - 1);
+		vec4 const qtan  = impl::encodeQTangent(vert.norm, vert.tans, vert.sign, bias);
+		vec4 const rtQt(impl::roundtrip(qtan.xyz(), tans, legacy), VertexPacker::roundtrip(qtan.w, tans, legacy));
+		impl::decodeQTangent(rtQt, decNorm, decTans);
+		sign = impl::_sign_(rtQt.w);
+	} else {
+		decNorm = impl::decodeStored(vert.norm, norm, encoded, legacy);
+		if (tans) {
+			decTans = impl::decodeStored(vert.tans, tans, encoded, legacy);
+		}
+	}
+	if (tans) {
+		if (qtangent || btanSign) {
+			decBtan = vec3::cross(decNorm, decTans) * sign;
+		} else {
+			decBtan = impl::decodeStored(vert.btan, tans, encoded, legacy);
+		}
+	}
+}
+
 void ObjVertex::encodeNormals(Container& verts, VertexPacker::Storage norm, VertexPacker::Storage tans, bool const btan, bool const legacy) {
 #ifndef NDEBUG
 	impl::Accumulator normErr;
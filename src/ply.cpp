@@ -0,0 +1,430 @@
+/**
+ * \file ply.cpp
+ *
+ * \copyright 2022 Numfum GmbH
+ */
+#include "ply.h"
+
+#include <cstdio>
+#include <cstring>
+
+#include <algorithm>
+#include <string>
+
+/**
+ * \def O2B_PLY_MAX_HEADER
+ * Largest PLY header accepted (headers are a few hundred bytes, this stops a
+ * non-PLY file being scanned in its entirety).
+ */
+#ifndef O2B_PLY_MAX_HEADER
+#define O2B_PLY_MAX_HEADER (64 * 1024)
+#endif
+
+namespace impl {
+/**
+ * A property as declared in the header (scalar or list).
+ */
+struct PlyDecl {
+	std::string name;       /**< Property name. */
+	PlyFile::Type type;     /**< Scalar type (or a list's entry type). */
+	PlyFile::Type countType; /**< List count type (or \c NONE for scalars). */
+};
+/**
+ * An element as declared in the header.
+ */
+struct PlyElement {
+	std::string name;            /**< Element name (e.g. \c vertex). */
+	size_t count;                /**< Number of entries. */
+	std::vector<PlyDecl> props;  /**< Properties of each entry. */
+};
+/**
+ * Parses a property type name.
+ *
+ * \param[in] name type name (e.g. \c float or \c float32)
+ * \return the type (or \c NONE if unknown)
+ */
+PlyFile::Type parseType(const std::string& name) {
+	static const struct {
+		const char* name;
+		PlyFile::Type type;
+	} types[] = {
+		{"char",   PlyFile::INT8},    {"int8",    PlyFile::INT8},
+		{"uchar",  PlyFile::UINT8},   {"uint8",   PlyFile::UINT8},
+		{"short",  PlyFile::INT16},   {"int16",   PlyFile::INT16},
+		{"ushort", PlyFile::UINT16},  {"uint16",  PlyFile::UINT16},
+		{"int",    PlyFile::INT32},   {"int32",   PlyFile::INT32},
+		{"uint",   PlyFile::UINT32},  {"uint32",  PlyFile::UINT32},
+		{"float",  PlyFile::FLOAT32}, {"float32", PlyFile::FLOAT32},
+		{"double", PlyFile::FLOAT64}, {"float64", PlyFile::FLOAT64},
+	};
+	for (size_t n = 0; n < sizeof types / sizeof types[0]; n++) {
+		if (name == types[n].name) {
+			return types[n].type;
+		}
+	}
+	return PlyFile::NONE;
+}
+/**
+ * Bytes in a property type.
+ */
+size_t typeSize(PlyFile::Type const type) {
+	switch (type) {
+	case PlyFile::INT8:
+	case PlyFile::UINT8:
+		return 1;
+	case PlyFile::INT16:
+	case PlyFile::UINT16:
+		return 2;
+	case PlyFile::INT32:
+	case PlyFile::UINT32:
+	case PlyFile::FLOAT32:
+		return 4;
+	case PlyFile::FLOAT64:
+		return 8;
+	default:
+		return 0;
+	}
+}
+/**
+ * Helper to read an unaligned 16-bit value in either byte order (written as
+ * shifts, which compilers reduce to a plain or byte-swapping load, so there's
+ * no dependency on the host's endianness).
+ */
+inline uint16_t read16(const uint8_t* const src, bool const bigEndian) {
+	return (bigEndian)
+		? static_cast<uint16_t>((src[0] << 8) | src[1])
+		: static_cast<uint16_t>((src[1] << 8) | src[0]);
+}
+/**
+ * Helper to read an unaligned 32-bit value in either byte order.
+ */
+inline uint32_t read32(const uint8_t* const src, bool const bigEndian) {
+	return (bigEndian)
+		? (static_cast<uint32_t>(src[0]) << 24) | (static_cast<uint32_t>(src[1]) << 16) | (static_cast<uint32_t>(src[2]) << 8) | src[3]
+		: (static_cast<uint32_t>(src[3]) << 24) | (static_cast<uint32_t>(src[2]) << 16) | (static_cast<uint32_t>(src[1]) << 8) | src[0];
+}
+/**
+ * Helper to read an unaligned 64-bit value in either byte order.
+ */
+inline uint64_t read64(const uint8_t* const src, bool const bigEndian) {
+	uint64_t const hi = read32(src + ((bigEndian) ? 0 : 4), bigEndian);
+	uint64_t const lo = read32(src + ((bigEndian) ? 4 : 0), bigEndian);
+	return (hi << 32) | lo;
+}
+/**
+ * Reads a list count or index (as an unsigned integer, with negative values
+ * wrapping to be rejected as out of range).
+ *
+ * \param[in] src start of the value
+ * \param[in] type value's type (any integer)
+ * \param[in] bigEndian \c true if the value is big-endian
+ * \return the value
+ */
+uint32_t readIndex(const uint8_t* const src, PlyFile::Type const type, bool const bigEndian) {
+	switch (type) {
+	case PlyFile::INT8:
+		return static_cast<uint32_t>(static_cast<int8_t>(src[0]));
+	case PlyFile::UINT8:
+		return src[0];
+	case PlyFile::INT16:
+		return static_cast<uint32_t>(static_cast<int16_t>(read16(src, bigEndian)));
+	case PlyFile::UINT16:
+		return read16(src, bigEndian);
+	default:
+		return read32(src, bigEndian);
+	}
+}
+/**
+ * Finds a property by name.
+ *
+ * \param[in] elem element containing the property
+ * \param[in] names candidate property names (null terminated)
+ * \param[out] dst destination for the property's offset and type (\c NONE if not found, or if it's a list)
+ */
+void findProp(const PlyElement& elem, const char* const* const names, PlyFile::Property& dst) {
+	dst.offset = 0;
+	dst.type   = PlyFile::NONE;
+	for (const char* const* name = names; *name; name++) {
+		size_t offset = 0;
+		for (std::vector<PlyDecl>::const_iterator it = elem.props.begin(); it != elem.props.end(); ++it) {
+			if (it->countType == PlyFile::NONE && it->name == *name) {
+				dst.offset = offset;
+				dst.type   = it->type;
+				return;
+			}
+			offset += typeSize(it->type);
+		}
+	}
+}
+/**
+ * Calculates the size of each entry of an element with only scalar
+ * properties.
+ *
+ * \param[in] elem element to measure
+ * \return bytes per entry (or zero if the element has lists)
+ */
+size_t fixedSize(const PlyElement& elem) {
+	size_t size = 0;
+	for (std::vector<PlyDecl>::const_iterator it = elem.props.begin(); it != elem.props.end(); ++it) {
+		if (it->countType != PlyFile::NONE) {
+			return 0;
+		}
+		size += typeSize(it->type);
+	}
+	return size;
+}
+}
+
+//*****************************************************************************/
+
+PlyFile::PlyFile() {
+	reset();
+}
+
+float PlyFile::get(const Property& prop, size_t const idx, bool const norm) const {
+	const uint8_t* const src = vertData + idx * vertStride + prop.offset;
+	switch (prop.type) {
+	case INT8:
+		return (norm) ? static_cast<int8_t>(src[0]) / 127.0f : static_cast<int8_t>(src[0]);
+	case UINT8:
+		return (norm) ? src[0] / 255.0f : src[0];
+	case INT16:
+		return (norm) ? static_cast<int16_t>(impl::read16(src, bigEndian)) / 32767.0f : static_cast<int16_t>(impl::read16(src, bigEndian));
+	case UINT16:
+		return (norm) ? impl::read16(src, bigEndian) / 65535.0f : impl::read16(src, bigEndian);
+	case INT32:
+		return static_cast<float>(static_cast<int32_t>(impl::read32(src, bigEndian)));
+	case UINT32:
+		return static_cast<float>(impl::read32(src, bigEndian));
+	case FLOAT32: {
+		uint32_t const bits = impl::read32(src, bigEndian);
+		float val;
+		memcpy(&val, &bits, sizeof val);
+		return val;
+	}
+	case FLOAT64: {
+		uint64_t const bits = impl::read64(src, bigEndian);
+		double val;
+		memcpy(&val, &bits, sizeof val);
+		return static_cast<float>(val);
+	}
+	default:
+		return 0.0f;
+	}
+}
+
+bool PlyFile::open(const char* const srcPath) {
+	reset();
+	if (!file.open(srcPath)) {
+		return false;
+	}
+	const uint8_t* const data = file.data();
+	size_t const size = file.size();
+	if (size < 4 || memcmp(data, "ply", 3) != 0 || (data[3] != '\n' && data[3] != '\r')) {
+		return false;
+	}
+	/*
+	 * Parse the header line-by-line (the data then follows end_header and its
+	 * single newline).
+	 */
+	std::vector<impl::PlyElement> elems;
+	size_t next = 0;
+	bool format = false;
+	bool ended  = false;
+	while (!ended && next < size && next < O2B_PLY_MAX_HEADER) {
+		size_t end = next;
+		while (end < size && data[end] != '\n') {
+			end++;
+		}
+		std::string line(reinterpret_cast<const char*>(data + next), end - next);
+		next = std::min(end + 1, size);
+		if (!line.empty() && line[line.size() - 1] == '\r') {
+			line.resize(line.size() - 1);
+		}
+		char word[4][64] = {};
+		int const words = sscanf(line.c_str(), "%63s %63s %63s %63s", word[0], word[1], word[2], word[3]);
+		if (words <= 0) {
+			continue;
+		}
+		if (strcmp(word[0], "format") == 0 && words >= 2) {
+			if (strcmp(word[1], "binary_little_endian") == 0) {
+				bigEndian = false;
+			} else if (strcmp(word[1], "binary_big_endian") == 0) {
+				bigEndian = true;
+			} else {
+				fprintf(stderr, "Unsupported PLY format: %s (only binary is supported)\n", word[1]);
+				return false;
+			}
+			format = true;
+		} else if (strcmp(word[0], "element") == 0 && words >= 3) {
+			impl::PlyElement elem;
+			elem.name = word[1];
+			unsigned long long count = 0;
+			if (sscanf(word[2], "%llu", &count) != 1 || static_cast<size_t>(count) != count) {
+				return false;
+			}
+			elem.count = static_cast<size_t>(count);
+			elems.push_back(elem);
+		} else if (strcmp(word[0], "property") == 0 && words >= 3 && !elems.empty()) {
+			impl::PlyDecl decl;
+			if (strcmp(word[1], "list") == 0 && words >= 4) {
+				// Note: sscanf stopped at four words, the name being the fifth
+				char name[64] = {};
+				if (sscanf(line.c_str(), "%*s %*s %*s %*s %63s", name) != 1) {
+					return false;
+				}
+				decl.countType = impl::parseType(word[2]);
+				decl.type      = impl::parseType(word[3]);
+				decl.name      = name;
+				if (decl.countType == NONE || decl.countType == FLOAT32 || decl.countType == FLOAT64) {
+					return false;
+				}
+			} else {
+				decl.countType = NONE;
+				decl.type      = impl::parseType(word[1]);
+				decl.name      = word[2];
+			}
+			if (decl.type == NONE) {
+				fprintf(stderr, "Unsupported PLY property type: %s\n", line.c_str());
+				return false;
+			}
+			elems.back().props.push_back(decl);
+		} else if (strcmp(word[0], "end_header") == 0) {
+			ended = true;
+		}
+	}
+	if (!format || !ended) {
+		return false;
+	}
+	/*
+	 * Then walk the elements in order: the vertices are kept in-place, the
+	 * faces triangulated (with anything else skipped over).
+	 */
+	bool hasVerts = false;
+	for (std::vector<impl::PlyElement>::const_iterator elem = elems.begin(); elem != elems.end(); ++elem) {
+		size_t const fixed = impl::fixedSize(*elem);
+		if (elem->name == "vertex" && !hasVerts) {
+			if (fixed == 0 || elem->count > (size - next) / fixed) {
+				fprintf(stderr, "Unsupported or truncated PLY vertices\n");
+				return false;
+			}
+			static const char* const x[] = {"x", nullptr};
+			static const char* const y[] = {"y", nullptr};
+			static const char* const z[] = {"z", nullptr};
+			static const char* const nx[] = {"nx", "normal_x", nullptr};
+			static const char* const ny[] = {"ny", "normal_y", nullptr};
+			static const char* const nz[] = {"nz", "normal_z", nullptr};
+			static const char* const u[] = {"u", "s", "texture_u", "texture_s", nullptr};
+			static const char* const v[] = {"v", "t", "texture_v", "texture_t", nullptr};
+			static const char* const r[] = {"red",   "diffuse_red",   nullptr};
+			static const char* const g[] = {"green", "diffuse_green", nullptr};
+			static const char* const b[] = {"blue",  "diffuse_blue",  nullptr};
+			static const char* const a[] = {"alpha", "diffuse_alpha", nullptr};
+			impl::findProp(*elem, x,  posn[0]);
+			impl::findProp(*elem, y,  posn[1]);
+			impl::findProp(*elem, z,  posn[2]);
+			impl::findProp(*elem, nx, norm[0]);
+			impl::findProp(*elem, ny, norm[1]);
+			impl::findProp(*elem, nz, norm[2]);
+			impl::findProp(*elem, u,  tex0[0]);
+			impl::findProp(*elem, v,  tex0[1]);
+			impl::findProp(*elem, r,  rgba[0]);
+			impl::findProp(*elem, g,  rgba[1]);
+			impl::findProp(*elem, b,  rgba[2]);
+			impl::findProp(*elem, a,  rgba[3]);
+			verts      = elem->count;
+			vertData   = data + next;
+			vertStride = fixed;
+			hasVerts   = true;
+			next += elem->count * fixed;
+			continue;
+		}
+		if (fixed) {
+			if (elem->count > (size - next) / fixed) {
+				return false;
+			}
+			next += elem->count * fixed;
+			continue;
+		}
+		bool const isFace = (elem->name == "face");
+		for (size_t n = 0; n < elem->count; n++) {
+			for (std::vector<impl::PlyDecl>::const_iterator prop = elem->props.begin(); prop != elem->props.end(); ++prop) {
+				size_t const propSize = impl::typeSize(prop->type);
+				if (prop->countType == NONE) {
+					if (propSize > size - next) {
+						return false;
+					}
+					next += propSize;
+					continue;
+				}
+				size_t const countSize = impl::typeSize(prop->countType);
+				if (countSize > size - next) {
+					return false;
+				}
+				size_t const count = impl::readIndex(data + next, prop->countType, bigEndian);
+				next += countSize;
+				if (count > (size - next) / propSize) {
+					fprintf(stderr, "Truncated PLY file\n");
+					return false;
+				}
+				if (isFace && (prop->name == "vertex_indices" || prop->name == "vertex_index") && prop->type != FLOAT32 && prop->type != FLOAT64) {
+					/*
+					 * Polygons are fans as [0, 1, 2], [2, 3, 0], [0, 3, 4],
+					 * etc., the same as the .obj loader.
+					 */
+					const uint8_t* const list = data + next;
+					for (size_t vert = 2; vert < count; vert++) {
+						size_t corner[3];
+						if (vert == 2) {
+							corner[0] = 0;
+							corner[1] = 1;
+							corner[2] = 2;
+						} else if ((vert & 1) != 0) {
+							corner[0] = vert - 1;
+							corner[1] = vert;
+							corner[2] = 0;
+						} else {
+							corner[0] = 0;
+							corner[1] = vert - 1;
+							corner[2] = vert;
+						}
+						for (unsigned c = 0; c < 3; c++) {
+							tris.push_back(impl::readIndex(list + corner[c] * propSize, prop->type, bigEndian));
+						}
+					}
+				}
+				next += count * propSize;
+			}
+		}
+	}
+	if (!hasVerts || !posn[0].valid() || !posn[1].valid() || !posn[2].valid()) {
+		fprintf(stderr, "PLY file has no vertex positions\n");
+		return false;
+	}
+	for (std::vector<uint32_t>::const_iterator it = tris.begin(); it != tris.end(); ++it) {
+		if (*it >= verts) {
+			fprintf(stderr, "PLY index out of range\n");
+			return false;
+		}
+	}
+	return !tris.empty();
+}
+
+void PlyFile::reset() {
+	Property const none = {0, NONE};
+	for (unsigned n = 0; n < 4; n++) {
+		if (n < 2) {
+			tex0[n] = none;
+		}
+		if (n < 3) {
+			posn[n] = none;
+			norm[n] = none;
+		}
+		rgba[n] = none;
+	}
+	tris.clear();
+	verts      = 0;
+	vertData   = nullptr;
+	vertStride = 0;
+	bigEndian  = false;
+}
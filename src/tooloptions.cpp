@@ -9,31 +9,13 @@
 #include <cstdlib>
 #include <cstdio>
 
-/**
- * Helper to set \c ToolOptions#opts from an \c Options ordinal. E.g.:
- * \code
- *	O2B_SET_OPT(myVar, OPTS_POSITIONS_SCALE)
- * \endcode
- */
-#ifndef O2B_SET_OPT
-#define O2B_SET_OPT(var, ordinal) var |= (1 << ordinal)
-#endif
-
-/**
- * Helper to clear \c ToolOptions#opts from an \c Options ordinal. E.g.:
- * \code
- *	O2B_CLEAR_OPT(myVar, OPTS_POSITIONS_SCALE)
- * \endcode
- */
-#ifndef O2B_CLEAR_OPT
-#define O2B_CLEAR_OPT(var, ordinal) var &= ~(1 << ordinal)
-#endif
+#include <algorithm>
 
 /**
  * Helper to constrain the deserialised type to valid values.
  */
 #ifndef O2B_VALIDATE_TYPE
-#define O2B_VALIDATE_TYPE(type) (((type) <= VertexPacker::Storage::FLOAT32) ? static_cast<VertexPacker::Storage::Type>(type) : VertexPacker::Storage::FLOAT32)
+#define O2B_VALIDATE_TYPE(type) (((type) <= VertexPacker::Storage::FLOAT11_10) ? static_cast<VertexPacker::Storage::Type>(type) : VertexPacker::Storage::FLOAT32)
 #endif
 
 /**
@@ -73,12 +55,31 @@ static VertexPacker::Storage parseType(const char* const type) {
 			if (strncmp(type, "ui", 2) == 0) {
 				return VertexPacker::Storage::UINT32C;
 			}
+			if (strcmp(type, "10_10_10_2") == 0) {
+				return VertexPacker::Storage::SINT10_2N;
+			}
+			if (strcmp(type, "u10_10_10_2") == 0) {
+				return VertexPacker::Storage::UINT10_2N;
+			}
+			if (strcmp(type, "11_11_10") == 0) {
+				return VertexPacker::Storage::FLOAT11_10;
+			}
 		}
 		fprintf(stderr, "Unknown data type: %s\n", type);
 	}
 	return VertexPacker::Storage::EXCLUDE;
 }
 
+/**
+ * Command-line names of each \c ToolOptions#Profile (in order).
+ */
+static const char* const profileNames[] = {"default", "none", "fast", "strip", "max"};
+
+/**
+ * Command-line names of each \c ToolOptions#Streams (in order).
+ */
+static const char* const streamsNames[] = {"interleaved", "position", "attribute"};
+
 /**
  * Helper to help \c parseType(const char*) to extract the current argument's type.
  *
@@ -106,24 +107,37 @@ int ToolOptions::parseArgs(const char* const argv[], int const argc, bool const
 	 * filename we shortcut directly to the help).
 	 */
 	int next = 0;
+	exitOnError = cli;
+	error[0] = '\0';
 	if (cli) {
 		next++;
 	}
 	if (next < argc) {
-		while ((argc - next) > 1 && next >= 0) {
+		while ((argc - next) > 1 && next >= 0 && !error[0]) {
 			next = parseNext(argv, argc, next);
 		}
 		if (next < 0) {
 			next = -next - 1;
 		}
-		if (argv[next][0] == '-') {
-			help();
+		if (!error[0] && next < argc && argv[next][0] == '-') {
+			/*
+			 * A trailing switch is only valid if it starts a mode without
+			 * files (e.g. '--serve').
+			 */
+			next = parseNext(argv, argc, next);
+			if (mode == MODE_CONVERT) {
+				fail("Missing source file");
+			}
 		}
 	} else {
-		help();
+		if (cli) {
+			help();
+		}
+		fail("Missing source file");
 	}
 	fixUp();
-	return next;
+	// Rejected requests have no source (whatever was parsed)
+	return (error[0]) ? argc : next;
 }
 
 int ToolOptions::parseNext(const char* const argv[], int const argc, int next) {
@@ -138,8 +152,172 @@ int ToolOptions::parseNext(const char* const argv[], int const argc, int next) {
 		switch (arg[1]) {
 		case 'h': // help
 		case '?': // Window's style help
+			if (exitOnError) {
+				help();
+			}
+			fail("Unknown argument", arg);
+			break;
 		case '-': // --flags
-			help();
+			if (strcmp(arg, "--serve") == 0) {
+				mode = MODE_SERVE;
+			} else if (strcmp(arg, "--analyze") == 0) {
+				mode = MODE_ANALYZE;
+			} else if (strcmp(arg, "--vcache-size") == 0 || strcmp(arg, "--vfetch-size") == 0) {
+				if (next + 2 < argc) {
+					unsigned const val = static_cast<unsigned>(strtoul(argv[++next], nullptr, 10));
+					if (arg[3] == 'c') {
+						vcacheSize = std::min(std::max(val, 3U), 63U);
+					} else {
+						vfetchSize = val;
+					}
+				} else {
+					fail("Missing analysis parameter");
+				}
+			} else if (strcmp(arg, "--profile") == 0) {
+				if (next + 2 < argc) {
+					const char* val = argv[++next];
+					unsigned n = 0;
+					while (n <= PROFILE_MAX && strcmp(val, profileNames[n]) != 0) {
+						n++;
+					}
+					if (n <= PROFILE_MAX) {
+						profile = static_cast<Profile>(n);
+					} else {
+						fail("Unknown profile", val);
+					}
+				} else {
+					fail("Missing profile");
+				}
+			} else if (strcmp(arg, "--streams") == 0) {
+				if (next + 2 < argc) {
+					const char* val = argv[++next];
+					unsigned n = 0;
+					while (n <= STREAMS_ATTRIBUTE && strcmp(val, streamsNames[n]) != 0) {
+						n++;
+					}
+					if (n <= STREAMS_ATTRIBUTE) {
+						streams = static_cast<Streams>(n);
+					} else {
+						fail("Unknown streams", val);
+					}
+				} else {
+					fail("Missing streams");
+				}
+			} else if (strcmp(arg, "--overdraw-threshold") == 0) {
+				if (next + 2 < argc) {
+					float const val = strtof(argv[++next], nullptr);
+					overdraw = static_cast<unsigned>(std::min(std::max((val - 1.0f) * 100.0f + 0.5f, 1.0f), 31.0f));
+				} else {
+					fail("Missing overdraw threshold");
+				}
+			} else if (strcmp(arg, "--stream") == 0) {
+				stream = true;
+			} else if (strcmp(arg, "--strips") == 0) {
+				topology = TOPOLOGY_STRIP_RESTART;
+			} else if (strcmp(arg, "--strips-degenerate") == 0) {
+				topology = TOPOLOGY_STRIP_DEGENERATE;
+			} else if (strcmp(arg, "--split") == 0) {
+				split = true;
+			} else if (strcmp(arg, "--shadow") == 0) {
+				shadow = true;
+			} else if (strcmp(arg, "--v2") == 0) {
+				// The container is a metadata format, so also implies -m
+				container = true;
+				O2B_SET_OPT(opts, OPTS_WRITE_METADATA);
+			} else if (strcmp(arg, "--align") == 0) {
+				if (next + 2 < argc) {
+					// Rounded up to a power of two
+					unsigned const val = std::min(std::max(static_cast<unsigned>(strtoul(argv[++next], nullptr, 10)), 4U), 65536U);
+					align = 4;
+					while (align < val) {
+						align <<= 1;
+					}
+				} else {
+					fail("Missing alignment");
+				}
+			} else if (strcmp(arg, "--meshlets") == 0) {
+				meshlets = true;
+			} else if (strncmp(arg, "--meshlet-", 10) == 0) {
+				if (next + 2 < argc) {
+					const char* val = argv[++next];
+					if (strcmp(arg, "--meshlet-verts") == 0) {
+						meshletVerts = std::min(std::max(static_cast<unsigned>(strtoul(val, nullptr, 10)), 3U), 255U);
+					} else if (strcmp(arg, "--meshlet-tris") == 0) {
+						meshletTris  = std::min(std::max(static_cast<unsigned>(strtoul(val, nullptr, 10)), 4U), 512U) & ~3U;
+					} else if (strcmp(arg, "--meshlet-cone") == 0) {
+						meshletCone  = std::min(std::max(strtof(val, nullptr), 0.0f), 1.0f);
+					} else {
+						fail("Unknown argument", arg);
+					}
+				} else {
+					fail("Missing meshlet parameter");
+				}
+			} else if (strcmp(arg, "--lod-sloppy") == 0) {
+				lodSloppy = true;
+			} else if (strncmp(arg, "--lod", 5) == 0) {
+				if (next + 2 < argc) {
+					const char* val = argv[++next];
+					if (strcmp(arg, "--lods") == 0) {
+						lods = std::min(static_cast<unsigned>(strtoul(val, nullptr, 10)), static_cast<unsigned>(O2B_MAX_LODS));
+					} else if (strcmp(arg, "--lod-ratio") == 0) {
+						lodRatio = std::min(std::max(strtof(val, nullptr), 0.0f), 1.0f);
+					} else if (strcmp(arg, "--lod-error") == 0) {
+						lodError = std::max(strtof(val, nullptr), 0.0f);
+					} else {
+						fail("Unknown argument", arg);
+					}
+				} else {
+					fail("Missing LOD parameter");
+				}
+			} else if (strcmp(arg, "--auto-layout") == 0) {
+				autoLayout = true;
+			} else if (strncmp(arg, "--auto-", 7) == 0) {
+				if (next + 2 < argc) {
+					const char* val = argv[++next];
+					if (strcmp(arg, "--auto-posn-error") == 0) {
+						autoPosnError = std::max(strtof(val, nullptr), 0.0f);
+					} else if (strcmp(arg, "--auto-uv-error") == 0) {
+						autoTexError  = std::max(strtof(val, nullptr), 0.0f);
+					} else if (strcmp(arg, "--auto-uv-size") == 0) {
+						autoTexSize   = std::max(static_cast<unsigned>(strtoul(val, nullptr, 10)), 1U);
+					} else if (strcmp(arg, "--auto-norm-error") == 0) {
+						autoNormError = std::max(strtof(val, nullptr), 0.0f);
+					} else {
+						fail("Unknown argument", arg);
+					}
+				} else {
+					fail("Missing auto layout parameter");
+				}
+			} else if (strcmp(arg, "--errors") == 0) {
+				if (next + 2 < argc) {
+					errors = argv[++next];
+				} else {
+					fail("Missing error report");
+				}
+			} else if (strcmp(arg, "--cache") == 0) {
+				if (next + 2 < argc) {
+					cache = argv[++next];
+				} else {
+					fail("Missing cache directory");
+				}
+			} else if (strcmp(arg, "--mesh-cache") == 0) {
+				if (next + 2 < argc) {
+					meshCache = argv[++next];
+				} else {
+					fail("Missing mesh cache directory");
+				}
+			} else if (strcmp(arg, "--dict") == 0 || strcmp(arg, "--train-dict") == 0) {
+				if (next + 2 < argc) {
+					if (arg[2] == 't') {
+						mode = MODE_TRAIN_DICT;
+					}
+					dict = argv[++next];
+				} else {
+					fail("Missing dictionary");
+				}
+			} else {
+				fail("Unknown argument", arg);
+			}
 			break;
 		case 'p': // positions
 			posn = parseType(argv, argc, next);
@@ -147,8 +325,18 @@ int ToolOptions::parseNext(const char* const argv[], int const argc, int next) {
 		case 'n': // normals
 			norm = parseType(argv, argc, next);
 			break;
-		case 'u': // UVs
-			text = parseType(argv, argc, next);
+		case 'u': // UVs (or -u2 for the second channel)
+			if (strcmp(arg + 1, "u2") == 0) {
+				tex1 = parseType(argv, argc, next);
+			} else {
+				text = parseType(argv, argc, next);
+			}
+			break;
+		case 'r': // vertex colours (RGBA)
+			rgba = true;
+			break;
+		case 'q': // QTangents
+			qtangent = true;
 			break;
 		case 't': // tangents
 			tans = parseType(argv, argc, next);
@@ -196,16 +384,32 @@ int ToolOptions::parseNext(const char* const argv[], int const argc, int next) {
 			break;
 		case 'c': // shortcode
 			if (next + 2 < argc) {
-				setAllOptions(static_cast<uint32_t>(strtoul(argv[++next], nullptr, 16)));
-				fixUp();
+				/*
+				 * Up to 8 hex digits are the original shortcode, anything
+				 * above this are the extended options. A shortcode followed
+				 * by a colon and filename is an additional output instead.
+				 */
+				char* end = nullptr;
+				unsigned long long const code = strtoull(argv[++next], &end, 16);
+				if (end && end[0] == ':' && end[1]) {
+					// Validated now, rather than when the output is written
+					ToolOptions trial;
+					trial.exitOnError = exitOnError;
+					trial.setShortcode(static_cast<uint64_t>(code));
+					if (trial.error[0]) {
+						fail(trial.error);
+					}
+					Output const output = {static_cast<uint64_t>(code), end + 1};
+					outputs.push_back(output);
+				} else {
+					setShortcode(static_cast<uint64_t>(code));
+				}
 			} else {
-				fprintf(stderr, "Missing shortcode\n");
-				help();
+				fail("Missing shortcode");
 			}
 			break;
 		default:
-			fprintf(stderr, "Unknown argument: %s\n", arg);
-			help();
+			fail("Unknown argument", arg);
 		}
 		next++;
 	} else {
@@ -217,6 +421,26 @@ int ToolOptions::parseNext(const char* const argv[], int const argc, int next) {
 	return next;
 }
 
+void ToolOptions::setShortcode(uint64_t const code) {
+	setAllOptions(static_cast<uint32_t>(code));
+	setExtOptions(static_cast<uint32_t>(code >> 32));
+	fixUp();
+}
+
+void ToolOptions::fail(const char* const reason, const char* const what) {
+	if (!error[0]) {
+		if (what) {
+			snprintf(error, sizeof error, "%s: %s", reason, what);
+		} else {
+			snprintf(error, sizeof error, "%s", reason);
+		}
+	}
+	if (exitOnError) {
+		fprintf(stderr, "%s\n", error);
+		help();
+	}
+}
+
 void ToolOptions::fixUp() {
 	if (posn) {
 		if (!O2B_HAS_OPT(opts, OPTS_POSITIONS_SCALE)) {
@@ -236,6 +460,11 @@ void ToolOptions::fixUp() {
 			case VertexPacker::Storage::UINT16N:
 				posn = VertexPacker::Storage::UINT16C;
 				break;
+			case VertexPacker::Storage::SINT10_2N:
+			case VertexPacker::Storage::UINT10_2N:
+				// No clamped equivalent, so anything outside -1 to 1 would be lost
+				fail("Packed 10_10_10_2 positions need scaling (see -s)");
+				break;
 			default:
 				// no change
 				break;
@@ -244,6 +473,18 @@ void ToolOptions::fixUp() {
 	} else {
 		O2B_CLEAR_OPT(opts, OPTS_POSITIONS_SCALE);
 	}
+	if (qtangent) {
+		/*
+		 * QTangents replace the normal and tangent encoding options, and are
+		 * always stored as signed normalised bytes or shorts (the tangents
+		 * being generated for them).
+		 */
+		if (tans != VertexPacker::Storage::SINT08N) {
+			tans  = VertexPacker::Storage::SINT16N;
+		}
+		O2B_CLEAR_OPT(opts, OPTS_NORMALS_ENCODED);
+		O2B_CLEAR_OPT(opts, OPTS_BITANGENTS_SIGN);
+	}
 	if (tans) {
 		/*
 		 * Encoded normals with both normals and tangents having the same type
@@ -257,6 +498,12 @@ void ToolOptions::fixUp() {
 	} else {
 		O2B_CLEAR_OPT(opts, OPTS_BITANGENTS_SIGN);
 	}
+	/*
+	 * Unindexed strips have no restart index, so are joined with degenerates.
+	 */
+	if (!idxs && topology == TOPOLOGY_STRIP_RESTART) {
+		topology = TOPOLOGY_STRIP_DEGENERATE;
+	}
 	/*
 	 * Indices are always unsigned and clamped.
 	 */
@@ -276,8 +523,14 @@ void ToolOptions::fixUp() {
 		break;
 	case VertexPacker::Storage::FLOAT16:
 	case VertexPacker::Storage::FLOAT32:
-		fprintf(stderr, "Indices cannot be floats\n");
-		help();
+		fail("Indices cannot be floats");
+		idxs = VertexPacker::Storage::UINT32C;
+		break;
+	case VertexPacker::Storage::SINT10_2N:
+	case VertexPacker::Storage::UINT10_2N:
+	case VertexPacker::Storage::FLOAT11_10:
+		fail("Indices cannot be packed types");
+		idxs = VertexPacker::Storage::UINT32C;
 		break;
 	default:
 		// no change
@@ -287,11 +540,14 @@ void ToolOptions::fixUp() {
 
 uint32_t ToolOptions::getAllOptions() const {
 	/*
-	 * There are currently 11 user settable options, plus one reserved, which
-	 * take up the first 12 bits, then each of the storage types is packed into
-	 * 4 bits.
+	 * There are currently 11 user settable options, plus one flagging the
+	 * extended options, which take up the first 12 bits, then each of the
+	 * storage types is packed into 4 bits.
 	 */
-	uint32_t val = opts & ((1 << (OPTS_LAST_USER + 1)) - 1);
+	uint32_t val = opts & ((1 << OPTS_EXTENDED) - 1);
+	if (getExtOptions()) {
+		val |= 1 << OPTS_EXTENDED;
+	}
 	val |= posn << (OPTS_LAST_USER + 1 +  0);
 	val |= text << (OPTS_LAST_USER + 1 +  4);
 	val |= norm << (OPTS_LAST_USER + 1 +  8);
@@ -313,6 +569,86 @@ void ToolOptions::setAllOptions(uint32_t const val) {
 	idxs = O2B_VALIDATE_TYPE((val >> (OPTS_LAST_USER + 1 + 16)) & 0xF);
 }
 
+uint32_t ToolOptions::getExtOptions() const {
+	/*
+	 * The first 3 bits are the number of LODs, then 1 bit for the sloppy
+	 * simplifier, 1 bit for meshlets, 2 bits for the topology, 3 bits for the
+	 * optimisation profile, 5 bits for the overdraw threshold (only if the
+	 * profile optimises overdraw), 6 bits for the FIFO cache size (only if
+	 * the profile uses it, zero being the default of 16), 1 bit for splitting
+	 * into chunks, 2 bits for the vertex streams, 1 bit for the shadow index
+	 * buffer, 4 bits for the second UV channel's storage type, 1 bit for the
+	 * vertex colours, 1 bit for QTangents, then 1 bit for the v2 container.
+	 */
+	uint32_t val = std::min(lods, static_cast<unsigned>(O2B_MAX_LODS));
+	if (lods && lodSloppy) {
+		val |= 1 << 3;
+	}
+	if (meshlets) {
+		val |= 1 << 4;
+	}
+	val |= (topology & 0x3) << 5;
+	val |= (profile  & 0x7) << 7;
+	switch (profile) {
+	case PROFILE_NONE:
+		break;
+	case PROFILE_FAST:
+		if (vcacheSize != 16) {
+			val |= (vcacheSize & 0x3F) << 15;
+		}
+		break;
+	default:
+		val |= (overdraw & 0x1F) << 10;
+	}
+	if (split) {
+		val |= 1 << 21;
+	}
+	val |= (streams & 0x3) << 22;
+	if (shadow) {
+		val |= 1 << 24;
+	}
+	val |= (tex1 & 0xF) << 25;
+	if (rgba) {
+		val |= 1 << 29;
+	}
+	if (qtangent) {
+		val |= 1 << 30;
+	}
+	if (container) {
+		val |= 1U << 31;
+	}
+	return val;
+}
+
+void ToolOptions::setExtOptions(uint32_t const val) {
+	lods      =  val & 0x7;
+	lodSloppy = (val & (1 << 3)) != 0;
+	meshlets  = (val & (1 << 4)) != 0;
+	topology  = static_cast<Topology>(std::min((val >> 5) & 0x3, static_cast<uint32_t>(TOPOLOGY_STRIP_DEGENERATE)));
+	profile   = static_cast<Profile> (std::min((val >> 7) & 0x7, static_cast<uint32_t>(PROFILE_MAX)));
+	overdraw  = (val >> 10) & 0x1F;
+	split     = (val & (1 << 21)) != 0;
+	streams   = static_cast<Streams>(std::min((val >> 22) & 0x3, static_cast<uint32_t>(STREAMS_ATTRIBUTE)));
+	shadow    = (val & (1 << 24)) != 0;
+	tex1      = O2B_VALIDATE_TYPE((val >> 25) & 0xF);
+	rgba      = (val & (1 << 29)) != 0;
+	qtangent  = (val & (1 << 30)) != 0;
+	container = (val & (1U << 31)) != 0;
+	if (uint32_t const fifo = (val >> 15) & 0x3F) {
+		vcacheSize = std::max(fifo, 3U);
+	} else {
+		vcacheSize = 16;
+	}
+}
+
+float ToolOptions::getOverdrawThreshold() const {
+	unsigned percent = overdraw;
+	if (!percent) {
+		percent = (profile == PROFILE_MAX) ? 5 : 1;
+	}
+	return 1.0f + percent / 100.0f;
+}
+
 void ToolOptions::dump() const {
 	printf("Positions:   %s",   posn.toString());
 	if (O2B_HAS_OPT(opts, OPTS_POSITIONS_SCALE)) {
@@ -334,13 +670,21 @@ void ToolOptions::dump() const {
 	}
 	printf("\n");
 	printf("Texture UVs: %s\n", text.toString());
-	printf("Normals:     %s",   norm.toString());
+	if (tex1) {
+		printf("Second UVs:  %s\n", tex1.toString());
+	}
+	if (rgba) {
+		printf("Colours:     %s (normalised RGBA)\n", VertexPacker::Storage(VertexPacker::Storage::UINT08N).toString());
+	}
+	printf("Normals:     %s",   (qtangent) ? "in the QTangent" : norm.toString());
 	if (norm && O2B_HAS_OPT(opts, OPTS_NORMALS_ENCODED)) {
 		printf(" (octahedral encoded)");
 	}
 	printf("\n");
 	printf("Tangents:    %s",   tans.toString());
-	if (tans) {
+	if (qtangent) {
+		printf(" (QTangent with the normals and bitangent sign)");
+	} else if (tans) {
 		bool flip = O2B_HAS_OPT(opts, OPTS_TANGENTS_FLIP_G);
 		bool pack = O2B_HAS_OPT(opts, OPTS_TANGENTS_PACKED);
 		bool sign = O2B_HAS_OPT(opts, OPTS_BITANGENTS_SIGN);
@@ -359,13 +703,70 @@ void ToolOptions::dump() const {
 		}
 	}
 	printf("\n");
-	printf("Indices:     %s\n", idxs.toString());
-	printf("Metadata:    %s\n", O2B_HAS_OPT(opts, OPTS_WRITE_METADATA) ? "yes"    : "no (raw)");
+	printf("Indices:     %s",   idxs.toString());
+	switch (topology) {
+	case TOPOLOGY_STRIP_RESTART:
+		printf(" (strips with primitive restart)");
+		break;
+	case TOPOLOGY_STRIP_DEGENERATE:
+		printf(" (strips with degenerate joins)");
+		break;
+	default:
+		break;
+	}
+	printf("\n");
+	if (lods) {
+		printf("LODs:        %d (%s, ratio %g, max error %g)\n", lods, (lodSloppy) ? "sloppy" : "topology preserving", lodRatio, lodError);
+	}
+	if (meshlets) {
+		printf("Meshlets:    %d verts, %d tris (cone weight %g)\n", meshletVerts, meshletTris, meshletCone);
+	}
+	if (shadow && idxs) {
+		printf("Shadow:      %s indices (position only)\n", idxs.toString());
+	}
+	if (split && idxs) {
+		// The top index is only unusable if it's the primitive restart
+		unsigned long long const maxVerts = (1ULL << (idxs.bytes() * 8)) - ((topology == TOPOLOGY_STRIP_RESTART) ? 1 : 0);
+		printf("Split:       chunks of up to %llu vertices\n", maxVerts);
+	}
+	printf("Optimise:    %s", toString(profile));
+	switch (profile) {
+	case PROFILE_NONE:
+		break;
+	case PROFILE_FAST:
+		printf(" (FIFO cache size %d)", vcacheSize);
+		break;
+	default:
+		printf(" (overdraw threshold %g)", getOverdrawThreshold());
+	}
+	printf("\n");
+	if (streams) {
+		printf("Streams:     %s\n", (streams == STREAMS_POSITION) ? "positions then interleaved" : "one per attribute");
+	}
+	printf("Metadata:    %s",   O2B_HAS_OPT(opts, OPTS_WRITE_METADATA) ? "yes"    : "no (raw)");
+	if (container && O2B_HAS_OPT(opts, OPTS_WRITE_METADATA)) {
+		printf(" (v2 container, sections aligned to %u bytes)", align);
+	}
+	printf("\n");
 	printf("Endianness:  %s\n", O2B_HAS_OPT(opts, OPTS_BIG_ENDIAN)     ? "big"    : "little");
 	printf("Signed rule: %s\n", O2B_HAS_OPT(opts, OPTS_SIGNED_LEGACY)  ? "legacy" : "modern");
-	printf("Compression: %s\n", O2B_HAS_OPT(opts, OPTS_COMPRESS_ZSTD)  ? "Zstd"   : "none");
+	printf("Compression: %s",   O2B_HAS_OPT(opts, OPTS_COMPRESS_ZSTD)  ? "Zstd"   : "none");
+	if (dict && O2B_HAS_OPT(opts, OPTS_COMPRESS_ZSTD)) {
+		printf(" (dictionary %s)", filename(dict));
+	}
+	printf("\n");
 	printf("File format: %s\n", O2B_HAS_OPT(opts, OPTS_ASCII_FILE)     ? "ASCII"  : "binary");
-	printf("(As -c code: %08X)\n", getAllOptions());
+	if (cache) {
+		printf("Cache dir:   %s\n", cache);
+	}
+	if (meshCache) {
+		printf("Mesh cache:  %s\n", meshCache);
+	}
+	if (uint32_t const ext = getExtOptions()) {
+		printf("(As -c code: %08X%08X)\n", ext, getAllOptions());
+	} else {
+		printf("(As -c code: %08X)\n", getAllOptions());
+	}
 }
 
 const char* ToolOptions::filename(const char* const path) {
@@ -382,19 +783,30 @@ const char* ToolOptions::filename(const char* const path) {
 	return path;
 }
 
+const char* ToolOptions::toString(Profile const profile) {
+	return (profile <= PROFILE_MAX) ? profileNames[profile] : "unknown";
+}
+
 void ToolOptions::help(const char* const path) {
 	const char* name = filename(path);
 	if (!name) {
 		 name = "obj2buf";
 	}
-	printf("Usage: %s [-p|u|n|t|i type] [-s|su|sz] [-o|g|b|m|e|l|z|a] in [out]\n", name);
+	printf("Usage: %s [-p|u|u2|n|t|i type] [-s|su|sz] [-o|g|b|q|r|m|e|l|z|a] in [out]\n", name);
 	printf("Usage: %s [-c shortcode] in [out]\n", name);
+	printf("Usage: %s [-c shortcode:out...] in [out]\n", name);
+	printf("Usage: %s [--cache dir] [--mesh-cache dir] --serve\n", name);
+	printf("Usage: %s --train-dict dict in [in...]\n", name);
+	printf("Usage: %s [options] --analyze in [in...]\n", name);
 	printf("\t-p vertex positions type\n");
 	printf("\t-u vertex texture UVs type\n");
+	printf("\t-u2 vertex second texture UVs type (defaulting to none)\n");
 	printf("\t-n vertex normals type\n");
 	printf("\t-t vertex tangents type (defaulting to none)\n");
+	printf("\t-r vertex colours (as normalised unsigned RGBA bytes)\n");
 	printf("\t-i index buffer type (defaulting to shorts)\n");
 	printf("\t(vertex types are byte|short|half|float|none (none emits no data))\n");
+	printf("\t(or packed 10_10_10_2|u10_10_10_2|11_11_10, with the sign in any spare w)\n");
 	printf("\t(index types are byte|short|int|none (none emits unindexed triangles))\n");
 	printf("\t-s normalises the positions to scale them in the range -1 to 1\n");
 	printf("\t-su as -s but with uniform scaling for all axes\n");
@@ -404,12 +816,46 @@ void ToolOptions::help(const char* const path) {
 	printf("\t-g tangents are generated for an inverted G-channel (e.g. match 3ds Max)\n");
 	printf("\t-b store only the sign for bitangents\n");
 	printf("\t(packing the sign if possible where any padding would normally go)\n");
+	printf("\t-q store the normals, tangents and sign as a QTangent (of the tangents type)\n");
 	printf("\t-m writes metadata describing the buffer offsets, sizes and types\n");
 	printf("\t-e writes multi-byte values in big endian order (e.g. PPC, MIPS)\n");
 	printf("\t-l use the legacy OpenGL rule for normalised signed values\n");
 	printf("\t-z compresses the output buffer using Zstandard\n");
 	printf("\t-a writes the output as ASCII hex instead of binary\n");
 	printf("\t-c hexadecimal shortcode encompassing all the options\n");
+	printf("\t-c shortcode:out adds an output (repeatable, loading the source once)\n");
+	printf("\t--lods n generates n simplified LODs (up to %d) sharing the vertices\n", O2B_MAX_LODS);
+	printf("\t--lod-ratio r target index count of each LOD (relative to the previous)\n");
+	printf("\t--lod-error e maximum LOD error (relative to the mesh size)\n");
+	printf("\t--lod-sloppy uses the faster, topology ignoring simplifier\n");
+	printf("\t--strips writes triangle strips joined by primitive restart\n");
+	printf("\t--strips-degenerate writes triangle strips joined by degenerates\n");
+	printf("\t--shadow adds a position-only index buffer (needs -m and indices)\n");
+	printf("\t--streams s vertex streams (interleaved|position|attribute)\n");
+	printf("\t--v2 writes the metadata as the v2 container (implies -m)\n");
+	printf("\t--align n alignment of each v2 section in bytes (defaulting to 16)\n");
+	printf("\t--split splits meshes too big for the index type (needs -m and indices)\n");
+	printf("\t--meshlets partitions the mesh into meshlets (needs -m and indices)\n");
+	printf("\t--meshlet-verts n maximum vertices per meshlet (up to 255)\n");
+	printf("\t--meshlet-tris n maximum triangles per meshlet (up to 512)\n");
+	printf("\t--meshlet-cone w weighting of the normal cones (from 0 to 1)\n");
+	printf("\t--auto-layout chooses the smallest types meeting the error budget\n");
+	printf("\t--auto-posn-error e maximum position error (relative to the mesh size)\n");
+	printf("\t--auto-uv-error t maximum UV error (in texels, defaulting to 0.5)\n");
+	printf("\t--auto-uv-size n texture size for the UV error (defaulting to 2048)\n");
+	printf("\t--auto-norm-error d maximum normal error (in degrees, defaulting to 1)\n");
+	printf("\t--profile p optimisation profile (none|fast|default|strip|max)\n");
+	printf("\t--overdraw-threshold t vertex cache loss allowed reducing overdraw (1.01-1.31)\n");
+	printf("\t--analyze reports the mesh quality before and after optimising (as JSON)\n");
+	printf("\t--vcache-size n FIFO or simulated vertex cache entries (defaulting to 16)\n");
+	printf("\t--vfetch-size n simulated bytes per vertex (defaulting to the stride)\n");
+	printf("\t--errors file writes the quantisation errors of each attribute (as JSON)\n");
+	printf("\t--cache dir reuses previous results for the same input and options\n");
+	printf("\t--mesh-cache dir reuses the processed mesh when only the encoding changes\n");
+	printf("\t--serve reads requests from stdin, one per line as 'options in [out]'\n");
+	printf("\t--stream writes the output in fixed-size chunks (bounding memory use)\n");
+	printf("\t--dict dict compresses using a trained Zstandard dictionary\n");
+	printf("\t--train-dict dict trains a dictionary from uncompressed outputs\n");
 	printf("The default is float positions, normals and UVs, as uncompressed LE binary\n");
 	exit(EXIT_FAILURE);
 }
@@ -10,6 +10,7 @@
 
 #include <cassert>
 #include <cfloat>
+#include <cstring>
 
 #include "minifloat.h"
 
@@ -19,6 +20,14 @@
  */
 #ifndef INT10_MAX
 #define INT10_MAX ((1 << (10 - 1)) - 1)
+#endif
+
+/**
+ * \def UINT10_MAX
+ * Custom limit for the components of \c VertexPacker::Storage::UINT10_2N.
+ */
+#ifndef UINT10_MAX
+#define UINT10_MAX ((1 << 10) - 1)
 #endif
 
  /**
@@ -189,8 +198,13 @@ static int32_t encode(float const val, VertexPacker::Storage const type, bool co
 		} temp = { val };
 		return temp.i;
 	}
+	case VertexPacker::Storage::SINT10_2N:
 	case VertexPacker::Storage::SINT10N:
 		return clamp<int32_t>(encodeModern<10, Round>(val), -INT10_MAX, INT10_MAX);
+	case VertexPacker::Storage::UINT10_2N:
+		return clamp<int32_t>(int32_t(Round(val * UINT10_MAX)), 0, UINT10_MAX);
+	case VertexPacker::Storage::FLOAT11_10:
+		return static_cast<int32_t>(utils::floatToUFloat(val, 11));
 	case VertexPacker::Storage::SINT23N:
 		return clamp<int32_t>(encodeModern<23, Round>(val), -INT23_MAX, INT23_MAX);
 	default:
@@ -243,8 +257,13 @@ static float decode(int32_t const val, VertexPacker::Storage const type, bool co
 		} temp = { val };
 		return temp.f;
 	}
+	case VertexPacker::Storage::SINT10_2N:
 	case VertexPacker::Storage::SINT10N:
 		return decodeModern<10>(clamp<int32_t>(val, -INT10_MAX, INT10_MAX));
+	case VertexPacker::Storage::UINT10_2N:
+		return static_cast<float>(clamp<int32_t>(val, 0, UINT10_MAX)) / UINT10_MAX;
+	case VertexPacker::Storage::FLOAT11_10:
+		return utils::ufloatToFloat(static_cast<uint16_t>(val), 11);
 	case VertexPacker::Storage::SINT23N:
 		return decodeModern<23>(clamp<int32_t>(val, -INT23_MAX, INT23_MAX));
 	default:
@@ -406,8 +425,12 @@ size_t VertexPacker::size() const {
 	return static_cast<size_t>(next - root);
 }
 
+size_t VertexPacker::remaining() const {
+	return static_cast<size_t>(over - next);
+}
+
 VertexPacker::Failed VertexPacker::add(float const data, Storage const type) {
-	if (hasFreeSpace(type)) {
+	if (hasFreeSpace(type) && !type.isPacked()) {
 		if (type) {
 			int32_t bits = encode(data, type, (opts & OPTS_SIGNED_LEGACY) != 0);
 			switch (type.bytes()) {
@@ -494,6 +517,47 @@ VertexPacker::Failed VertexPacker::add(int const data, Storage const type) {
 	return VP_FAILED;
 }
 
+VertexPacker::Failed VertexPacker::add(float const x, float const y, float const z, float const w, Storage const type) {
+	if (hasFreeSpace(type) && type.isPacked()) {
+		/*
+		 * Each component is encoded as its own type (the same as the single
+		 * component roundtrip() would), then masked and shifted into place.
+		 */
+		uint32_t bits;
+		switch (type) {
+		case Storage::SINT10_2N:
+			bits  = (encode(x, type) & 0x3FF);
+			bits |= (encode(y, type) & 0x3FF) << 10;
+			bits |= (encode(z, type) & 0x3FF) << 20;
+			bits |= static_cast<uint32_t>(clamp<int32_t>(int32_t(std::round(w)), -1, 1) & 0x3) << 30;
+			break;
+		case Storage::UINT10_2N:
+			bits  = encode(x, type);
+			bits |= encode(y, type) << 10;
+			bits |= encode(z, type) << 20;
+			bits |= static_cast<uint32_t>(clamp<int32_t>(int32_t(std::round(w * 3)), 0, 3)) << 30;
+			break;
+		default:
+			bits  = utils::floatToUFloat(x, 11);
+			bits |= utils::floatToUFloat(y, 11) << 11;
+			bits |= utils::floatToUFloat(z, 10) << 22;
+		}
+		if ((opts & OPTS_BIG_ENDIAN) == 0) {
+			*next++ = (bits >>  0) & 0xFF;
+			*next++ = (bits >>  8) & 0xFF;
+			*next++ = (bits >> 16) & 0xFF;
+			*next++ = (bits >> 24) & 0xFF;
+		} else {
+			*next++ = (bits >> 24) & 0xFF;
+			*next++ = (bits >> 16) & 0xFF;
+			*next++ = (bits >>  8) & 0xFF;
+			*next++ = (bits >>  0) & 0xFF;
+		}
+		return VP_SUCCEEDED;
+	}
+	return VP_FAILED;
+}
+
 VertexPacker::Failed VertexPacker::align(size_t const base) {
 	size_t used = size();
 	if (used >= base) {
@@ -512,6 +576,15 @@ VertexPacker::Failed VertexPacker::align(size_t const base) {
 	return VP_SUCCEEDED;
 }
 
+VertexPacker::Failed VertexPacker::copy(const void* const data, size_t const bytes) {
+	if (next + bytes <= over) {
+		memcpy(next, data, bytes);
+		next += bytes;
+		return VP_SUCCEEDED;
+	}
+	return VP_FAILED;
+}
+
 void VertexPacker::rewind() {
 	next = root;
 }